@@ -30,6 +30,8 @@ public:
     // ctor for an order
     ExecutionOrder() = default;
     ExecutionOrder(const T& _product, PricingSide _side, string _orderId, OrderType _orderType, double _price, double _visibleQuantity, double _hiddenQuantity, string _parentOrderId, bool _isChildOrder);
+    ExecutionOrder(const T& _product, PricingSide _side, string _orderId, OrderType _orderType, TickPrice _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder);
+    ExecutionOrder(ProductHandle _product, PricingSide _side, string _orderId, OrderType _orderType, TickPrice _price, long _visibleQuantity, long _hiddenQuantity, string _parentOrderId, bool _isChildOrder, int64_t _timestamp = 0);
 
     // dtor
     ~ExecutionOrder() = default;
@@ -37,6 +39,9 @@ public:
     // Get the product
     const T& GetProduct() const;
 
+    // Get the registry handle of the product
+    ProductHandle GetProductHandle() const;
+
     // Get the pricing side
     PricingSide GetSide() const;
 
@@ -49,6 +54,9 @@ public:
     // Get the price on this order
     double GetPrice() const;
 
+    // Get the tick price on this order
+    TickPrice GetTickPrice() const;
+
     // Get the visible quantity on this order
     long GetVisibleQuantity() const;
 
@@ -61,20 +69,24 @@ public:
     // Is child order?
     bool IsChildOrder() const;
 
+    // Get the event time of the order book the order was placed on, 0 if unknown
+    int64_t GetTimestamp() const;
+
     // object printer
     template<typename S>
     friend ostream& operator<<(ostream& output, const ExecutionOrder<S>& order);
 
 private:
-    T product;
+    ProductHandle product = EMPTY_PRODUCT;
     PricingSide side;
     string orderId;
     OrderType orderType;
-    double price;
+    TickPrice price;
     long visibleQuantity;
     long hiddenQuantity;
     string parentOrderId;
     bool isChildOrder;
+    int64_t timestamp = 0;
 
 };
 
@@ -82,14 +94,39 @@ template<typename T>
 ExecutionOrder<T>::ExecutionOrder(const T& _product, PricingSide _side, string _orderId, OrderType _orderType,
     double _price, double _visibleQuantity, double _hiddenQuantity,
     string _parentOrderId, bool _isChildOrder)
-    : product(_product), side(_side), orderId(move(_orderId)), orderType(_orderType), price(_price),
+    : product(ProductRegistry<T>::Instance().Intern(_product)), side(_side), orderId(move(_orderId)), orderType(_orderType), price(TickPrice::FromDouble(_price)),
     visibleQuantity(_visibleQuantity), hiddenQuantity(_hiddenQuantity), parentOrderId(move(_parentOrderId)),
     isChildOrder(_isChildOrder)
 {
 }
 
+template<typename T>
+ExecutionOrder<T>::ExecutionOrder(const T& _product, PricingSide _side, string _orderId, OrderType _orderType,
+    TickPrice _price, long _visibleQuantity, long _hiddenQuantity,
+    string _parentOrderId, bool _isChildOrder)
+    : ExecutionOrder(ProductRegistry<T>::Instance().Intern(_product), _side, move(_orderId), _orderType, _price,
+    _visibleQuantity, _hiddenQuantity, move(_parentOrderId), _isChildOrder)
+{
+}
+
+template<typename T>
+ExecutionOrder<T>::ExecutionOrder(ProductHandle _product, PricingSide _side, string _orderId, OrderType _orderType,
+    TickPrice _price, long _visibleQuantity, long _hiddenQuantity,
+    string _parentOrderId, bool _isChildOrder, int64_t _timestamp)
+    : product(_product), side(_side), orderId(move(_orderId)), orderType(_orderType), price(_price),
+    visibleQuantity(_visibleQuantity), hiddenQuantity(_hiddenQuantity), parentOrderId(move(_parentOrderId)),
+    isChildOrder(_isChildOrder), timestamp(_timestamp)
+{
+}
+
 template<typename T>
 const T& ExecutionOrder<T>::GetProduct() const
+{
+    return ProductRegistry<T>::Instance().Get(product);
+}
+
+template<typename T>
+ProductHandle ExecutionOrder<T>::GetProductHandle() const
 {
     return product;
 }
@@ -115,6 +152,12 @@ OrderType ExecutionOrder<T>::GetOrderType() const
 
 template<typename T>
 double ExecutionOrder<T>::GetPrice() const
+{
+    return price.ToDouble();
+}
+
+template<typename T>
+TickPrice ExecutionOrder<T>::GetTickPrice() const
 {
     return price;
 }
@@ -143,11 +186,17 @@ bool ExecutionOrder<T>::IsChildOrder() const
     return isChildOrder;
 }
 
+template<typename T>
+int64_t ExecutionOrder<T>::GetTimestamp() const
+{
+    return timestamp;
+}
+
 template<typename T>
 ostream& operator<<(ostream& output, const ExecutionOrder<T>& order)
 {
-    string productId = order.GetProduct().GetProductId();
-    string orderId = order.GetOrderId();
+    const string& productId = order.GetProduct().GetProductId();
+    const string& orderId = order.GetOrderId();
     string side = (order.GetSide() == BID) ? "Bid" : "Ask";
 
     string orderType;
@@ -160,7 +209,7 @@ ostream& operator<<(ostream& output, const ExecutionOrder<T>& order)
     case IOC: orderType = "IOC"; break;
     }
 
-    string price = Price2Frac(order.GetPrice());
+    string price = Price2Frac(order.GetTickPrice());
     string visibleQuantity = to_string(order.GetVisibleQuantity());
     string hiddenQuantity = to_string(order.GetHiddenQuantity());
     string parentOrderId = order.GetParentOrderId();
@@ -230,11 +279,12 @@ template<typename T>
 class AlgoExecutionService : public Service<string, AlgoExecution<T>>
 {
 private:
-  map<string, AlgoExecution<T>> algoExecutionData; // store algo execution data keyed by product identifier
+  ProductStore<AlgoExecution<T>> algoExecutionData; // store algo execution data keyed by product handle
   vector<ServiceListener<AlgoExecution<T>>*> listeners; // list of listeners to this service
   AlgoExecutionServiceListener<T>* algoexecservicelistener;
   double spread;
-  long count;
+  ProductStore<long> counts; // orders sent per product, so a sharded run alternates sides as a serial one
+  ProductStore<mt19937> idStreams; // order ID stream per product, so IDs do not depend on scheduling
 
 public:
     // ctor
@@ -244,6 +294,9 @@ public:
     
     // Get data on our service given a key
     AlgoExecution<T>& GetData(string key);
+
+    // Get data on our service given a product handle
+    AlgoExecution<T>& GetData(ProductHandle handle);
     
     // The callback that a Connector should invoke for any new or updated data
     void OnMessage(AlgoExecution<T>& data) override;
@@ -263,22 +316,24 @@ public:
 };
 
 template<typename T>
-AlgoExecutionService<T>::AlgoExecutionService() : algoexecservicelistener(new AlgoExecutionServiceListener<T>(this)), count(0)
+AlgoExecutionService<T>::AlgoExecutionService() : algoexecservicelistener(new AlgoExecutionServiceListener<T>(this))
 {
+    size_t size = ProductRegistry<T>::Instance().GetSize();
+    algoExecutionData.Reserve(size);
+    counts.Reserve(size);
+    idStreams.Reserve(size);
 }
 
 template<typename T>
 AlgoExecution<T>& AlgoExecutionService<T>::GetData(string key)
 {
-    auto it = algoExecutionData.find(key);
-    if (it != algoExecutionData.end())
-    {
-        return it->second;
-    }
-    else
-    {
-        throw std::runtime_error("Key not found");
-    }
+    return GetData(ProductRegistry<T>::Instance().GetHandle(key));
+}
+
+template<typename T>
+AlgoExecution<T>& AlgoExecutionService<T>::GetData(ProductHandle handle)
+{
+    return algoExecutionData.Get(handle);
 }
 
 /**
@@ -318,59 +373,55 @@ template<typename T>
 void AlgoExecutionService<T>::AlgoExecuteOrder(OrderBook<T>& _orderBook)
 {
     // get the order book data
-    T product = _orderBook.GetProduct();
-    string key = product.GetProductId();
-    string orderId = "Algo" + GenerateRandomId(11);
-    string parentOrderId = "AlgoParent" + GenerateRandomId(5);
+    ProductHandle product = _orderBook.GetProductHandle();
 
     // get the best bid and offer order and their corresponding price and quantity
     BidOffer bidOffer = _orderBook.BestBidOffer();
     Order bid = bidOffer.GetBidOrder();
     Order offer = bidOffer.GetOfferOrder();
-    double bidPrice = bid.GetPrice();
-    double offerPrice = offer.GetPrice();
+    TickPrice bidPrice = bid.GetTickPrice();
+    TickPrice offerPrice = offer.GetTickPrice();
     long bidQuantity = bid.GetQuantity();
     long offerQuantity = offer.GetQuantity();
 
-    PricingSide side;
-    double price;
-    long quantity;
     // only agressing when the spread is at its tightest (1/128)
-    if (offerPrice - bidPrice <= 1.0 / 128.0) {
-        // alternating between bid and offer 
-        // taking the opposite side of the book to cross the spread, i.e., market order
-        if (count % 2 == 0) {
-            side = BID;
-            price = offerPrice; // BUY order takes best ask price
-            quantity = bidQuantity;
-        }
-        else {
-            side = OFFER;
-            price = bidPrice; // SELL order takes best bid price
-            quantity = offerQuantity;
-        }
+    if ((offerPrice - bidPrice).GetTicks() > TICKS_PER_POINT / 128) {
+        return;
     }
 
-    // update the count
-    count++;
+    mt19937* ids = idStreams.Find(product);
+    if (ids == nullptr) {
+        ids = &idStreams.Put(product, ProductIdStream(product));
+    }
+    string orderId = "Algo" + GenerateRandomId(11, *ids);
+    string parentOrderId = "AlgoParent" + GenerateRandomId(5, *ids);
+
+    PricingSide side;
+    TickPrice price;
+    long quantity;
+    // alternating between bid and offer 
+    // taking the opposite side of the book to cross the spread, i.e., market order
+    if (counts[product]++ % 2 == 0) {
+        side = BID;
+        price = offerPrice; // BUY order takes best ask price
+        quantity = bidQuantity;
+    }
+    else {
+        side = OFFER;
+        price = bidPrice; // SELL order takes best bid price
+        quantity = offerQuantity;
+    }
 
     // Create the execution order
     long visibleQuantity = quantity;
     long hiddenQuantity = 0;
     bool isChildOrder = false;
     OrderType orderType = MARKET; // market order
-    ExecutionOrder<T> executionOrder(product, side, orderId, orderType, price, visibleQuantity, hiddenQuantity, parentOrderId, isChildOrder);
+    ExecutionOrder<T> executionOrder(product, side, orderId, orderType, price, visibleQuantity, hiddenQuantity, parentOrderId, isChildOrder, _orderBook.GetTimestamp());
 
-    // Create the algo execution
+    // Create the algo execution and update the algo execution store in place
     Market market = BROKERTEC;
-    AlgoExecution<T> algoExecution(executionOrder, market);
-
-    // update the algo execution map
-    if (algoExecutionData.find(key) != algoExecutionData.end()) 
-    { 
-        algoExecutionData.erase(key); 
-    }
-    algoExecutionData.insert(pair<string, AlgoExecution<T>>(key, algoExecution));
+    AlgoExecution<T>& algoExecution = algoExecutionData.Put(product, AlgoExecution<T>(executionOrder, market));
 
     // flow the data to listeners
     for (auto& l : listeners) {
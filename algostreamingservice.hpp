@@ -24,6 +24,7 @@ public:
     // ctor
     PriceStreamOrder() = default;
     PriceStreamOrder(double _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side);
+    PriceStreamOrder(TickPrice _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side);
 
     // dtor
     ~PriceStreamOrder() = default;
@@ -34,6 +35,9 @@ public:
     // Get the price on this order
     double GetPrice() const;
 
+    // Get the tick price on this order
+    TickPrice GetTickPrice() const;
+
     // Get the visible quantity on this order
     long GetVisibleQuantity() const;
 
@@ -44,7 +48,7 @@ public:
     friend ostream& operator<<(ostream& output, const PriceStreamOrder& order);
 
 private:
-  double price;
+  TickPrice price;
   long visibleQuantity;
   long hiddenQuantity;
   PricingSide side;
@@ -52,11 +56,21 @@ private:
 };
 
 PriceStreamOrder::PriceStreamOrder(double _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side):
+    price(TickPrice::FromDouble(_price)), visibleQuantity(_visibleQuantity), hiddenQuantity(_hiddenQuantity), side(_side)
+{
+}
+
+PriceStreamOrder::PriceStreamOrder(TickPrice _price, long _visibleQuantity, long _hiddenQuantity, PricingSide _side):
     price(_price), visibleQuantity(_visibleQuantity), hiddenQuantity(_hiddenQuantity), side(_side)
 {
 }
 
 double PriceStreamOrder::GetPrice() const
+{
+  return price.ToDouble();
+}
+
+TickPrice PriceStreamOrder::GetTickPrice() const
 {
   return price;
 }
@@ -78,7 +92,7 @@ PricingSide PriceStreamOrder::GetSide() const
 
 ostream& operator<<(ostream& output, const PriceStreamOrder& order)
 {
-    string _price = Price2Frac(order.GetPrice());
+    string _price = Price2Frac(order.GetTickPrice());
     string _visibleQuantity = to_string(order.GetVisibleQuantity());
     string _hiddenQuantity = to_string(order.GetHiddenQuantity());
     PricingSide side = order.GetSide();
@@ -110,6 +124,7 @@ public:
     // ctor
     PriceStream() = default; // needed for map data structure later
     PriceStream(const T &_product, const PriceStreamOrder &_bidOrder, const PriceStreamOrder &_offerOrder);
+    PriceStream(ProductHandle _product, const PriceStreamOrder &_bidOrder, const PriceStreamOrder &_offerOrder, int64_t _timestamp = 0);
 
     // dtor
     ~PriceStream() = default;
@@ -117,31 +132,50 @@ public:
     // Get the product
     const T& GetProduct() const;
 
+    // Get the registry handle of the product
+    ProductHandle GetProductHandle() const;
+
     // Get the bid order
     const PriceStreamOrder& GetBidOrder() const;
 
     // Get the offer order
     const PriceStreamOrder& GetOfferOrder() const;
 
+    // Get the event time of the price the stream was built from, 0 if unknown
+    int64_t GetTimestamp() const;
+
     // object printer
     template<typename S>
     friend ostream& operator<<(ostream& output, const PriceStream<S>& priceStream);
 
 private:
-    T product;
+    ProductHandle product = EMPTY_PRODUCT;
     PriceStreamOrder bidOrder;
     PriceStreamOrder offerOrder;
+    int64_t timestamp = 0;
 
 };
 
 template<typename T>
 PriceStream<T>::PriceStream(const T &_product, const PriceStreamOrder &_bidOrder, const PriceStreamOrder &_offerOrder) :
-  product(_product), bidOrder(_bidOrder), offerOrder(_offerOrder)
+  PriceStream(ProductRegistry<T>::Instance().Intern(_product), _bidOrder, _offerOrder)
+{
+}
+
+template<typename T>
+PriceStream<T>::PriceStream(ProductHandle _product, const PriceStreamOrder &_bidOrder, const PriceStreamOrder &_offerOrder, int64_t _timestamp) :
+  product(_product), bidOrder(_bidOrder), offerOrder(_offerOrder), timestamp(_timestamp)
 {
 }
 
 template<typename T>
 const T& PriceStream<T>::GetProduct() const
+{
+    return ProductRegistry<T>::Instance().Get(product);
+}
+
+template<typename T>
+ProductHandle PriceStream<T>::GetProductHandle() const
 {
     return product;
 }
@@ -158,13 +192,19 @@ const PriceStreamOrder& PriceStream<T>::GetOfferOrder() const
     return offerOrder;
 }
 
+template<typename T>
+int64_t PriceStream<T>::GetTimestamp() const
+{
+    return timestamp;
+}
+
 template<typename T>
 ostream& operator<<(ostream& output, const PriceStream<T>& priceStream)
 {
-    T product = priceStream.GetProduct();
-    string productId = product.GetProductId();
-    PriceStreamOrder bidOrder = priceStream.GetBidOrder();
-    PriceStreamOrder offerOrder = priceStream.GetOfferOrder();
+    const T& product = priceStream.GetProduct();
+    const string& productId = product.GetProductId();
+    const PriceStreamOrder& bidOrder = priceStream.GetBidOrder();
+    const PriceStreamOrder& offerOrder = priceStream.GetOfferOrder();
     output << productId << "," << bidOrder << "," << offerOrder;
     return output;
 }
@@ -215,10 +255,10 @@ template<typename T>
 class AlgoStreamingService : public Service<string,AlgoStream <T> >
 {
 private:
-    map<string, AlgoStream<T>> algoStreamData; // store algo stream data keyed by product identifier
+    ProductStore<AlgoStream<T>> algoStreamData; // store algo stream data keyed by product handle
     vector<ServiceListener<AlgoStream<T>>*> listeners; // list of listeners to this service
     AlgoStreamingServiceListener<T>* algostreamlistener;
-    long count;
+    ProductStore<long> counts; // streams published per product, so a sharded run alternates sizes as a serial one
 
 public:
     // ctor
@@ -229,6 +269,9 @@ public:
     
     // Get data on our service given a key
     AlgoStream<T>& GetData(string key) override;
+
+    // Get data on our service given a product handle
+    AlgoStream<T>& GetData(ProductHandle handle);
     
     // The callback that a Connector should invoke for any new or updated data
     void OnMessage(AlgoStream<T>& data) override;
@@ -244,6 +287,21 @@ public:
 
     // Publish algo streams (called by algo streaming service listener to subscribe data from pricing service)
     void PublishAlgoStream(const Price<T>& price);
+
+    // Publish the algo streams of a batch of prices to the listeners as one batch
+    void PublishAlgoStreamBatch(span<Price<T>> prices);
+
+    // Static pipeline stage (see staticpipeline.hpp): publish the algo stream of a price and return it
+    AlgoStream<T>& Apply(const Price<T>& price);
+
+    // Static pipeline stage: publish the algo streams of a batch of prices and return them
+    span<AlgoStream<T>> ApplyBatch(span<Price<T>> prices);
+
+private:
+    // Build the algo stream for a price and save it in the service
+    AlgoStream<T>& BuildAlgoStream(const Price<T>& price);
+
+    vector<AlgoStream<T>> batch; // algo streams of the batch being published
     
 };
 
@@ -251,12 +309,20 @@ template<typename T>
 AlgoStreamingService<T>::AlgoStreamingService()
 {
     algostreamlistener = new AlgoStreamingServiceListener<T>(this);
+    algoStreamData.Reserve(ProductRegistry<T>::Instance().GetSize());
+    counts.Reserve(ProductRegistry<T>::Instance().GetSize());
 }
 
 template<typename T>
 AlgoStream<T>& AlgoStreamingService<T>::GetData(string key)
 {
-    return algoStreamData[key];
+    return GetData(QueryProductHandle<T>(key));
+}
+
+template<typename T>
+AlgoStream<T>& AlgoStreamingService<T>::GetData(ProductHandle handle)
+{
+    return algoStreamData[handle];
 }
 
 /**
@@ -293,36 +359,64 @@ AlgoStreamingServiceListener<T>* AlgoStreamingService<T>::GetAlgoStreamingListen
 template<typename T>
 void AlgoStreamingService<T>::PublishAlgoStream(const Price<T>& price)
 {
-    T product = price.GetProduct();
-    string key = product.GetProductId();
-    double mid = price.GetMid();
-    double spread = price.GetBidOfferSpread();
-    double bidPrice = mid - spread/2;
-    double offerPrice = mid + spread/2;
-    // alternate visible size between 1000000 and 2000000
-    long visibleQuantity = (count % 2 == 0) ? 1000000 : 2000000;
-    // hidden size is twice the visible size
-    long hiddenQuantity = visibleQuantity * 2;
-
-    count++;
+    Apply(price);
+}
 
-    // create bid order and offer order
-    PriceStreamOrder bidOrder(bidPrice, visibleQuantity, hiddenQuantity, BID);
-    PriceStreamOrder offerOrder(offerPrice, visibleQuantity, hiddenQuantity, OFFER);
-    // create price stream
-    PriceStream<T> priceStream(product, bidOrder, offerOrder);
-    // create algo stream
-    AlgoStream<T> algoStream(priceStream);
+template<typename T>
+void AlgoStreamingService<T>::PublishAlgoStreamBatch(span<Price<T>> prices)
+{
+    ApplyBatch(prices);
+}
 
-    // update the algo stream map
-    if (algoStreamData.find(key) != algoStreamData.end()) {algoStreamData.erase(key);}
-    algoStreamData.insert(pair<string, AlgoStream<T>> (key, algoStream));
+template<typename T>
+AlgoStream<T>& AlgoStreamingService<T>::Apply(const Price<T>& price)
+{
+    AlgoStream<T>& algoStream = BuildAlgoStream(price);
 
     // notify the listeners
     for (auto& listener : listeners)
     {
     listener->ProcessAdd(algoStream);
     }
+    return algoStream;
+}
+
+template<typename T>
+span<AlgoStream<T>> AlgoStreamingService<T>::ApplyBatch(span<Price<T>> prices)
+{
+    // the stored stream of a product is overwritten by later prices in the batch, so listeners get copies
+    batch.clear();
+    for (auto& price : prices)
+    {
+        batch.push_back(BuildAlgoStream(price));
+    }
+
+    // notify the listeners
+    for (auto& listener : listeners)
+    {
+    listener->ProcessAddBatch(span<AlgoStream<T>>(batch));
+    }
+    return span<AlgoStream<T>>(batch);
+}
+
+template<typename T>
+AlgoStream<T>& AlgoStreamingService<T>::BuildAlgoStream(const Price<T>& price)
+{
+    ProductHandle product = price.GetProductHandle();
+    TickPrice bidPrice = price.GetBid();
+    TickPrice offerPrice = price.GetOffer();
+    // alternate visible size between 1000000 and 2000000
+    long visibleQuantity = (counts[product]++ % 2 == 0) ? 1000000 : 2000000;
+    // hidden size is twice the visible size
+    long hiddenQuantity = visibleQuantity * 2;
+
+    // create bid order and offer order
+    PriceStreamOrder bidOrder(bidPrice, visibleQuantity, hiddenQuantity, BID);
+    PriceStreamOrder offerOrder(offerPrice, visibleQuantity, hiddenQuantity, OFFER);
+    // create price stream
+    PriceStream<T> priceStream(product, bidOrder, offerOrder, price.GetTimestamp());
+    // create algo stream and update the algo stream store in place
+    return algoStreamData.Put(product, AlgoStream<T>(priceStream));
 }
 
 /**
@@ -347,6 +441,9 @@ public:
     
     // Listener callback to process an update event to the Service
     void ProcessUpdate(Price<T>& price) override;
+
+    // Listener callback to process a batch of add events to the Service
+    void ProcessAddBatch(span<Price<T>> prices) override;
     
 };
 
@@ -366,6 +463,12 @@ void AlgoStreamingServiceListener<T>::ProcessAdd(Price<T>& price)
     algoStreamingService->PublishAlgoStream(price);
 }
 
+template<typename T>
+void AlgoStreamingServiceListener<T>::ProcessAddBatch(span<Price<T>> prices)
+{
+    algoStreamingService->PublishAlgoStreamBatch(prices);
+}
+
 template<typename T>
 void AlgoStreamingServiceListener<T>::ProcessRemove(Price<T>& price)
 {
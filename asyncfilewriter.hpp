@@ -0,0 +1,249 @@
+// asyncfilewriter.hpp
+//
+// Purpose: 1. Defines a buffered file writer that keeps its file open and writes from a background thread.
+// 2. Producers append into a large in-memory buffer and hand it to a flush thread that writes it,
+//    so the producing service never blocks on the filesystem unless both buffers are full.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef ASYNC_FILE_WRITER_HPP
+#define ASYNC_FILE_WRITER_HPP
+
+#include <string>
+#include <string_view>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "utilities.hpp"
+
+using namespace std;
+
+// When the writer forces written data to disk with fsync
+enum FsyncPolicy { FSYNC_NEVER, FSYNC_ON_FLUSH, FSYNC_ON_CLOSE };
+
+/**
+ * Double-buffered asynchronous file writer.
+ * Write() appends to the front buffer under a short lock. When the front buffer is full the producer swaps
+ * it with the idle back buffer itself and wakes the flush thread, waiting only if the back buffer is still
+ * being written; the flush thread also swaps when the flush interval has passed, and writes the back buffer
+ * outside the lock. Several producer threads may share one writer; lines are never interleaved.
+ * A failed write is logged and kept: Flush() throws it and the destructor logs it again, so lost data is not hidden.
+ */
+class AsyncFileWriter
+{
+
+public:
+	// ctor, opens the file for appending (throws if it cannot be opened)
+	AsyncFileWriter(const string& path, FsyncPolicy _fsyncPolicy = FSYNC_NEVER, size_t _bufferSize = 1 << 20, int flushMillis = 100);
+
+	// dtor, writes everything still buffered, applies the fsync policy and closes the file
+	~AsyncFileWriter();
+
+	// a file is owned by exactly one writer
+	AsyncFileWriter(const AsyncFileWriter&) = delete;
+	AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+	// Append data to the file
+	void Write(string_view data);
+
+	// Block until everything written so far is in the file (throws if a write to the file has failed)
+	void Flush();
+
+	// Get the errno of the first failed write, 0 if every write succeeded
+	int GetError();
+
+	// Get the fsync policy
+	FsyncPolicy GetFsyncPolicy() const;
+
+private:
+	// Flush thread body
+	void Run();
+
+	// Write a whole buffer to the file, returns the errno of a failed write or 0
+	int WriteBuffer(const string& buffer);
+
+	// Keep the first error of the file and log it
+	void SetError(int _error);
+
+	string path;
+	int fd;
+	FsyncPolicy fsyncPolicy;
+	size_t bufferSize;
+	chrono::milliseconds flushInterval;
+
+	mutex lock;
+	condition_variable wakeFlusher; // signalled when the front buffer fills up or a flush is requested
+	condition_variable wakeWriters; // signalled when the back buffer has been written
+	string front; // buffer producers append to
+	string back; // buffer being written by the flush thread
+	bool writing; // the back buffer is handed to the flush thread and not yet written
+	int error; // errno of the first failed write, 0 if none
+	bool flushRequested;
+	bool running;
+	unsigned long long written; // number of buffers written, lets Flush() wait for its data
+	thread flusher;
+
+};
+
+AsyncFileWriter::AsyncFileWriter(const string& _path, FsyncPolicy _fsyncPolicy, size_t _bufferSize, int flushMillis) :
+	path(_path), fsyncPolicy(_fsyncPolicy), bufferSize(_bufferSize), flushInterval(flushMillis),
+	writing(false), error(0), flushRequested(false), running(true), written(0)
+{
+	fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Cannot open file: " + path);
+	}
+	front.reserve(bufferSize);
+	back.reserve(bufferSize);
+	flusher = thread(&AsyncFileWriter::Run, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+	{
+		lock_guard<mutex> guard(lock);
+		running = false;
+	}
+	wakeFlusher.notify_one();
+	flusher.join();
+
+	if (fsyncPolicy != FSYNC_NEVER && fsync(fd) != 0)
+	{
+		SetError(errno);
+	}
+	if (close(fd) != 0)
+	{
+		SetError(errno);
+	}
+	if (error != 0)
+	{
+		log(LogLevel::ERROR, "Closed " + path + " with data lost: " + strerror(error));
+	}
+}
+
+void AsyncFileWriter::Write(string_view data)
+{
+	unique_lock<mutex> guard(lock);
+	if (front.size() + data.size() > bufferSize && !front.empty())
+	{
+		// hand the full buffer over, waiting only if the previous one is still being written
+		wakeWriters.wait(guard, [this]() { return !writing; });
+		back.swap(front);
+		writing = true;
+		wakeFlusher.notify_one();
+	}
+	front.append(data);
+}
+
+void AsyncFileWriter::Flush()
+{
+	unique_lock<mutex> guard(lock);
+	if (front.empty() && !writing)
+	{
+		return;
+	}
+	// the data is in the file once the buffer holding it has been written
+	unsigned long long target = written + (writing ? 1 : 0) + (front.empty() ? 0 : 1);
+	flushRequested = true;
+	wakeFlusher.notify_one();
+	wakeWriters.wait(guard, [this, target]() { return written >= target; });
+	if (error != 0)
+	{
+		throw std::runtime_error("Cannot write to " + path + ": " + strerror(error));
+	}
+}
+
+int AsyncFileWriter::GetError()
+{
+	lock_guard<mutex> guard(lock);
+	return error;
+}
+
+FsyncPolicy AsyncFileWriter::GetFsyncPolicy() const
+{
+	return fsyncPolicy;
+}
+
+void AsyncFileWriter::Run()
+{
+	unique_lock<mutex> guard(lock);
+	while (true)
+	{
+		wakeFlusher.wait_for(guard, flushInterval, [this]() { return flushRequested || writing || !running; });
+
+		// a producer may have handed over a full buffer already, otherwise swap what has been written since
+		if (!writing && !front.empty())
+		{
+			back.swap(front);
+			writing = true;
+		}
+		if (!writing)
+		{
+			flushRequested = false;
+			if (!running)
+			{
+				break;
+			}
+			continue;
+		}
+
+		// write outside the lock
+		guard.unlock();
+		int result = WriteBuffer(back);
+		if (result == 0 && fsyncPolicy == FSYNC_ON_FLUSH && fsync(fd) != 0)
+		{
+			result = errno;
+		}
+		back.clear();
+
+		guard.lock();
+		if (result != 0)
+		{
+			SetError(result);
+		}
+		writing = false;
+		written++;
+		wakeWriters.notify_all();
+	}
+}
+
+int AsyncFileWriter::WriteBuffer(const string& buffer)
+{
+	const char* data = buffer.data();
+	size_t remaining = buffer.size();
+	while (remaining > 0)
+	{
+		ssize_t count = ::write(fd, data, remaining);
+		if (count < 0)
+		{
+			// interrupted writes are retried, anything else drops the rest of the buffer and is reported
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return errno;
+		}
+		data += count;
+		remaining -= static_cast<size_t>(count);
+	}
+	return 0;
+}
+
+void AsyncFileWriter::SetError(int _error)
+{
+	if (error == 0)
+	{
+		error = _error;
+		log(LogLevel::ERROR, "Cannot write to " + path + ": " + strerror(error));
+	}
+}
+
+#endif
@@ -0,0 +1,451 @@
+// asynclistener.hpp
+//
+// Purpose: 1. Defines an asynchronous edge between a service and one of its listeners.
+// 2. Events are copied into an SPSC ring buffer and replayed on the listener's own thread,
+//    optionally pinned to a CPU, so that the services on either side of the edge overlap.
+// 3. Defines a sharded edge that runs the listener on a worker pool, one strand per product.
+// 4. Defines the service wiring that links listeners synchronously, asynchronously or sharded per edge.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef ASYNC_LISTENER_HPP
+#define ASYNC_LISTENER_HPP
+
+#include <string>
+#include <vector>
+#include <set>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include "soa.hpp"
+#include "spscqueue.hpp"
+#include "strandexecutor.hpp"
+
+using namespace std;
+
+/**
+ * Type-erased asynchronous edge, so that edges of different data types can be drained together.
+ */
+class AsyncEdge
+{
+
+public:
+	// dtor
+	virtual ~AsyncEdge() = default;
+
+	// Block until every event pushed so far has been processed by the listener
+	virtual void Drain() = 0;
+
+};
+
+// Kind of listener callback carried by an asynchronous event
+enum AsyncEventType { ASYNC_ADD, ASYNC_REMOVE, ASYNC_UPDATE };
+
+/**
+ * Listener decorator that forwards callbacks to another listener on a dedicated thread.
+ * Register it on the upstream service in place of the target listener. The upstream thread is the
+ * single producer; the edge thread is the single consumer and is the only thread that calls the target.
+ * When the queue is full the producer waits, which bounds memory and pushes back on the upstream service.
+ * Type V is the data type of the edge.
+ */
+template<typename V>
+class AsyncListener : public ServiceListener<V>, public AsyncEdge
+{
+
+public:
+	// ctor, cpu < 0 leaves the edge thread unpinned
+	AsyncListener(ServiceListener<V>* _target, size_t capacity = 4096, int cpu = -1);
+
+	// dtor, processes the remaining events and joins the edge thread
+	~AsyncListener();
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(V& data) override;
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(V& data) override;
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(V& data) override;
+
+	// Block until every event pushed so far has been processed by the listener
+	void Drain() override;
+
+	// Get the listener the events are forwarded to
+	ServiceListener<V>* GetTarget() const;
+
+private:
+	// one queued callback
+	struct Event
+	{
+		AsyncEventType type;
+		V data;
+#ifdef SOA_INSTRUMENT
+		long long ingress; // ingress stamp of the producing thread, restored on the edge thread
+#endif
+	};
+
+	// Push an event, waiting while the queue is full
+	void Push(AsyncEventType type, const V& data);
+
+	// Edge thread body
+	void Run();
+
+	ServiceListener<V>* target;
+	SPSCQueue<Event> queue;
+	atomic<size_t> pushed; // written by the producer only, read by Drain() from any thread
+	atomic<size_t> processed;
+	atomic<bool> running;
+	thread worker;
+
+};
+
+template<typename V>
+AsyncListener<V>::AsyncListener(ServiceListener<V>* _target, size_t capacity, int cpu) :
+	target(_target), queue(capacity), pushed(0), processed(0), running(true)
+{
+	worker = thread(&AsyncListener<V>::Run, this);
+	if (cpu >= 0)
+	{
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		// pinning is best effort, the edge still works unpinned
+		pthread_setaffinity_np(worker.native_handle(), sizeof(cpu_set_t), &cpus);
+	}
+}
+
+template<typename V>
+AsyncListener<V>::~AsyncListener()
+{
+	Drain();
+	running.store(false, memory_order_release);
+	worker.join();
+}
+
+template<typename V>
+void AsyncListener<V>::ProcessAdd(V& data)
+{
+	Push(ASYNC_ADD, data);
+}
+
+template<typename V>
+void AsyncListener<V>::ProcessRemove(V& data)
+{
+	Push(ASYNC_REMOVE, data);
+}
+
+template<typename V>
+void AsyncListener<V>::ProcessUpdate(V& data)
+{
+	Push(ASYNC_UPDATE, data);
+}
+
+template<typename V>
+void AsyncListener<V>::Drain()
+{
+	while (processed.load(memory_order_acquire) != pushed.load(memory_order_acquire))
+	{
+		this_thread::yield();
+	}
+}
+
+template<typename V>
+ServiceListener<V>* AsyncListener<V>::GetTarget() const
+{
+	return target;
+}
+
+template<typename V>
+void AsyncListener<V>::Push(AsyncEventType type, const V& data)
+{
+	Event event{ type, data };
+#ifdef SOA_INSTRUMENT
+	event.ingress = IngressOf(data);
+#endif
+	while (!queue.TryPush(event))
+	{
+		this_thread::yield();
+	}
+	pushed.store(pushed.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+template<typename V>
+void AsyncListener<V>::Run()
+{
+	Event event;
+	int idle = 0;
+	while (true)
+	{
+		if (queue.TryPop(event))
+		{
+			idle = 0;
+#ifdef SOA_INSTRUMENT
+			eventIngress = event.ingress;
+#endif
+			switch (event.type)
+			{
+			case ASYNC_ADD:
+				target->ProcessAdd(event.data);
+				break;
+			case ASYNC_REMOVE:
+				target->ProcessRemove(event.data);
+				break;
+			case ASYNC_UPDATE:
+				target->ProcessUpdate(event.data);
+				break;
+			}
+			processed.fetch_add(1, memory_order_release);
+		}
+		else if (!running.load(memory_order_acquire))
+		{
+			break;
+		}
+		else if (++idle < 1000)
+		{
+			// spin briefly for the next event, then back off to sleeping
+			this_thread::yield();
+		}
+		else
+		{
+			this_thread::sleep_for(chrono::microseconds(50));
+		}
+	}
+}
+
+/**
+ * Listener decorator that runs another listener on a strand executor, keyed by product.
+ * Events of one product are processed in order on one worker at a time; different products run in parallel.
+ * Everything the target reaches synchronously runs on the worker too, so the services downstream
+ * of a sharded edge must be safe to call for different products at once.
+ * An event arriving while its product's strand is already running on this thread (a second sharded
+ * edge further down the same flow) is processed inline, exactly as a synchronous listener would.
+ * Type V is the data type of the edge, it must have GetProductHandle().
+ */
+template<typename V>
+class ShardedListener : public ServiceListener<V>
+{
+
+public:
+	// ctor
+	ShardedListener(ServiceListener<V>* _target, StrandExecutor& _executor);
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(V& data) override;
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(V& data) override;
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(V& data) override;
+
+	// Listener callback to process a batch of add events to the Service, one task per event
+	void ProcessAddBatch(span<V> batch) override;
+
+private:
+	// Process an event inline if its strand is running here, otherwise post a copy to its strand
+	void Dispatch(AsyncEventType type, V& data);
+
+	// Forward an event to the target
+	void Forward(AsyncEventType type, V& data);
+
+	ServiceListener<V>* target;
+	StrandExecutor& executor;
+
+};
+
+template<typename V>
+ShardedListener<V>::ShardedListener(ServiceListener<V>* _target, StrandExecutor& _executor) :
+	target(_target), executor(_executor)
+{
+}
+
+template<typename V>
+void ShardedListener<V>::ProcessAdd(V& data)
+{
+	Dispatch(ASYNC_ADD, data);
+}
+
+template<typename V>
+void ShardedListener<V>::ProcessRemove(V& data)
+{
+	Dispatch(ASYNC_REMOVE, data);
+}
+
+template<typename V>
+void ShardedListener<V>::ProcessUpdate(V& data)
+{
+	Dispatch(ASYNC_UPDATE, data);
+}
+
+template<typename V>
+void ShardedListener<V>::ProcessAddBatch(span<V> batch)
+{
+	for (auto& data : batch)
+	{
+		Dispatch(ASYNC_ADD, data);
+	}
+}
+
+template<typename V>
+void ShardedListener<V>::Dispatch(AsyncEventType type, V& data)
+{
+	size_t key = data.GetProductHandle();
+	if (executor.IsRunning(key))
+	{
+		Forward(type, data);
+		return;
+	}
+#ifdef SOA_INSTRUMENT
+	long long ingress = IngressOf(data);
+	executor.Post(key, [this, type, data, ingress]() mutable { eventIngress = ingress; Forward(type, data); });
+#else
+	executor.Post(key, [this, type, data]() mutable { Forward(type, data); });
+#endif
+}
+
+template<typename V>
+void ShardedListener<V>::Forward(AsyncEventType type, V& data)
+{
+	switch (type)
+	{
+	case ASYNC_ADD:
+		target->ProcessAdd(data);
+		break;
+	case ASYNC_REMOVE:
+		target->ProcessRemove(data);
+		break;
+	case ASYNC_UPDATE:
+		target->ProcessUpdate(data);
+		break;
+	}
+}
+
+/**
+ * Links listeners to services and owns the asynchronous and sharded edges.
+ * Edges are named; an edge runs asynchronously if its name (or "all") is in the asynchronous set,
+ * it runs sharded by product if sharding is on and its name is in the sharded set,
+ * otherwise the listener is registered directly as before.
+ * Sharded edges are fed from many workers, so no edge downstream of one may be asynchronous.
+ * Declare the wiring after the services it links so that its edges are joined before the services go away.
+ */
+class ServiceWiring
+{
+
+public:
+	// ctor, with pinning on the edge threads take CPUs round robin starting from CPU 1
+	ServiceWiring(const set<string>& _asyncEdges, bool _pin = false);
+
+	// Run the named edges on a pool of workers, sharded by product (call before linking them)
+	void Shard(const set<string>& _shardedEdges, size_t workers);
+
+	// Link a listener to a service over a named edge
+	template<typename K, typename V>
+	void Link(Service<K, V>& service, ServiceListener<V>* listener, const string& name);
+
+	// Check whether a named edge runs asynchronously
+	bool IsAsync(const string& name) const;
+
+	// Check whether a named edge runs sharded by product
+	bool IsSharded(const string& name) const;
+
+	// Block until every asynchronous and sharded edge is idle, upstream edges first
+	void DrainAll();
+
+private:
+	set<string> asyncEdges;
+	set<string> shardedEdges;
+	bool pin;
+	int nextCpu;
+	// declared so that the executor and the edges stop before the listeners they call are freed
+#ifdef SOA_INSTRUMENT
+	vector<shared_ptr<void>> timers; // timed listeners wrapped around every edge
+#endif
+	vector<shared_ptr<void>> shards; // sharded listeners
+	vector<unique_ptr<AsyncEdge>> edges; // in link order
+	unique_ptr<StrandExecutor> executor; // workers of the sharded edges
+
+};
+
+ServiceWiring::ServiceWiring(const set<string>& _asyncEdges, bool _pin) :
+	asyncEdges(_asyncEdges), pin(_pin), nextCpu(1)
+{
+}
+
+void ServiceWiring::Shard(const set<string>& _shardedEdges, size_t workers)
+{
+	shardedEdges = _shardedEdges;
+	executor.reset(new StrandExecutor(workers));
+}
+
+template<typename K, typename V>
+void ServiceWiring::Link(Service<K, V>& service, ServiceListener<V>* listener, const string& name)
+{
+#ifdef SOA_INSTRUMENT
+	// time the listener itself, on the edge thread if the edge is asynchronous
+	shared_ptr<TimedListener<V>> timer = make_shared<TimedListener<V>>(listener, name);
+	timers.push_back(timer);
+	listener = timer.get();
+#endif
+
+	if (IsSharded(name))
+	{
+		if constexpr (requires(const V& data) { data.GetProductHandle(); })
+		{
+			shared_ptr<ShardedListener<V>> shard = make_shared<ShardedListener<V>>(listener, *executor);
+			shards.push_back(shard);
+			service.AddListener(shard.get());
+			return;
+		}
+		else
+		{
+			throw std::invalid_argument("Edge data has no product to shard on: " + name);
+		}
+	}
+
+	if (!IsAsync(name))
+	{
+		service.AddListener(listener);
+		return;
+	}
+
+	int cpu = -1;
+	if (pin)
+	{
+		int cpus = static_cast<int>(thread::hardware_concurrency());
+		cpu = (cpus > 1) ? nextCpu++ % cpus : -1;
+	}
+	AsyncListener<V>* edge = new AsyncListener<V>(listener, 4096, cpu);
+	edges.push_back(unique_ptr<AsyncEdge>(edge));
+	service.AddListener(edge);
+}
+
+bool ServiceWiring::IsAsync(const string& name) const
+{
+	return asyncEdges.count("all") > 0 || asyncEdges.count(name) > 0;
+}
+
+bool ServiceWiring::IsSharded(const string& name) const
+{
+	return executor && shardedEdges.count(name) > 0;
+}
+
+void ServiceWiring::DrainAll()
+{
+	// an edge is only fed by edges linked before it, so one pass in link order leaves all of them idle
+	for (auto& edge : edges)
+	{
+		edge->Drain();
+	}
+	if (executor)
+	{
+		executor->Drain();
+	}
+}
+
+#endif
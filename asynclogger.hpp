@@ -0,0 +1,674 @@
+// asynclogger.hpp
+//
+// Purpose: 1. Defines an asynchronous logger with deferred formatting: producers copy a format ID and the raw
+//    arguments into a per-thread lock-free ring, a background thread formats the records and writes them.
+// 2. Defines the sampled console sink of the publish-only connectors.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef ASYNC_LOGGER_HPP
+#define ASYNC_LOGGER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <charconv>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <type_traits>
+#include <algorithm>
+#include <unistd.h>
+#include "timestamp.hpp"
+
+using namespace std;
+
+// Placeholder of a log format replaced by the next argument, and by the time of the record
+const string_view LOG_ARG = "{}";
+const string_view LOG_TIME = "{time}";
+
+/**
+ * A log format registered once per distinct text. Records carry the ID of their format,
+ * so the text is neither copied nor parsed on the producing thread.
+ * "{}" is replaced by the next argument, "{time}" by the time the record was logged.
+ */
+class LogFormat
+{
+
+public:
+	// ctor, registers the text (formats with the same text share an ID)
+	LogFormat(const string& text);
+
+	// Get the ID of the format
+	uint32_t GetId() const;
+
+private:
+	uint32_t id;
+
+};
+
+/**
+ * Lock-free single-producer/single-consumer ring of variable-size log records.
+ * Records are contiguous: one that does not fit before the end of the ring is preceded by a padding record.
+ */
+class LogRing
+{
+
+public:
+	// Format ID of a padding record
+	static const uint32_t PADDING = UINT32_MAX;
+
+	// ctor, the capacity is rounded up to a power of two
+	LogRing(size_t _capacity);
+
+	// Reserve room for a record of size bytes, a multiple of 8, returns nullptr while the ring is full (producer only)
+	char* Reserve(size_t size);
+
+	// Publish the reserved record (producer only)
+	void Commit(size_t size);
+
+	// Get the next record, nullptr if the ring is empty (consumer only)
+	const char* Peek();
+
+	// Release the record returned by Peek() (consumer only)
+	void Release();
+
+	// Get the capacity of the ring
+	size_t GetCapacity() const;
+
+	// Mark the ring as closed when its thread exits, it is dropped once drained
+	void Close();
+
+	// Check whether the thread of the ring has exited
+	bool IsClosed() const;
+
+private:
+	vector<uint64_t> buffer; // 8 byte slots keep every record aligned
+	size_t mask; // in bytes
+
+	alignas(64) atomic<size_t> head; // bytes consumed, written by the consumer
+	alignas(64) atomic<size_t> tail; // bytes produced, written by the producer
+	size_t cachedHead; // producer's copy of head
+	atomic<bool> closed;
+
+};
+
+/**
+ * Asynchronous logger of the process.
+ * Log() stamps the record, copies the format ID and the arguments (integers, floating point values,
+ * strings) into the ring of the calling thread and returns; nothing is formatted on the producing thread.
+ * A background thread merges the rings in time order, formats each record and writes the text in large
+ * writes to standard output, or to the descriptor given to SetOutput().
+ * A producer whose ring is full waits for the writer, records are never dropped.
+ */
+class AsyncLogger
+{
+
+public:
+	// Get the logger of the process
+	static AsyncLogger& Instance();
+
+	// dtor, writes the remaining records and stops the writer thread
+	~AsyncLogger();
+
+	// Log a record of a format with its arguments
+	template<typename... Args>
+	void Log(const LogFormat& format, const Args&... args);
+
+	// Block until every record logged so far is written
+	void Flush();
+
+	// Write the records logged from now on to a file descriptor instead of standard output
+	void SetOutput(int fd);
+
+private:
+	// Header of a record, followed by the arguments
+	struct Record
+	{
+		uint32_t size; // in bytes, header included, a multiple of 8
+		uint32_t format;
+		int64_t time; // nanoseconds since the epoch
+	};
+
+	// Type of an argument, stored in the first 4 bytes of its 8 byte tag, the length of a string in the other 4
+	enum ArgType : uint32_t { INTEGER_ARG, DOUBLE_ARG, STRING_ARG };
+
+	// Largest string copied into a record, longer strings are cut
+	static constexpr size_t MAX_STRING = 4096;
+
+	// ctor
+	AsyncLogger();
+
+	// Get the encoded size of an argument
+	template<typename A>
+	static size_t ArgSize(const A& arg);
+
+	// Encode an argument, returns the end of the encoded argument
+	template<typename A>
+	static char* EncodeArg(char* out, const A& arg);
+
+	// Get the ring of the calling thread, registering it on first use
+	LogRing& GetRing();
+
+	// Format a record into the output buffer
+	void Format(const Record& record);
+
+	// Write the output buffer to the output file descriptor
+	void WriteOutput();
+
+	// Writer thread body
+	void Run();
+
+	// Write every record in the rings, oldest first, returns false if there were none
+	bool Drain();
+
+	// the pieces of a format: the text before each placeholder, and whether the placeholder is the time
+	struct Piece
+	{
+		string text;
+		bool isTime;
+		bool isArg;
+	};
+
+	friend class LogFormat;
+
+	mutex lock;
+	map<string, uint32_t> formatIds;
+	vector<vector<Piece>> formats; // by format ID, appended only under the lock
+	vector<shared_ptr<LogRing>> rings;
+	atomic<size_t> ringGeneration; // bumped when a ring is registered
+	condition_variable wakeWriter;
+	condition_variable flushed;
+	unsigned long long flushRequested;
+	unsigned long long flushCompleted;
+	bool running;
+	atomic<int> outputFd;
+	thread writer;
+
+	// the writer's view of the formats and rings, refreshed from the shared ones when they change
+	vector<vector<Piece>> writerFormats;
+	vector<shared_ptr<LogRing>> writerRings;
+	size_t writerGeneration;
+	string output;
+	TimestampFormatter timestamps;
+
+};
+
+/**
+ * Console sink of a publish-only connector, printing one event in every interval through the logger.
+ * Connectors call Sample() first, so the fields of the events that are not printed are never read.
+ * The interval is shared by all sinks: 1 prints every event, 0 switches the console output off.
+ */
+class SampledSink
+{
+
+public:
+	// ctor
+	SampledSink(const string& format);
+
+	// Count an event, returns true if it is to be printed
+	bool Sample();
+
+	// Print an event
+	template<typename... Args>
+	void Print(const Args&... args);
+
+	// Set the sampling interval of every sink
+	static void SetInterval(size_t _interval);
+
+	// Get the sampling interval of every sink
+	static size_t GetInterval();
+
+private:
+	LogFormat format;
+	atomic<size_t> count;
+	static atomic<size_t> interval;
+
+};
+
+atomic<size_t> SampledSink::interval(1);
+
+LogFormat::LogFormat(const string& text)
+{
+	AsyncLogger& logger = AsyncLogger::Instance();
+	lock_guard<mutex> guard(logger.lock);
+	auto found = logger.formatIds.find(text);
+	if (found != logger.formatIds.end())
+	{
+		id = found->second;
+		return;
+	}
+
+	// split the text at its placeholders
+	vector<AsyncLogger::Piece> pieces;
+	size_t start = 0;
+	while (true)
+	{
+		size_t arg = text.find(LOG_ARG, start);
+		size_t time = text.find(LOG_TIME, start);
+		size_t next = min(arg, time);
+		if (next == string::npos)
+		{
+			pieces.push_back({ text.substr(start), false, false });
+			break;
+		}
+		bool isTime = (next == time);
+		pieces.push_back({ text.substr(start, next - start), isTime, !isTime });
+		start = next + (isTime ? LOG_TIME.size() : LOG_ARG.size());
+	}
+	id = static_cast<uint32_t>(logger.formats.size());
+	logger.formats.push_back(move(pieces));
+	logger.formatIds[text] = id;
+}
+
+uint32_t LogFormat::GetId() const
+{
+	return id;
+}
+
+LogRing::LogRing(size_t _capacity) : head(0), tail(0), cachedHead(0), closed(false)
+{
+	size_t capacity = 64;
+	while (capacity < _capacity)
+	{
+		capacity <<= 1;
+	}
+	buffer.resize(capacity / sizeof(uint64_t));
+	mask = capacity - 1;
+}
+
+char* LogRing::Reserve(size_t size)
+{
+	size_t capacity = mask + 1;
+	size_t t = tail.load(memory_order_relaxed);
+	size_t offset = t & mask;
+	// a record never wraps: the rest of the ring is padded if it does not fit
+	size_t padding = (capacity - offset < size) ? capacity - offset : 0;
+	if (t + padding + size - cachedHead > capacity)
+	{
+		cachedHead = head.load(memory_order_acquire);
+		if (t + padding + size - cachedHead > capacity)
+		{
+			return nullptr;
+		}
+	}
+
+	char* data = reinterpret_cast<char*>(buffer.data());
+	if (padding > 0)
+	{
+		uint32_t header[2] = { static_cast<uint32_t>(padding), PADDING };
+		memcpy(data + offset, header, sizeof(header));
+		tail.store(t + padding, memory_order_release);
+		offset = 0;
+	}
+	return data + offset;
+}
+
+void LogRing::Commit(size_t size)
+{
+	tail.store(tail.load(memory_order_relaxed) + size, memory_order_release);
+}
+
+const char* LogRing::Peek()
+{
+	while (true)
+	{
+		size_t h = head.load(memory_order_relaxed);
+		if (h == tail.load(memory_order_acquire))
+		{
+			return nullptr;
+		}
+		const char* record = reinterpret_cast<const char*>(buffer.data()) + (h & mask);
+		uint32_t header[2];
+		memcpy(header, record, sizeof(header));
+		if (header[1] != PADDING)
+		{
+			return record;
+		}
+		head.store(h + header[0], memory_order_release);
+	}
+}
+
+void LogRing::Release()
+{
+	size_t h = head.load(memory_order_relaxed);
+	uint32_t size;
+	memcpy(&size, reinterpret_cast<const char*>(buffer.data()) + (h & mask), sizeof(size));
+	head.store(h + size, memory_order_release);
+}
+
+size_t LogRing::GetCapacity() const
+{
+	return mask + 1;
+}
+
+void LogRing::Close()
+{
+	closed.store(true, memory_order_release);
+}
+
+bool LogRing::IsClosed() const
+{
+	return closed.load(memory_order_acquire);
+}
+
+AsyncLogger& AsyncLogger::Instance()
+{
+	static AsyncLogger logger;
+	return logger;
+}
+
+AsyncLogger::AsyncLogger() :
+	ringGeneration(0), flushRequested(0), flushCompleted(0), running(true), outputFd(STDOUT_FILENO), writerGeneration(0)
+{
+	output.reserve(1 << 16);
+	writer = thread(&AsyncLogger::Run, this);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+	{
+		lock_guard<mutex> guard(lock);
+		running = false;
+	}
+	wakeWriter.notify_one();
+	writer.join();
+}
+
+template<typename... Args>
+void AsyncLogger::Log(const LogFormat& format, const Args&... args)
+{
+	LogRing& ring = GetRing();
+	size_t size = sizeof(Record) + (static_cast<size_t>(0) + ... + ArgSize(args));
+	if (size > ring.GetCapacity() / 2)
+	{
+		throw std::invalid_argument("Log record too large");
+	}
+
+	char* out;
+	while ((out = ring.Reserve(size)) == nullptr)
+	{
+		this_thread::yield();
+	}
+	Record record;
+	record.size = static_cast<uint32_t>(size);
+	record.format = format.GetId();
+	record.time = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+	memcpy(out, &record, sizeof(record));
+	if constexpr (sizeof...(Args) > 0)
+	{
+		char* end = out + sizeof(record);
+		((end = EncodeArg(end, args)), ...);
+	}
+	ring.Commit(size);
+}
+
+void AsyncLogger::Flush()
+{
+	unique_lock<mutex> guard(lock);
+	unsigned long long target = ++flushRequested;
+	wakeWriter.notify_one();
+	flushed.wait(guard, [this, target]() { return flushCompleted >= target; });
+}
+
+void AsyncLogger::SetOutput(int fd)
+{
+	Flush();
+	outputFd.store(fd);
+}
+
+template<typename A>
+size_t AsyncLogger::ArgSize(const A& arg)
+{
+	if constexpr (is_arithmetic_v<A>)
+	{
+		static_assert(!is_same_v<A, bool>, "log booleans as strings");
+		return 2 * sizeof(uint64_t);
+	}
+	else
+	{
+		size_t length = min(string_view(arg).size(), MAX_STRING);
+		return sizeof(uint64_t) + (length + 7) / 8 * 8;
+	}
+}
+
+template<typename A>
+char* AsyncLogger::EncodeArg(char* out, const A& arg)
+{
+	uint32_t tag[2] = { 0, 0 };
+	if constexpr (is_integral_v<A>)
+	{
+		tag[0] = INTEGER_ARG;
+		int64_t value = static_cast<int64_t>(arg);
+		memcpy(out, tag, sizeof(tag));
+		memcpy(out + sizeof(tag), &value, sizeof(value));
+		return out + 2 * sizeof(uint64_t);
+	}
+	else if constexpr (is_floating_point_v<A>)
+	{
+		tag[0] = DOUBLE_ARG;
+		double value = static_cast<double>(arg);
+		memcpy(out, tag, sizeof(tag));
+		memcpy(out + sizeof(tag), &value, sizeof(value));
+		return out + 2 * sizeof(uint64_t);
+	}
+	else
+	{
+		string_view text(arg);
+		text = text.substr(0, MAX_STRING);
+		tag[0] = STRING_ARG;
+		tag[1] = static_cast<uint32_t>(text.size());
+		memcpy(out, tag, sizeof(tag));
+		memcpy(out + sizeof(tag), text.data(), text.size());
+		return out + sizeof(tag) + (text.size() + 7) / 8 * 8;
+	}
+}
+
+LogRing& AsyncLogger::GetRing()
+{
+	// owned by the thread, closed when the thread exits so the writer can drop the ring once drained
+	struct RingHolder
+	{
+		shared_ptr<LogRing> ring;
+		~RingHolder() { if (ring) ring->Close(); }
+	};
+	static thread_local RingHolder holder;
+	if (!holder.ring)
+	{
+		holder.ring = make_shared<LogRing>(1 << 20);
+		lock_guard<mutex> guard(lock);
+		rings.push_back(holder.ring);
+		ringGeneration.fetch_add(1, memory_order_release);
+	}
+	return *holder.ring;
+}
+
+void AsyncLogger::Format(const Record& record)
+{
+	const char* arg = reinterpret_cast<const char*>(&record) + sizeof(Record);
+	const char* end = reinterpret_cast<const char*>(&record) + record.size;
+	char number[32];
+	for (const Piece& piece : writerFormats[record.format])
+	{
+		output.append(piece.text);
+		if (piece.isTime)
+		{
+			timestamps.Append(chrono::system_clock::time_point(chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(record.time))), output);
+		}
+		else if (piece.isArg && arg < end)
+		{
+			uint32_t tag[2];
+			memcpy(tag, arg, sizeof(tag));
+			arg += sizeof(tag);
+			if (tag[0] == STRING_ARG)
+			{
+				output.append(arg, tag[1]);
+				arg += (tag[1] + 7) / 8 * 8;
+			}
+			else if (tag[0] == INTEGER_ARG)
+			{
+				int64_t value;
+				memcpy(&value, arg, sizeof(value));
+				output.append(number, to_chars(number, number + sizeof(number), value).ptr);
+				arg += sizeof(value);
+			}
+			else
+			{
+				// doubles in fixed notation with 6 decimals, as the console used to print them
+				double value;
+				memcpy(&value, arg, sizeof(value));
+				auto result = to_chars(number, number + sizeof(number), value, chars_format::fixed, 6);
+				output.append(number, result.ec == errc() ? result.ptr : number);
+				arg += sizeof(value);
+			}
+		}
+	}
+}
+
+void AsyncLogger::WriteOutput()
+{
+	const char* data = output.data();
+	size_t remaining = output.size();
+	while (remaining > 0)
+	{
+		ssize_t count = ::write(outputFd.load(memory_order_relaxed), data, remaining);
+		if (count < 0)
+		{
+			// interrupted writes are retried, anything else drops the rest of the output
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+		data += count;
+		remaining -= static_cast<size_t>(count);
+	}
+	output.clear();
+}
+
+void AsyncLogger::Run()
+{
+	unique_lock<mutex> guard(lock);
+	while (true)
+	{
+		bool stopping = !running;
+		unsigned long long target = flushRequested;
+		guard.unlock();
+
+		// a record logged before a flush request or the dtor is visible once the lock has been taken
+		while (Drain())
+		{
+		}
+
+		guard.lock();
+		if (target > flushCompleted)
+		{
+			flushCompleted = target;
+			flushed.notify_all();
+		}
+		if (stopping)
+		{
+			return;
+		}
+		wakeWriter.wait_for(guard, chrono::milliseconds(1), [this, target]() { return flushRequested > target || !running; });
+	}
+}
+
+bool AsyncLogger::Drain()
+{
+	// refresh the rings registered since the last drain
+	if (ringGeneration.load(memory_order_acquire) != writerGeneration)
+	{
+		lock_guard<mutex> guard(lock);
+		writerGeneration = ringGeneration.load(memory_order_acquire);
+		writerRings = rings;
+		writerFormats = formats;
+	}
+
+	bool any = false;
+	while (true)
+	{
+		// the oldest record at the front of a ring is written first
+		LogRing* oldest = nullptr;
+		const Record* oldestRecord = nullptr;
+		for (auto& ring : writerRings)
+		{
+			const char* data = ring->Peek();
+			if (data != nullptr)
+			{
+				const Record* record = reinterpret_cast<const Record*>(data);
+				if (oldestRecord == nullptr || record->time < oldestRecord->time)
+				{
+					oldest = ring.get();
+					oldestRecord = record;
+				}
+			}
+		}
+		if (oldest == nullptr)
+		{
+			break;
+		}
+		if (oldestRecord->format >= writerFormats.size())
+		{
+			// a format registered since the last refresh
+			lock_guard<mutex> guard(lock);
+			writerFormats = formats;
+		}
+		Format(*oldestRecord);
+		oldest->Release();
+		any = true;
+		if (output.size() >= (1 << 16))
+		{
+			WriteOutput();
+		}
+	}
+	WriteOutput();
+
+	// drop the rings of exited threads once they are empty
+	size_t before = writerRings.size();
+	auto isDone = [](const shared_ptr<LogRing>& ring) { return ring->IsClosed() && ring->Peek() == nullptr; };
+	writerRings.erase(remove_if(writerRings.begin(), writerRings.end(), isDone), writerRings.end());
+	if (writerRings.size() != before)
+	{
+		lock_guard<mutex> guard(lock);
+		rings.erase(remove_if(rings.begin(), rings.end(), isDone), rings.end());
+	}
+	return any;
+}
+
+SampledSink::SampledSink(const string& _format) : format(_format), count(0)
+{
+}
+
+bool SampledSink::Sample()
+{
+	size_t every = interval.load(memory_order_relaxed);
+	return every != 0 && count.fetch_add(1, memory_order_relaxed) % every == 0;
+}
+
+template<typename... Args>
+void SampledSink::Print(const Args&... args)
+{
+	AsyncLogger::Instance().Log(format, args...);
+}
+
+void SampledSink::SetInterval(size_t _interval)
+{
+	interval.store(_interval, memory_order_relaxed);
+}
+
+size_t SampledSink::GetInterval()
+{
+	return interval.load(memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,1754 @@
+// benchmark.cpp
+//
+// Purpose: 1. Benchmarks for the hot paths of the trading system.
+// 2. Usage: benchmark <name> [args...], run without arguments to list the benchmarks.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#include <iostream>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <filesystem>
+#include <algorithm>
+#include <fcntl.h>
+
+#include "soa.hpp"
+#include "products.hpp"
+#include "marketdataservice.hpp"
+#include "pricingservice.hpp"
+#include "riskservice.hpp"
+#include "scenarioriskservice.hpp"
+#include "pnlservice.hpp"
+#include "executionservice.hpp"
+#include "positionservice.hpp"
+#include "inquiryservice.hpp"
+#include "historicaldataservice.hpp"
+#include "streamingservice.hpp"
+#include "algostreamingservice.hpp"
+#include "tradebookingservice.hpp"
+#include "algoexecutionservice.hpp"
+#include "guiservice.hpp"
+#include "timerwheel.hpp"
+#include "staticpipeline.hpp"
+#include "asynclistener.hpp"
+#include "utilities.hpp"
+#include "fracprice.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+// one parsed line of marketdata.txt
+struct BookSnapshot
+{
+	string productId;
+	vector<Order> bids;
+	vector<Order> offers;
+};
+
+// read up to maxLines order book lines from the file into snapshots
+size_t ReadSnapshots(ifstream& file, vector<BookSnapshot>& snapshots, size_t maxLines, int depth)
+{
+	snapshots.clear();
+	string line;
+	while (snapshots.size() < maxLines && getline(file, line))
+	{
+		stringstream rawline(line);
+		string block;
+		vector<string> splitdata;
+		while (getline(rawline, block, ','))
+		{
+			splitdata.push_back(block);
+		}
+
+		BookSnapshot snapshot;
+		snapshot.productId = splitdata[1];
+		for (int i = 0; i < depth; i++)
+		{
+			snapshot.bids.push_back(Order(Frac2Price(splitdata[4 * i + 2]), stol(splitdata[4 * i + 3]), BID));
+			snapshot.offers.push_back(Order(Frac2Price(splitdata[4 * i + 4]), stol(splitdata[4 * i + 5]), OFFER));
+		}
+		snapshots.push_back(snapshot);
+	}
+	return snapshots.size();
+}
+
+/**
+ * Feed marketdata.txt through the market data service window by window and report the
+ * per-tick cost of each window, for the fixed-depth book and for the legacy stack book.
+ * The fixed-depth cost should stay flat while the stack book grows with the ticks seen.
+ */
+int BenchOrderBook(const vector<string>& args)
+{
+	string path = args.size() > 0 ? args[0] : "./data/marketdata.txt";
+	size_t window = args.size() > 1 ? stoul(args[1]) : 100000;
+	size_t legacyTicks = args.size() > 2 ? stoul(args[2]) : 200000;
+
+	ifstream file(path);
+	if (!file.is_open())
+	{
+		log(LogLevel::ERROR, "Cannot open " + path + ", run tradingsystem first to generate it.");
+		return 1;
+	}
+	string header;
+	getline(file, header);
+
+	MarketDataService<Bond> fixedService;
+	MarketDataService<Bond> stackService;
+	int depth = fixedService.GetBookDepth();
+	vector<BookSnapshot> snapshots;
+	size_t ticks = 0;
+	volatile double sink = 0.0;
+
+	cout << setw(12) << "ticks" << setw(18) << "fixed ns/tick" << setw(18) << "stack ns/tick" << endl;
+	while (ReadSnapshots(file, snapshots, window, depth) > 0)
+	{
+		// fixed-depth book: in-place snapshot, aggregate and best bid/offer
+		auto start = steady_clock::now();
+		for (auto& snapshot : snapshots)
+		{
+			OrderBook<Bond>& book = fixedService.GetData(snapshot.productId);
+			book.UpdateSnapshot(snapshot.bids.data(), depth, snapshot.offers.data(), depth);
+			fixedService.OnMessage(book);
+			const OrderBook<Bond>& aggregated = fixedService.AggregateDepth(snapshot.productId);
+			sink = sink + aggregated.BestBidOffer().GetBidOrder().GetPrice();
+		}
+		double fixedNs = duration<double, nano>(steady_clock::now() - start).count() / snapshots.size();
+
+		// legacy stack book: push every level, then re-aggregate the whole stack
+		string stackNs = "-";
+		if (ticks < legacyTicks)
+		{
+			start = steady_clock::now();
+			for (auto& snapshot : snapshots)
+			{
+				OrderBook<Bond>& book = stackService.GetData(snapshot.productId);
+				if (book.IsFixedDepth())
+				{
+					book = OrderBook<Bond>(book.GetProduct(), vector<Order>(), vector<Order>());
+				}
+				for (int i = 0; i < depth; i++)
+				{
+					book.GetBidStack().push_back(snapshot.bids[i]);
+					book.GetOfferStack().push_back(snapshot.offers[i]);
+				}
+				OrderBook<Bond> aggregated = stackService.AggregateDepth(snapshot.productId);
+				stackService.OnMessage(aggregated);
+				sink = sink + aggregated.BestBidOffer().GetBidOrder().GetPrice();
+			}
+			stringstream ss;
+			ss << fixed << setprecision(1) << duration<double, nano>(steady_clock::now() - start).count() / snapshots.size();
+			stackNs = ss.str();
+		}
+
+		ticks += snapshots.size();
+		cout << setw(12) << ticks << setw(18) << fixed << setprecision(1) << fixedNs << setw(18) << stackNs << endl;
+	}
+	return 0;
+}
+
+/**
+ * Check ParseFracPrice and the batch ParseFracPrices against Frac2Price on every well-formed
+ * price from 0-000 to 999-31+, check malformed prices are rejected, then measure the
+ * throughput of the three parsers in prices per second.
+ */
+int BenchFracPrice(const vector<string>& args)
+{
+	size_t repeat = args.size() > 0 ? stoul(args[0]) : 20;
+
+	// every well-formed price
+	vector<string> texts;
+	const string eighths = "01234567+";
+	for (int whole = 0; whole < 1000; whole++)
+	{
+		for (int xy = 0; xy < 32; xy++)
+		{
+			for (char z : eighths)
+			{
+				texts.push_back(to_string(whole) + "-" + (xy < 10 ? "0" : "") + to_string(xy) + z);
+			}
+		}
+	}
+	vector<string_view> views(texts.begin(), texts.end());
+
+	// conformance
+	size_t mismatches = 0;
+	vector<double> batch(views.size());
+	ParseFracPrices(views.data(), batch.data(), views.size());
+	for (size_t i = 0; i < texts.size(); i++)
+	{
+		double expected = Frac2Price(texts[i]);
+		if (ParseFracPrice(views[i]) != expected || batch[i] != expected)
+		{
+			if (mismatches++ < 10)
+			{
+				log(LogLevel::ERROR, "Mismatch on " + texts[i]);
+			}
+		}
+	}
+	vector<string> malformed = { "", "99", "99-1", "99-16", "99-1600", "99-321", "99-168", "99-16x", "a9-160", "9916+0", "99+160", "1000-000", "-99-160" };
+	for (auto& text : malformed)
+	{
+		long ticks;
+		string_view view(text);
+		if (ParseFracTicks(text, ticks) || ParseFracTicks(&view, &ticks, 1) != 0)
+		{
+			if (mismatches++ < 10)
+			{
+				log(LogLevel::ERROR, "Accepted malformed price \"" + text + "\"");
+			}
+		}
+	}
+	cout << "conformance: " << texts.size() << " prices, " << malformed.size() << " malformed, " << mismatches << " mismatches" << endl;
+
+	// throughput
+	volatile double sink = 0.0;
+	auto report = [&](const string& name, const function<void()>& body) {
+		auto start = steady_clock::now();
+		for (size_t r = 0; r < repeat; r++)
+		{
+			body();
+		}
+		double seconds = duration<double>(steady_clock::now() - start).count();
+		cout << setw(16) << name << setw(16) << fixed << setprecision(1) << texts.size() * repeat / seconds / 1e6 << " M prices/s" << endl;
+	};
+	report("Frac2Price", [&]() { for (auto& text : texts) sink = sink + Frac2Price(text); });
+	report("ParseFracPrice", [&]() { for (auto& view : views) sink = sink + ParseFracPrice(view); });
+	report("ParseFracPrices", [&]() { ParseFracPrices(views.data(), batch.data(), views.size()); sink = sink + batch.back(); });
+
+	return mismatches == 0 ? 0 : 1;
+}
+
+/**
+ * Check TimestampParser against strptime and mktime on a day of timestamps, one every 37 ms
+ * (formatted by TimestampFormatter), check malformed timestamps are rejected, then measure both
+ * parsers in timestamps per second.
+ */
+int BenchTimestamp(const vector<string>& args)
+{
+	size_t count = args.size() > 0 ? stoul(args[0]) : 2000000;
+
+	vector<string> texts;
+	TimestampFormatter formatter;
+	auto start = system_clock::time_point(seconds(1790000000));
+	for (size_t i = 0; i < count; i++)
+	{
+		string text;
+		formatter.Append(start + milliseconds(37 * i), text);
+		texts.push_back(text);
+	}
+
+	// the reference: strptime for the fields, mktime for the local time
+	auto reference = [](const string& text) {
+		tm local = {};
+		strptime(text.c_str(), "%Y-%m-%d-%H:%M:%S", &local);
+		local.tm_isdst = -1;
+		return static_cast<int64_t>(mktime(&local)) * 1000000000LL + stoi(text.substr(20)) * 1000000LL;
+	};
+
+	// conformance
+	size_t mismatches = 0;
+	TimestampParser parser;
+	for (auto& text : texts)
+	{
+		if (parser.Parse(text) != reference(text))
+		{
+			if (mismatches++ < 10)
+			{
+				log(LogLevel::ERROR, "Mismatch on " + text);
+			}
+		}
+	}
+	vector<string> malformed = { "", "2026-10-16", "2026-10-16 12:00:00.000", "2026-13-16-12:00:00.000", "2026-10-16-24:00:00.000",
+		"2026-10-16-12:00:00.00", "2026-10-16-12:00:00.0000", "2026-1O-16-12:00:00.000", "2026-10-16-12:60:00.000" };
+	for (auto& text : malformed)
+	{
+		int64_t nanos;
+		if (parser.Parse(text, nanos))
+		{
+			if (mismatches++ < 10)
+			{
+				log(LogLevel::ERROR, "Accepted malformed timestamp \"" + text + "\"");
+			}
+		}
+	}
+	cout << "conformance: " << texts.size() << " timestamps, " << malformed.size() << " malformed, " << mismatches << " mismatches" << endl;
+
+	// throughput
+	volatile int64_t sink = 0;
+	auto report = [&](const string& name, const function<void()>& body) {
+		auto begin = steady_clock::now();
+		body();
+		double elapsed = duration<double>(steady_clock::now() - begin).count();
+		cout << setw(16) << name << setw(16) << fixed << setprecision(1) << texts.size() / elapsed / 1e6 << " M timestamps/s" << endl;
+	};
+	report("strptime", [&]() { for (auto& text : texts) sink = sink + reference(text); });
+	report("TimestampParser", [&]() { for (auto& text : texts) sink = sink + parser.Parse(text); });
+
+	return mismatches == 0 ? 0 : 1;
+}
+
+// every service of the trading system, linked as in main.cpp
+struct TradingSystem
+{
+	PricingService<Bond> pricingService;
+	AlgoStreamingService<Bond> algoStreamingService;
+	StreamingService<Bond> streamingService;
+	MarketDataService<Bond> marketDataService;
+	AlgoExecutionService<Bond> algoExecutionService;
+	ExecutionService<Bond> executionService;
+	TradeBookingService<Bond> tradeBookingService;
+	PositionService<Bond> positionService;
+	RiskService<Bond> riskService;
+	GUIService<Bond> guiService;
+	InquiryService<Bond> inquiryService;
+	HistoricalDataService<Position<Bond>> historicalPositionService{POSITION};
+	HistoricalDataService<PV01<Bond>> historicalRiskService{RISK};
+	HistoricalDataService<ExecutionOrder<Bond>> historicalExecutionService{EXECUTION};
+	HistoricalDataService<PriceStream<Bond>> historicalStreamingService{STREAMING};
+	HistoricalDataService<Inquiry<Bond>> historicalInquiryService{INQUIRY};
+
+	// Link the service listeners, probes added before this see each hop before its downstream services
+	void Link()
+	{
+		ServiceWiring wiring({});
+		Link(wiring);
+	}
+
+	// Link the service listeners over the edges of a wiring (declared after the system)
+	void Link(ServiceWiring& wiring)
+	{
+		wiring.Link(pricingService, algoStreamingService.GetAlgoStreamingListener(), "pricing-algostreaming");
+		wiring.Link(pricingService, guiService.GetGUIServiceListener(), "pricing-gui");
+		wiring.Link(algoStreamingService, streamingService.GetStreamingServiceListener(), "algostreaming-streaming");
+		wiring.Link(marketDataService, algoExecutionService.GetAlgoExecutionServiceListener(), "marketdata-algoexecution");
+		wiring.Link(algoExecutionService, executionService.GetExecutionServiceListener(), "algoexecution-execution");
+		wiring.Link(executionService, tradeBookingService.GetTradeBookingServiceListener(), "execution-tradebooking");
+		wiring.Link(tradeBookingService, positionService.GetPositionListener(), "tradebooking-position");
+		wiring.Link(positionService, riskService.GetRiskServiceListener(), "position-risk");
+
+		wiring.Link(positionService, historicalPositionService.GetHistoricalDataServiceListener(), "position-historical");
+		wiring.Link(executionService, historicalExecutionService.GetHistoricalDataServiceListener(), "execution-historical");
+		wiring.Link(streamingService, historicalStreamingService.GetHistoricalDataServiceListener(), "streaming-historical");
+		wiring.Link(riskService, historicalRiskService.GetHistoricalDataServiceListener(), "risk-historical");
+		wiring.Link(inquiryService, historicalInquiryService.GetHistoricalDataServiceListener(), "inquiry-historical");
+	}
+};
+
+// time the message being driven entered the system
+steady_clock::time_point ingress;
+
+// latency samples of one hop, in nanoseconds since ingress
+struct Probe
+{
+	string hop;
+	vector<long> samples = {};
+};
+
+/**
+ * Listener recording the latency since ingress of every add event on a service.
+ * Registered on a service before its downstream listeners, it sees the data as soon as the service publishes it.
+ */
+template<typename V>
+class ProbeListener : public ServiceListener<V>
+{
+
+public:
+	ProbeListener(Probe& _probe) : probe(_probe) {}
+
+	void ProcessAdd(V& data) override
+	{
+		probe.samples.push_back(duration_cast<nanoseconds>(steady_clock::now() - ingress).count());
+	}
+
+	void ProcessRemove(V& data) override {}
+
+	void ProcessUpdate(V& data) override {}
+
+private:
+	Probe& probe;
+
+};
+
+// Get the products of a run: the seven treasuries, then synthetic copies of them with their own identifiers and PV01
+vector<string> BenchProducts(int count)
+{
+	vector<string> base = { "9128283H1", "9128283L2", "912828M80", "9128283J7", "9128283F5", "912810TW8", "912810RZ3" };
+	vector<string> products;
+	for (int i = 0; i < count; i++)
+	{
+		const string& baseId = base[i % base.size()];
+		if (i < static_cast<int>(base.size()))
+		{
+			products.push_back(baseId);
+			continue;
+		}
+
+		stringstream id;
+		id << "BENCH" << setw(4) << setfill('0') << i;
+		string productId = id.str();
+		Bond bond = productConstructors<Bond>[baseId]();
+		productConstructors<Bond>[productId] = [productId, bond]() {
+			return Bond(productId, CUSIP, bond.GetTicker(), bond.GetCoupon(), bond.GetMaturityDate());
+		};
+		pv01[productId] = pv01[baseId];
+		products.push_back(productId);
+	}
+	RegisterProducts<Bond>();
+	return products;
+}
+
+// Print the message rate and the latency percentiles of every hop
+void ReportFlow(const string& flow, size_t messages, double connectorSeconds, double drivenSeconds, const vector<Probe*>& probes)
+{
+	cout << flow << ": " << messages << " messages" << endl;
+	cout << "  connector (batched)  " << setw(14) << fixed << setprecision(0) << messages / connectorSeconds << " msgs/s" << endl;
+	cout << "  per message          " << setw(14) << fixed << setprecision(0) << messages / drivenSeconds << " msgs/s" << endl;
+	cout << "  " << left << setw(20) << "hop" << right << setw(10) << "count" << setw(12) << "p50 ns" << setw(12) << "p99 ns" << setw(12) << "p99.9 ns" << endl;
+	for (auto probe : probes)
+	{
+		vector<long>& samples = probe->samples;
+		sort(samples.begin(), samples.end());
+		auto percentile = [&samples](double p) {
+			return samples.empty() ? 0L : samples[min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+		};
+		cout << "  " << left << setw(20) << probe->hop << right << setw(10) << samples.size()
+			<< setw(12) << percentile(0.50) << setw(12) << percentile(0.99) << setw(12) << percentile(0.999) << endl;
+	}
+}
+
+// Drive messages through a service one at a time, stamping the ingress time of each
+template<typename V>
+double DriveMessages(Service<string, V>& service, vector<V>& messages, Probe& total)
+{
+	auto start = steady_clock::now();
+	for (auto& message : messages)
+	{
+		ingress = steady_clock::now();
+		service.OnMessage(message);
+		total.samples.push_back(duration_cast<nanoseconds>(steady_clock::now() - ingress).count());
+	}
+	return duration<double>(steady_clock::now() - start).count();
+}
+
+// Time a connector subscribing a whole file
+template<typename C>
+double TimeSubscribe(C* connector, const string& path)
+{
+	auto start = steady_clock::now();
+	connector->Subscribe(path);
+	return duration<double>(steady_clock::now() - start).count();
+}
+
+// price data -> pricing service -> algo streaming service -> streaming service -> historical data service
+void BenchPriceFlow(const string& path)
+{
+	double connectorSeconds;
+	{
+		TradingSystem system;
+		system.Link();
+		connectorSeconds = TimeSubscribe(system.pricingService.GetConnector(), path);
+	}
+
+	vector<Price<Bond>> messages;
+	CsvReader reader(path);
+	reader.NextLine();
+	while (reader.NextLine())
+	{
+		messages.emplace_back(QueryProductHandle<Bond>(string(reader[1])), ParseTickPrice(reader[2]), ParseTickPrice(reader[3]));
+	}
+
+	Probe pricing{ "pricing" }, algoStreaming{ "algostreaming" }, streaming{ "streaming" }, total{ "end-to-end" };
+	ProbeListener<Price<Bond>> pricingProbe(pricing);
+	ProbeListener<AlgoStream<Bond>> algoStreamingProbe(algoStreaming);
+	ProbeListener<PriceStream<Bond>> streamingProbe(streaming);
+	TradingSystem system;
+	system.pricingService.AddListener(&pricingProbe);
+	system.algoStreamingService.AddListener(&algoStreamingProbe);
+	system.streamingService.AddListener(&streamingProbe);
+	system.Link();
+	double drivenSeconds = DriveMessages(system.pricingService, messages, total);
+
+	ReportFlow("price", messages.size(), connectorSeconds, drivenSeconds, { &pricing, &algoStreaming, &streaming, &total });
+}
+
+// orderbook data -> market data service -> algo execution service -> execution service -> trade booking service -> position service -> risk service
+void BenchMarketDataFlow(const string& path)
+{
+	double connectorSeconds;
+	{
+		TradingSystem system;
+		system.Link();
+		connectorSeconds = TimeSubscribe(system.marketDataService.GetConnector(), path);
+	}
+
+	vector<OrderBook<Bond>> messages;
+	CsvReader reader(path);
+	reader.NextLine();
+	const int depth = 5;
+	vector<Order> bids(depth), offers(depth);
+	while (reader.NextLine())
+	{
+		for (int i = 0; i < depth; i++)
+		{
+			bids[i] = Order(ParseTickPrice(reader[4 * i + 2]), ParseLong(reader[4 * i + 3]), BID);
+			offers[i] = Order(ParseTickPrice(reader[4 * i + 4]), ParseLong(reader[4 * i + 5]), OFFER);
+		}
+		messages.emplace_back(QueryProductHandle<Bond>(string(reader[1])), depth);
+		messages.back().UpdateSnapshot(bids.data(), depth, offers.data(), depth);
+	}
+
+	Probe marketData{ "marketdata" }, algoExecution{ "algoexecution" }, execution{ "execution" }, tradeBooking{ "tradebooking" },
+		position{ "position" }, risk{ "risk" }, total{ "end-to-end" };
+	ProbeListener<OrderBook<Bond>> marketDataProbe(marketData);
+	ProbeListener<AlgoExecution<Bond>> algoExecutionProbe(algoExecution);
+	ProbeListener<ExecutionOrder<Bond>> executionProbe(execution);
+	ProbeListener<Trade<Bond>> tradeBookingProbe(tradeBooking);
+	ProbeListener<Position<Bond>> positionProbe(position);
+	ProbeListener<PV01<Bond>> riskProbe(risk);
+	TradingSystem system;
+	system.marketDataService.AddListener(&marketDataProbe);
+	system.algoExecutionService.AddListener(&algoExecutionProbe);
+	system.executionService.AddListener(&executionProbe);
+	system.tradeBookingService.AddListener(&tradeBookingProbe);
+	system.positionService.AddListener(&positionProbe);
+	system.riskService.AddListener(&riskProbe);
+	system.Link();
+	double drivenSeconds = DriveMessages(system.marketDataService, messages, total);
+
+	ReportFlow("marketdata", messages.size(), connectorSeconds, drivenSeconds, { &marketData, &algoExecution, &execution, &tradeBooking, &position, &risk, &total });
+}
+
+// trade data -> trade booking service -> position service -> risk service -> historical data service
+void BenchTradeFlow(const string& path)
+{
+	double connectorSeconds;
+	{
+		TradingSystem system;
+		system.Link();
+		connectorSeconds = TimeSubscribe(system.tradeBookingService.GetConnector(), path);
+	}
+
+	vector<Trade<Bond>> messages;
+	CsvReader reader(path);
+	while (reader.NextLine())
+	{
+		messages.emplace_back(QueryProductHandle<Bond>(string(reader[0])), string(reader[1]), ParseTickPrice(reader[2]),
+			string(reader[3]), ParseLong(reader[4]), reader[5] == "BUY" ? BUY : SELL);
+	}
+
+	Probe tradeBooking{ "tradebooking" }, position{ "position" }, risk{ "risk" }, total{ "end-to-end" };
+	ProbeListener<Trade<Bond>> tradeBookingProbe(tradeBooking);
+	ProbeListener<Position<Bond>> positionProbe(position);
+	ProbeListener<PV01<Bond>> riskProbe(risk);
+	TradingSystem system;
+	system.tradeBookingService.AddListener(&tradeBookingProbe);
+	system.positionService.AddListener(&positionProbe);
+	system.riskService.AddListener(&riskProbe);
+	system.Link();
+	double drivenSeconds = DriveMessages(system.tradeBookingService, messages, total);
+
+	ReportFlow("trade", messages.size(), connectorSeconds, drivenSeconds, { &tradeBooking, &position, &risk, &total });
+}
+
+// inquiry data -> inquiry service -> historical data service
+void BenchInquiryFlow(const string& path)
+{
+	double connectorSeconds;
+	{
+		TradingSystem system;
+		system.Link();
+		connectorSeconds = TimeSubscribe(system.inquiryService.GetConnector(), path);
+	}
+
+	vector<Inquiry<Bond>> messages;
+	CsvReader reader(path);
+	while (reader.NextLine())
+	{
+		messages.emplace_back(string(reader[0]), QueryProductHandle<Bond>(string(reader[1])), reader[2] == "BUY" ? BUY : SELL,
+			ParseLong(reader[3]), ParseTickPrice(reader[4]), RECEIVED);
+	}
+
+	Probe inquiry{ "inquiry" }, total{ "end-to-end" };
+	ProbeListener<Inquiry<Bond>> inquiryProbe(inquiry);
+	TradingSystem system;
+	system.inquiryService.AddListener(&inquiryProbe);
+	system.Link();
+	double drivenSeconds = DriveMessages(system.inquiryService, messages, total);
+
+	ReportFlow("inquiry", messages.size(), connectorSeconds, drivenSeconds, { &inquiry, &total });
+}
+
+/**
+ * Generate data for a number of products and ticks per product, then run each flow of main.cpp
+ * twice with console printing off: once through its connector to measure the batched message rate,
+ * and once message by message to measure the latency at every service hop.
+ * Runs in a scratch directory so the result files of main.cpp are untouched.
+ */
+int BenchFlows(const vector<string>& args)
+{
+	string flow = args.size() > 0 ? args[0] : "all";
+	int productCount = args.size() > 1 ? stoi(args[1]) : 7;
+	int ticks = args.size() > 2 ? stoi(args[2]) : 10000;
+
+	filesystem::path workDir = filesystem::temp_directory_path() / "tradingsystem_benchmark";
+	filesystem::remove_all(workDir);
+	filesystem::create_directories(workDir / "data");
+	filesystem::create_directories(workDir / "result");
+	filesystem::current_path(workDir);
+
+	SampledSink::SetInterval(0);
+	vector<string> products = BenchProducts(productCount);
+	log(LogLevel::INFO, "Generating " + to_string(productCount) + " products x " + to_string(ticks) + " ticks...");
+	genOrderBook(products, "./data/prices.txt", "./data/marketdata.txt", 39373, ticks);
+	genTrades(products, "./data/trades.txt", 39373, ticks);
+	genInquiries(products, "./data/inquiries.txt", 39373, ticks);
+
+	if (flow == "all" || flow == "price") BenchPriceFlow("./data/prices.txt");
+	if (flow == "all" || flow == "marketdata") BenchMarketDataFlow("./data/marketdata.txt");
+	if (flow == "all" || flow == "trade") BenchTradeFlow("./data/trades.txt");
+	if (flow == "all" || flow == "inquiry") BenchInquiryFlow("./data/inquiries.txt");
+	return 0;
+}
+
+// Time the price chain pricing -> algo streaming -> streaming over in-memory prices, linked dynamically or statically
+double TimePriceChain(vector<Price<Bond>>& prices, bool linkStatic, bool batched)
+{
+	PricingService<Bond> pricingService;
+	AlgoStreamingService<Bond> algoStreamingService;
+	StreamingService<Bond> streamingService;
+	StaticPipeline<Price<Bond>, AlgoStreamingService<Bond>, StreamingService<Bond>> pipeline(algoStreamingService, streamingService);
+	if (linkStatic)
+	{
+		pricingService.AddListener(&pipeline);
+	}
+	else
+	{
+		pricingService.AddListener(algoStreamingService.GetAlgoStreamingListener());
+		algoStreamingService.AddListener(streamingService.GetStreamingServiceListener());
+	}
+
+	auto start = steady_clock::now();
+	if (batched)
+	{
+		for (size_t i = 0; i < prices.size(); i += CONNECTOR_BATCH_SIZE)
+		{
+			pricingService.OnMessageBatch(span<Price<Bond>>(prices).subspan(i, min(CONNECTOR_BATCH_SIZE, prices.size() - i)));
+		}
+	}
+	else
+	{
+		for (auto& price : prices)
+		{
+			pricingService.OnMessage(price);
+		}
+	}
+	return duration<double>(steady_clock::now() - start).count();
+}
+
+/**
+ * Compare the price chain linked through dynamic listeners with the static pipeline,
+ * one message at a time and in connector-sized batches, with console printing off.
+ */
+int BenchPipeline(const vector<string>& args)
+{
+	int ticks = args.size() > 0 ? stoi(args[0]) : 1000000;
+	SampledSink::SetInterval(0);
+	vector<string> products = BenchProducts(7);
+
+	vector<Price<Bond>> prices;
+	prices.reserve(ticks);
+	for (int i = 0; i < ticks; i++)
+	{
+		long mid = 99 * 256 + (i / 7) % 512;
+		prices.emplace_back(QueryProductHandle<Bond>(products[i % products.size()]), TickPrice(mid - 1), TickPrice(mid + 1));
+	}
+
+	cout << "price chain, " << ticks << " prices" << endl;
+	for (bool batched : { false, true })
+	{
+		double dynamicSeconds = TimePriceChain(prices, false, batched);
+		double staticSeconds = TimePriceChain(prices, true, batched);
+		cout << "  " << left << setw(12) << (batched ? "batched" : "per message") << right
+			<< " dynamic " << setw(8) << fixed << setprecision(1) << dynamicSeconds * 1e9 / ticks << " ns/msg"
+			<< "   static " << setw(8) << staticSeconds * 1e9 / ticks << " ns/msg" << endl;
+	}
+	return 0;
+}
+
+/**
+ * Run the price and market data flows through their connectors with the entry edges sharded by product
+ * over 1, 2, 4, ... workers, against the synchronous wiring. Generates its data in a scratch directory.
+ */
+int BenchSharded(const vector<string>& args)
+{
+	int productCount = args.size() > 0 ? stoi(args[0]) : 1000;
+	int ticks = args.size() > 1 ? stoi(args[1]) : 200;
+	size_t maxWorkers = args.size() > 2 ? stoul(args[2]) : max(1u, thread::hardware_concurrency());
+
+	filesystem::path workDir = filesystem::temp_directory_path() / "tradingsystem_benchmark";
+	filesystem::remove_all(workDir);
+	filesystem::create_directories(workDir / "data");
+	filesystem::create_directories(workDir / "result");
+	filesystem::current_path(workDir);
+
+	SampledSink::SetInterval(0);
+	vector<string> products = BenchProducts(productCount);
+	log(LogLevel::INFO, "Generating " + to_string(productCount) + " products x " + to_string(ticks) + " ticks...");
+	genOrderBook(products, "./data/prices.txt", "./data/marketdata.txt", 39373, ticks);
+
+	size_t messages = static_cast<size_t>(productCount) * ticks;
+	cout << "sharded flows, " << messages << " messages per flow" << endl;
+	cout << "  " << left << setw(12) << "workers" << right << setw(18) << "price msgs/s" << setw(18) << "marketdata msgs/s" << endl;
+	for (size_t workers = 0; workers <= maxWorkers; workers = (workers == 0) ? 1 : workers * 2)
+	{
+		double seconds[2];
+		for (int flow = 0; flow < 2; flow++)
+		{
+			TradingSystem system;
+			ServiceWiring wiring({});
+			if (workers > 0)
+			{
+				wiring.Shard({ "pricing-algostreaming", "marketdata-algoexecution", "tradebooking-position" }, workers);
+			}
+			system.Link(wiring);
+
+			auto start = steady_clock::now();
+			if (flow == 0)
+			{
+				system.pricingService.GetConnector()->Subscribe("./data/prices.txt");
+			}
+			else
+			{
+				system.marketDataService.GetConnector()->Subscribe("./data/marketdata.txt");
+			}
+			wiring.DrainAll();
+			seconds[flow] = duration<double>(steady_clock::now() - start).count();
+		}
+		cout << "  " << left << setw(12) << (workers == 0 ? string("sync") : to_string(workers)) << right
+			<< setw(18) << fixed << setprecision(0) << messages / seconds[0] << setw(18) << messages / seconds[1] << endl;
+	}
+	return 0;
+}
+
+/**
+ * Time the market data generator for a number of products and ticks per product, in CSV or binary,
+ * on 1, 2, 4, ... threads up to a maximum. Writes into a scratch directory.
+ */
+int BenchGenerate(const vector<string>& args)
+{
+	int productCount = args.size() > 0 ? stoi(args[0]) : 7;
+	int ticks = args.size() > 1 ? stoi(args[1]) : 1000000;
+	int maxThreads = args.size() > 2 ? stoi(args[2]) : static_cast<int>(max(1u, thread::hardware_concurrency()));
+	TickFormat format = (args.size() > 3 && args[3] == "binary") ? BINARY_TICKS : CSV_TICKS;
+
+	filesystem::path workDir = filesystem::temp_directory_path() / "tradingsystem_benchmark";
+	filesystem::remove_all(workDir);
+	filesystem::create_directories(workDir);
+	filesystem::current_path(workDir);
+	vector<string> products = BenchProducts(productCount);
+	auto start = system_clock::time_point(seconds(1790000000));
+
+	cout << "generate " << productCount << " products x " << ticks << " ticks, " << (format == CSV_TICKS ? "csv" : "binary") << endl;
+	for (int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		auto begin = steady_clock::now();
+		genOrderBook(products, "prices.dat", "marketdata.dat", 39373, ticks, threads, format, start);
+		double elapsed = duration<double>(steady_clock::now() - begin).count();
+		double megabytes = (filesystem::file_size("prices.dat") + filesystem::file_size("marketdata.dat")) / 1e6;
+		cout << "  threads " << setw(3) << threads << setw(12) << fixed << setprecision(3) << elapsed << " s"
+			<< setw(14) << setprecision(0) << 2.0 * productCount * ticks / elapsed << " rows/s"
+			<< setw(10) << setprecision(1) << megabytes / elapsed << " MB/s" << endl;
+	}
+	filesystem::remove("prices.dat");
+	filesystem::remove("marketdata.dat");
+	return 0;
+}
+
+/**
+ * Replay the price and market data flows from CSV files and from the tick files converted from them,
+ * timing the conversion and each replay through the connectors. Works in a scratch directory.
+ */
+int BenchReplay(const vector<string>& args)
+{
+	int productCount = args.size() > 0 ? stoi(args[0]) : 7;
+	int ticks = args.size() > 1 ? stoi(args[1]) : 200000;
+
+	filesystem::path workDir = filesystem::temp_directory_path() / "tradingsystem_benchmark";
+	filesystem::remove_all(workDir);
+	filesystem::create_directories(workDir / "data");
+	filesystem::create_directories(workDir / "result");
+	filesystem::current_path(workDir);
+
+	SampledSink::SetInterval(0);
+	vector<string> products = BenchProducts(productCount);
+	log(LogLevel::INFO, "Generating " + to_string(productCount) + " products x " + to_string(ticks) + " ticks...");
+	genOrderBook(products, "./data/prices.txt", "./data/marketdata.txt", 39373, ticks);
+
+	size_t messages = static_cast<size_t>(productCount) * ticks;
+	cout << "replay, " << messages << " messages per flow" << endl;
+	const string flows[2] = { "prices", "marketdata" };
+	for (int flow = 0; flow < 2; flow++)
+	{
+		string csvPath = "./data/" + flows[flow] + ".txt";
+		string tickPath = "./data/" + flows[flow] + ".ticks";
+		auto start = steady_clock::now();
+		convertTicks(csvPath, tickPath, flow == 0 ? PRICE_TICKS : BOOK_TICKS);
+		double convertSeconds = duration<double>(steady_clock::now() - start).count();
+
+		double seconds[2];
+		for (int binary = 0; binary < 2; binary++)
+		{
+			TradingSystem system;
+			system.Link();
+			start = steady_clock::now();
+			if (flow == 0)
+			{
+				binary ? system.pricingService.GetConnector()->SubscribeTicks(tickPath) : system.pricingService.GetConnector()->Subscribe(csvPath);
+			}
+			else
+			{
+				binary ? system.marketDataService.GetConnector()->SubscribeTicks(tickPath) : system.marketDataService.GetConnector()->Subscribe(csvPath);
+			}
+			seconds[binary] = duration<double>(steady_clock::now() - start).count();
+		}
+		cout << "  " << left << setw(12) << flows[flow] << right << fixed << setprecision(1)
+			<< " csv " << setw(8) << filesystem::file_size(csvPath) / 1e6 << " MB " << setw(8) << setprecision(3) << seconds[0] << " s"
+			<< "   ticks " << setw(8) << setprecision(1) << filesystem::file_size(tickPath) / 1e6 << " MB " << setw(8) << setprecision(3) << seconds[1] << " s"
+			<< "   convert " << setw(8) << convertSeconds << " s" << endl;
+	}
+	return 0;
+}
+
+/**
+ * Log price stream records, as the streaming connector prints them, from a number of threads:
+ * formatted and written synchronously with one flush per record, as the console used to be,
+ * against the asynchronous logger. Both write to /dev/null.
+ */
+int BenchLogger(const vector<string>& args)
+{
+	size_t records = args.size() > 0 ? stoul(args[0]) : 1000000;
+	int threads = args.size() > 1 ? stoi(args[1]) : 1;
+	const string text = "Price Stream (Product {}): \n\tBid\tPrice: {}\tVisibleQuantity: {}\tHiddenQuantity: {}\n"
+		"\tAsk\tPrice: {}\tVisibleQuantity: {}\tHiddenQuantity: {}\n";
+
+	auto run = [&](const function<void(size_t)>& body) {
+		auto start = steady_clock::now();
+		vector<thread> workers;
+		for (int t = 0; t < threads; t++)
+		{
+			workers.emplace_back([&, t]() {
+				for (size_t i = t; i < records; i += threads)
+				{
+					body(i);
+				}
+			});
+		}
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+		return duration<double>(steady_clock::now() - start).count();
+	};
+
+	// synchronous: format under a lock and flush every record
+	ofstream devNull("/dev/null");
+	devNull << fixed << setprecision(6);
+	mutex lock;
+	double syncSeconds = run([&](size_t i) {
+		double bid = 99.0 + (i % 256) / 256.0;
+		lock_guard<mutex> guard(lock);
+		devNull << "Price Stream " << "(Product " << "9128283H1" << "): \n"
+			<< "\tBid\t" << "Price: " << bid << "\tVisibleQuantity: " << 1000000 << "\tHiddenQuantity: " << 2000000 << "\n"
+			<< "\tAsk\t" << "Price: " << bid + 1.0 / 128 << "\tVisibleQuantity: " << 1000000 << "\tHiddenQuantity: " << 2000000 << endl;
+	});
+
+	// asynchronous: the producers only copy the arguments, the writer formats
+	AsyncLogger& logger = AsyncLogger::Instance();
+	int fd = open("/dev/null", O_WRONLY);
+	logger.SetOutput(fd);
+	LogFormat format(text);
+	string product = "9128283H1";
+	auto start = steady_clock::now();
+	double producerSeconds = run([&](size_t i) {
+		double bid = 99.0 + (i % 256) / 256.0;
+		logger.Log(format, product, bid, 1000000, 2000000, bid + 1.0 / 128, 1000000, 2000000);
+	});
+	logger.Flush();
+	double asyncSeconds = duration<double>(steady_clock::now() - start).count();
+	logger.SetOutput(STDOUT_FILENO);
+	close(fd);
+
+	cout << "logger, " << records << " records on " << threads << " threads" << endl;
+	cout << "  " << left << setw(28) << "synchronous, flushed" << right << setw(10) << fixed << setprecision(1) << syncSeconds * 1e9 / records << " ns/record" << endl;
+	cout << "  " << left << setw(28) << "asynchronous, producer" << right << setw(10) << producerSeconds * 1e9 / records << " ns/record" << endl;
+	cout << "  " << left << setw(28) << "asynchronous, until written" << right << setw(10) << asyncSeconds * 1e9 / records << " ns/record" << endl;
+	return 0;
+}
+
+/**
+ * Schedule timers with delays up to a minute, cancel half of them and run the rest to expiry,
+ * on the timer wheel and on an ordered multimap of expiries; then the cost of a clock read
+ * against a cached clock read, and of a throttled GUI price.
+ */
+int BenchTimers(const vector<string>& args)
+{
+	size_t count = args.size() > 0 ? stoul(args[0]) : 1000000;
+
+	mt19937_64 random(39373);
+	vector<int64_t> delays(count);
+	for (auto& delay : delays)
+	{
+		delay = 1 + static_cast<int64_t>(random() % 60000);
+	}
+
+	// timer wheel
+	size_t wheelFired = 0;
+	auto start = steady_clock::now();
+	{
+		TimerWheel wheel(0);
+		vector<TimerId> ids(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			ids[i] = wheel.Add(delays[i], [&wheelFired]() { wheelFired++; });
+		}
+		for (size_t i = 0; i < count; i += 2)
+		{
+			wheel.Remove(ids[i]);
+		}
+		vector<function<void()>> expired;
+		for (int64_t now = 1; now <= 60000; now++)
+		{
+			wheel.Advance(now, expired);
+			for (auto& callback : expired)
+			{
+				callback();
+			}
+			expired.clear();
+		}
+	}
+	double wheelSeconds = duration<double>(steady_clock::now() - start).count();
+
+	// ordered map of expiries
+	size_t mapFired = 0;
+	start = steady_clock::now();
+	{
+		multimap<int64_t, function<void()>> timers;
+		vector<multimap<int64_t, function<void()>>::iterator> ids(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			ids[i] = timers.emplace(delays[i], [&mapFired]() { mapFired++; });
+		}
+		for (size_t i = 0; i < count; i += 2)
+		{
+			timers.erase(ids[i]);
+		}
+		for (int64_t now = 1; now <= 60000; now++)
+		{
+			while (!timers.empty() && timers.begin()->first <= now)
+			{
+				timers.begin()->second();
+				timers.erase(timers.begin());
+			}
+		}
+	}
+	double mapSeconds = duration<double>(steady_clock::now() - start).count();
+
+	cout << "timers, " << count << " scheduled, half cancelled, 60000 ticks" << endl;
+	cout << "  " << left << setw(24) << "TimerWheel" << right << setw(10) << fixed << setprecision(1) << wheelSeconds * 1e9 / count << " ns/timer, " << wheelFired << " fired" << endl;
+	cout << "  " << left << setw(24) << "multimap" << right << setw(10) << mapSeconds * 1e9 / count << " ns/timer, " << mapFired << " fired" << endl;
+
+	// clock reads
+	size_t reads = 10000000;
+	volatile int64_t sink = 0;
+	start = steady_clock::now();
+	for (size_t i = 0; i < reads; i++)
+	{
+		sink = sink + system_clock::now().time_since_epoch().count();
+	}
+	double systemSeconds = duration<double>(steady_clock::now() - start).count();
+	CachedClock& clock = CachedClock::Instance();
+	start = steady_clock::now();
+	for (size_t i = 0; i < reads; i++)
+	{
+		sink = sink + clock.GetMillis();
+	}
+	double cachedSeconds = duration<double>(steady_clock::now() - start).count();
+	cout << "  " << left << setw(24) << "system_clock::now" << right << setw(10) << systemSeconds * 1e9 / reads << " ns/read" << endl;
+	cout << "  " << left << setw(24) << "CachedClock" << right << setw(10) << cachedSeconds * 1e9 / reads << " ns/read" << endl;
+
+	// throttled gui prices, conflated between timer firings
+	RegisterProducts<Bond>();
+	vector<ProductHandle> handles;
+	for (auto& item : productConstructors<Bond>)
+	{
+		handles.push_back(ProductRegistry<Bond>::Instance().GetHandle(item.first));
+	}
+	size_t prices = 10000000;
+	{
+		GUIService<Bond> guiService;
+		vector<Price<Bond>> quotes;
+		for (auto handle : handles)
+		{
+			quotes.push_back(Price<Bond>(handle, TickPrice::FromDouble(99.0), TickPrice::FromDouble(99.0 + 1.0 / 128)));
+		}
+		start = steady_clock::now();
+		for (size_t i = 0; i < prices; i++)
+		{
+			guiService.PublishThrottledPrice(quotes[i % quotes.size()]);
+		}
+		double guiSeconds = duration<double>(steady_clock::now() - start).count();
+		cout << "  " << left << setw(24) << "GUIService" << right << setw(10) << guiSeconds * 1e9 / prices << " ns/price over " << guiSeconds << " s" << endl;
+	}
+	return wheelFired == mapFired ? 0 : 1;
+}
+
+/**
+ * Publish prices through the GUI service with and without the shared memory snapshot while reader
+ * threads poll the snapshot, and check that every quote a reader sees is one that was written whole.
+ */
+int BenchSnapshot(const vector<string>& args)
+{
+	size_t prices = args.size() > 0 ? stoul(args[0]) : 10000000;
+	int readers = args.size() > 1 ? stoi(args[1]) : 2;
+
+	RegisterProducts<Bond>();
+	vector<Price<Bond>> quotes;
+	for (auto& item : productConstructors<Bond>)
+	{
+		ProductHandle handle = ProductRegistry<Bond>::Instance().GetHandle(item.first);
+		quotes.push_back(Price<Bond>(handle, TickPrice::FromDouble(99.0), TickPrice::FromDouble(99.0 + 1.0 / 128)));
+	}
+	// bid and offer move together, a torn quote shows up as a wrong spread
+	auto quoteAt = [&](size_t i) {
+		Price<Bond>& quote = quotes[i % quotes.size()];
+		TickPrice bid(quote.GetBid().GetTicks() + static_cast<long>(i % 64));
+		return Price<Bond>(quote.GetProductHandle(), bid, bid + TickPrice(TickPrice::FromDouble(1.0 / 128).GetTicks()), static_cast<int64_t>(i));
+	};
+
+	double plainSeconds;
+	{
+		GUIService<Bond> guiService;
+		auto start = steady_clock::now();
+		for (size_t i = 0; i < prices; i++)
+		{
+			Price<Bond> price = quoteAt(i);
+			guiService.PublishThrottledPrice(price);
+		}
+		plainSeconds = duration<double>(steady_clock::now() - start).count();
+	}
+
+	double snapshotSeconds;
+	atomic<bool> done(false);
+	atomic<size_t> reads(0), torn(0);
+	{
+		GUIService<Bond> guiService;
+		guiService.EnableSnapshot(GUI_SNAPSHOT_NAME + "_benchmark");
+		vector<thread> threads;
+		for (int r = 0; r < readers; r++)
+		{
+			threads.emplace_back([&]() {
+				GUISnapshotReader reader(GUI_SNAPSHOT_NAME + "_benchmark");
+				GUIQuote quote;
+				size_t count = 0, bad = 0;
+				while (!done.load(memory_order_relaxed))
+				{
+					for (size_t slot = 0; slot < reader.GetUsed(); slot++)
+					{
+						if (reader.Read(slot, quote))
+						{
+							count++;
+							bad += (quote.offer - quote.bid != 1.0 / 128);
+						}
+					}
+				}
+				reads += count;
+				torn += bad;
+			});
+		}
+		auto start = steady_clock::now();
+		for (size_t i = 0; i < prices; i++)
+		{
+			Price<Bond> price = quoteAt(i);
+			guiService.PublishThrottledPrice(price);
+		}
+		snapshotSeconds = duration<double>(steady_clock::now() - start).count();
+		done.store(true);
+		for (auto& reader : threads)
+		{
+			reader.join();
+		}
+	}
+
+	cout << "gui snapshot, " << prices << " prices, " << readers << " readers" << endl;
+	cout << "  " << left << setw(24) << "throttle only" << right << setw(10) << fixed << setprecision(1) << plainSeconds * 1e9 / prices << " ns/price" << endl;
+	cout << "  " << left << setw(24) << "throttle and snapshot" << right << setw(10) << snapshotSeconds * 1e9 / prices << " ns/price" << endl;
+	cout << "  " << reads.load() << " quotes read, " << torn.load() << " torn" << endl;
+	return torn.load() == 0 ? 0 : 1;
+}
+
+// Sector listener counting the sector updates
+template<typename T>
+class SectorCounter : public ServiceListener<PV01<BucketedSector<T>>>
+{
+
+public:
+	void ProcessAdd(PV01<BucketedSector<T>>& data) override { updates++; }
+	void ProcessRemove(PV01<BucketedSector<T>>& data) override {}
+	void ProcessUpdate(PV01<BucketedSector<T>>& data) override {}
+
+	size_t updates = 0;
+
+};
+
+/**
+ * Apply random positions to the risk service and read the risk of every standard sector after each one,
+ * by rescanning the products of the sector as GetBucketedRisk used to and from the running totals.
+ */
+int BenchSectors(const vector<string>& args)
+{
+	size_t count = args.size() > 0 ? stoul(args[0]) : 1000000;
+
+	RegisterProducts<Bond>();
+	RiskService<Bond> riskService;
+	SectorCounter<Bond> counter;
+	riskService.AddSectorListener(&counter);
+
+	vector<BucketedSector<Bond>> sectors;
+	for (auto& item : sectorCusips)
+	{
+		vector<Bond> products;
+		for (auto& cusip : item.second)
+		{
+			products.push_back(QueryProduct<Bond>(cusip));
+		}
+		sectors.push_back(BucketedSector<Bond>(products, item.first));
+	}
+	// the standard sectors are tracked already, adding them again returns their handles
+	vector<ProductHandle> sectorHandles;
+	for (auto& sector : sectors)
+	{
+		sectorHandles.push_back(riskService.AddSector(sector));
+	}
+	vector<Position<Bond>> positions;
+	for (auto& item : productConstructors<Bond>)
+	{
+		positions.push_back(Position<Bond>(ProductRegistry<Bond>::Instance().GetHandle(item.first)));
+	}
+
+	// the scan GetBucketedRisk used to do on every call
+	auto rescan = [&](const BucketedSector<Bond>& sector) {
+		double total = 0.0;
+		for (auto& product : sector.GetProducts())
+		{
+			ProductHandle handle;
+			if (ProductRegistry<Bond>::Instance().Find(product.GetProductId(), handle))
+			{
+				try
+				{
+					PV01<Bond>& stored = riskService.GetData(handle);
+					total += stored.GetPV01() * stored.GetQuantity();
+				}
+				catch (const runtime_error&)
+				{
+				}
+			}
+		}
+		return total;
+	};
+
+	mt19937_64 random(39373);
+	double scanSeconds = 0.0, runningSeconds = 0.0, maxError = 0.0;
+	volatile double sink = 0.0;
+	for (size_t i = 0; i < count; i++)
+	{
+		Position<Bond>& position = positions[random() % positions.size()];
+		position.AddPosition(i % 2 ? "TRSY1" : "TRSY2", static_cast<long>(random() % 2000000) - 1000000);
+		riskService.AddPosition(position);
+
+		auto start = steady_clock::now();
+		double scanned[3];
+		for (size_t s = 0; s < sectors.size(); s++)
+		{
+			scanned[s] = rescan(sectors[s]);
+		}
+		auto middle = steady_clock::now();
+		double running[3];
+		for (size_t s = 0; s < sectors.size(); s++)
+		{
+			running[s] = riskService.GetBucketedRisk(sectorHandles[s]).GetPV01();
+		}
+		auto end = steady_clock::now();
+		scanSeconds += duration<double>(middle - start).count();
+		runningSeconds += duration<double>(end - middle).count();
+		for (size_t s = 0; s < sectors.size(); s++)
+		{
+			sink = sink + running[s];
+			double error = abs(scanned[s] - running[s]) / max(1.0, abs(scanned[s]));
+			maxError = max(maxError, error);
+		}
+	}
+
+	size_t reads = count * sectors.size();
+	cout << "sectors, " << count << " positions, " << sectors.size() << " sectors read after each" << endl;
+	cout << "  " << left << setw(24) << "rescan" << right << setw(10) << fixed << setprecision(1) << scanSeconds * 1e9 / reads << " ns/read" << endl;
+	cout << "  " << left << setw(24) << "running totals" << right << setw(10) << runningSeconds * 1e9 / reads << " ns/read" << endl;
+	cout << "  " << counter.updates << " sector updates, max relative difference " << scientific << setprecision(2) << maxError << endl;
+	return maxError < 1e-9 ? 0 : 1;
+}
+
+/**
+ * Apply random positions and prices to the risk service and compare the running key rate ladders of the
+ * book and of its sectors with a rescan of every product after each of them.
+ */
+int BenchKeyRates(const vector<string>& args)
+{
+	size_t count = args.size() > 0 ? stoul(args[0]) : 1000000;
+	size_t priceEvery = args.size() > 1 ? stoul(args[1]) : 4;
+
+	RegisterProducts<Bond>();
+	RiskService<Bond> riskService;
+	vector<ProductHandle> sectorHandles;
+	for (auto& item : sectorCusips)
+	{
+		sectorHandles.push_back(ProductRegistry<BucketedSector<Bond>>::Instance().GetHandle(item.first));
+	}
+	vector<Position<Bond>> positions;
+	vector<long> mids;
+	for (auto& item : productConstructors<Bond>)
+	{
+		positions.push_back(Position<Bond>(ProductRegistry<Bond>::Instance().GetHandle(item.first)));
+		mids.push_back(TickPrice::FromDouble(99.0).GetTicks());
+	}
+
+	// the ladders summed over every product held
+	auto rescan = [&](vector<KeyRateVector>& ladders) {
+		for (auto& ladder : ladders)
+		{
+			ladder.fill(0.0);
+		}
+		for (auto& position : positions)
+		{
+			ProductHandle product = position.GetProductHandle();
+			long quantity;
+			try
+			{
+				quantity = riskService.GetData(product).GetQuantity();
+			}
+			catch (const runtime_error&)
+			{
+				continue;
+			}
+			KeyRateVector unit = riskService.GetKeyRates(product);
+			const string& productId = position.GetProduct().GetProductId();
+			for (size_t s = 0; s < ladders.size(); s++)
+			{
+				bool held = s == 0;
+				if (!held)
+				{
+					const vector<string>& cusips = sectorCusips[s - 1].second;
+					held = find(cusips.begin(), cusips.end(), productId) != cusips.end();
+				}
+				for (int i = 0; held && i < KEY_RATE_COUNT; i++)
+				{
+					ladders[s][i] += unit[i] * quantity;
+				}
+			}
+		}
+	};
+
+	mt19937_64 random(39373);
+	vector<KeyRateVector> scanned(sectorHandles.size() + 1), running(sectorHandles.size() + 1);
+	double scanSeconds = 0.0, runningSeconds = 0.0, maxError = 0.0;
+	size_t prices = 0;
+	for (size_t n = 0; n < count; n++)
+	{
+		size_t k = random() % positions.size();
+		if (priceEvery > 0 && n % priceEvery == 0)
+		{
+			mids[k] += static_cast<long>(random() % 5) - 2;
+			Price<Bond> price(positions[k].GetProductHandle(), TickPrice(mids[k]), TickPrice(mids[k] + 2));
+			riskService.AddPrices(span<Price<Bond>>(&price, 1));
+			prices++;
+		}
+		else
+		{
+			positions[k].AddPosition(n % 2 ? "TRSY1" : "TRSY2", static_cast<long>(random() % 2000000) - 1000000);
+			riskService.AddPosition(positions[k]);
+		}
+
+		auto start = steady_clock::now();
+		rescan(scanned);
+		auto middle = steady_clock::now();
+		running[0] = riskService.GetPortfolioKeyRates();
+		for (size_t s = 0; s < sectorHandles.size(); s++)
+		{
+			running[s + 1] = riskService.GetBucketedKeyRates(sectorHandles[s]);
+		}
+		auto end = steady_clock::now();
+		scanSeconds += duration<double>(middle - start).count();
+		runningSeconds += duration<double>(end - middle).count();
+		for (size_t s = 0; s < running.size(); s++)
+		{
+			for (int i = 0; i < KEY_RATE_COUNT; i++)
+			{
+				maxError = max(maxError, abs(scanned[s][i] - running[s][i]) / max(1.0, abs(scanned[s][i])));
+			}
+		}
+	}
+
+	cout << "key rates, " << count - prices << " positions and " << prices << " prices, book and " << sectorHandles.size()
+		<< " sector ladders read after each" << endl;
+	cout << "  " << left << setw(24) << "rescan" << right << setw(10) << fixed << setprecision(1) << scanSeconds * 1e9 / count << " ns/refresh" << endl;
+	cout << "  " << left << setw(24) << "running ladders" << right << setw(10) << runningSeconds * 1e9 / count << " ns/refresh" << endl;
+	cout << "  max relative difference " << scientific << setprecision(2) << maxError << endl;
+	return maxError < 1e-9 ? 0 : 1;
+}
+
+/**
+ * Check the yields and PV01 of the live PV01 engine against a coupon-by-coupon valuation, then feed it
+ * random price moves in batches and compare solving the moved products with revaluing every product.
+ */
+int BenchLivePV01(const vector<string>& args)
+{
+	int productCount = args.size() > 0 ? stoi(args[0]) : 1000;
+	size_t prices = args.size() > 1 ? stoul(args[1]) : 1000000;
+	size_t batchSize = args.size() > 2 ? stoul(args[2]) : 64;
+
+	vector<string> products = BenchProducts(productCount);
+	vector<ProductHandle> handles;
+	for (auto& product : products)
+	{
+		handles.push_back(ProductRegistry<Bond>::Instance().GetHandle(product));
+	}
+
+	// accuracy: price each treasury coupon by coupon at a grid of yields and solve the yields back
+	double maxYieldError = 0.0, maxPV01Error = 0.0;
+	for (size_t b = 0; b < 7; b++)
+	{
+		const Bond& bond = ProductRegistry<Bond>::Instance().Get(handles[b]);
+		date next = bond.GetMaturityDate();
+		while (next - boost::gregorian::months(6) > PV01_SETTLEMENT)
+		{
+			next = next - boost::gregorian::months(6);
+		}
+		double w = static_cast<double>((next - PV01_SETTLEMENT).days()) / static_cast<double>((next - (next - boost::gregorian::months(6))).days());
+		int n = 0;
+		for (date d = next; d <= bond.GetMaturityDate(); d = d + boost::gregorian::months(6))
+		{
+			n++;
+		}
+		double coupon = 100.0 * bond.GetCoupon() / 2;
+		auto reference = [&](double y) {
+			double price = 0.0;
+			for (int k = 0; k < n; k++)
+			{
+				price += (coupon + (k == n - 1 ? 100.0 : 0.0)) / pow(1.0 + y / 2, k + w);
+			}
+			return price;
+		};
+		for (double y = 0.005; y < 0.08; y += 0.0025)
+		{
+			double dirty = reference(y), periods = n, yield = bond.GetCoupon(), pv01Value;
+			SolveBondYields(1, &dirty, &coupon, &periods, &w, 2, &yield, &pv01Value);
+			pv01Value *= PV01_FACE / 100.0;
+			double expected = (reference(y - 0.00005) - reference(y + 0.00005)) * PV01_FACE / 100.0;
+			maxYieldError = max(maxYieldError, abs(yield - y));
+			maxPV01Error = max(maxPV01Error, abs(pv01Value - expected) / expected);
+		}
+	}
+	cout << "accuracy: max yield error " << scientific << setprecision(2) << maxYieldError
+		<< ", max relative PV01 error " << maxPV01Error << " against coupon by coupon valuation" << endl;
+
+	// throughput: a random walk of mids, a batch at a time
+	mt19937_64 random(39373);
+	vector<long> mids(handles.size(), TickPrice::FromDouble(99.0).GetTicks());
+	vector<Price<Bond>> batch;
+	vector<ProductHandle> changed;
+	PV01Engine<Bond> engine;
+	size_t solved = 0;
+	auto start = steady_clock::now();
+	for (size_t i = 0; i < prices; i += batchSize)
+	{
+		batch.clear();
+		for (size_t j = 0; j < batchSize; j++)
+		{
+			size_t k = random() % handles.size();
+			mids[k] += static_cast<long>(random() % 3) - 1;
+			batch.push_back(Price<Bond>(handles[k], TickPrice(mids[k]), TickPrice(mids[k] + 2)));
+		}
+		changed.clear();
+		engine.Update(batch, changed);
+		solved += changed.size();
+	}
+	double incremental = duration<double>(steady_clock::now() - start).count();
+
+	// the same batches revaluing every product
+	vector<Price<Bond>> all;
+	for (size_t k = 0; k < handles.size(); k++)
+	{
+		all.push_back(Price<Bond>(handles[k], TickPrice(mids[k]), TickPrice(mids[k] + 2)));
+	}
+	size_t sweeps = max<size_t>(1, prices / batchSize / 100);
+	start = steady_clock::now();
+	for (size_t i = 0; i < sweeps; i++)
+	{
+		// move every mid so every product is solved again
+		for (auto& price : all)
+		{
+			long mid = price.GetBid().GetTicks() + (i % 2 ? 1 : -1);
+			price = Price<Bond>(price.GetProductHandle(), TickPrice(mid), TickPrice(mid + 2));
+		}
+		changed.clear();
+		engine.Update(all, changed);
+	}
+	double sweep = duration<double>(steady_clock::now() - start).count() / sweeps * (prices / batchSize);
+
+	cout << "live PV01, " << handles.size() << " products, " << prices << " prices in batches of " << batchSize << endl;
+	cout << "  " << left << setw(24) << "moved products" << right << setw(10) << fixed << setprecision(1) << incremental * 1e9 / prices
+		<< " ns/price, " << solved << " solves" << endl;
+	cout << "  " << left << setw(24) << "full revaluation" << right << setw(10) << sweep * 1e9 / prices << " ns/price (estimated from " << sweeps << " sweeps)" << endl;
+	return maxYieldError < 1e-10 && maxPV01Error < 1e-6 ? 0 : 1;
+}
+
+/**
+ * Check the closed-form bond analytics against CalculatePV01 and a coupon-by-coupon valuation, then value
+ * a grid of bonds and parallel yield shifts in one call and compare with valuing each point coupon by coupon.
+ */
+int BenchBondAnalytics(const vector<string>& args)
+{
+	size_t bondCount = args.size() > 0 ? stoul(args[0]) : 10000;
+	size_t scenarioCount = args.size() > 1 ? stoul(args[1]) : 200;
+
+	// accuracy: the static PV01 of the treasuries, whole years on a coupon date
+	double maxPV01Error = 0.0;
+	int years[] = { 2, 3, 5, 7, 10, 20, 30 };
+	for (int tenor : years)
+	{
+		for (double y = 0.0025; y < 0.1; y += 0.0025)
+		{
+			double expected = CalculatePV01(1000, 0.025, y, tenor, 2);
+			maxPV01Error = max(maxPV01Error, abs(BondPV01(GetBondTerms(0.025, tenor), y, 1000) - expected) / expected);
+		}
+	}
+
+	// accuracy: random bonds between coupon dates, including yields around zero, against the cash flows summed
+	mt19937_64 random(2718);
+	uniform_real_distribution<double> unit(0.0, 1.0);
+	double maxPriceError = 0.0, maxDV01Error = 0.0, maxConvexityError = 0.0;
+	for (int i = 0; i < 10000; i++)
+	{
+		BondTerms terms;
+		terms.coupon = 4.0 * unit(random);
+		terms.periods = 1 + random() % 60;
+		terms.fraction = max(unit(random), 1e-3);
+		double y = -0.01 + 0.11 * unit(random);
+		BondRisk risk = AnalyzeBond(terms, y);
+
+		double price, first, second;
+		SumBondMoments(terms.coupon, terms.periods, terms.fraction, y / 2, price, first, second);
+		double v = 1.0 / (1.0 + y / 2);
+		double dv01 = v * first / 2.0 * 1e-4;
+		double convexity = v * v * second / price / 4.0;
+		maxPriceError = max(maxPriceError, abs(risk.price - price) / price);
+		maxDV01Error = max(maxDV01Error, abs(risk.dv01 - dv01) / dv01);
+		maxConvexityError = max(maxConvexityError, abs(risk.convexity - convexity) / convexity);
+	}
+	cout << "accuracy: max relative PV01 error " << scientific << setprecision(2) << maxPV01Error << " against CalculatePV01" << endl;
+	cout << "          max relative error against coupon by coupon valuation: price " << maxPriceError
+		<< ", DV01 " << maxDV01Error << ", convexity " << maxConvexityError << endl;
+
+	// throughput: bonds of 1 to 30 years, parallel shifts of -300bp to +300bp
+	vector<double> coupon(bondCount), periods(bondCount), fraction(bondCount), yields(bondCount), shifts(scenarioCount);
+	for (size_t i = 0; i < bondCount; i++)
+	{
+		coupon[i] = 0.5 + 2.5 * unit(random);
+		periods[i] = 2 + random() % 59;
+		fraction[i] = max(unit(random), 1e-3);
+		yields[i] = 0.035 + 0.015 * unit(random);
+	}
+	for (size_t j = 0; j < scenarioCount; j++)
+	{
+		shifts[j] = scenarioCount > 1 ? -0.03 + 0.06 * j / (scenarioCount - 1) : 0.0;
+	}
+	vector<double> prices(bondCount * scenarioCount), dv01s(bondCount * scenarioCount);
+	auto start = steady_clock::now();
+	PriceBondGrid(bondCount, coupon.data(), periods.data(), fraction.data(), 2, yields.data(), scenarioCount, shifts.data(),
+		prices.data(), dv01s.data());
+	double grid = duration<double>(steady_clock::now() - start).count();
+
+	// coupon by coupon on a sample of the scenarios
+	size_t sampled = min<size_t>(scenarioCount, 10);
+	double checksum = 0.0, maxGridError = 0.0;
+	start = steady_clock::now();
+	for (size_t j = 0; j < sampled; j++)
+	{
+		for (size_t i = 0; i < bondCount; i++)
+		{
+			double r = (yields[i] + shifts[j]) / 2, price = 0.0;
+			int count = static_cast<int>(periods[i]);
+			for (int k = 0; k < count; k++)
+			{
+				price += (coupon[i] + (k == count - 1 ? 100.0 : 0.0)) / pow(1.0 + r, k + fraction[i]);
+			}
+			checksum += price;
+			maxGridError = max(maxGridError, abs(prices[j * bondCount + i] - price) / price);
+		}
+	}
+	double loop = duration<double>(steady_clock::now() - start).count() / sampled * scenarioCount;
+
+	size_t points = bondCount * scenarioCount;
+	cout << "bond grid, " << bondCount << " bonds x " << scenarioCount << " scenarios, max relative price error "
+		<< maxGridError << " (checksum " << fixed << setprecision(0) << checksum << ")" << endl;
+	cout << "  " << left << setw(24) << "closed form" << right << setw(10) << setprecision(1) << grid * 1e9 / points
+		<< " ns/point, " << setprecision(3) << grid * 1e3 << " ms, price and DV01" << endl;
+	cout << "  " << left << setw(24) << "coupon by coupon" << right << setw(10) << setprecision(1) << loop * 1e9 / points
+		<< " ns/point, " << setprecision(3) << loop * 1e3 << " ms, price only (estimated from " << sampled << " scenarios)" << endl;
+	return maxPV01Error < 1e-9 && maxPriceError < 1e-12 && maxDV01Error < 1e-10 && maxConvexityError < 1e-10 && maxGridError < 1e-12 ? 0 : 1;
+}
+
+/**
+ * Feed random trades and prices to the PnL service and time them, then check its PnL against replaying
+ * every trade of each product and book and marking the result at the last mid.
+ */
+int BenchPnL(const vector<string>& args)
+{
+	size_t count = args.size() > 0 ? stoul(args[0]) : 1000000;
+	size_t priceEvery = args.size() > 1 ? stoul(args[1]) : 2;
+
+	RegisterProducts<Bond>();
+	PnLService<Bond> service;
+	vector<ProductHandle> handles;
+	vector<long> mids;
+	for (auto& item : productConstructors<Bond>)
+	{
+		handles.push_back(ProductRegistry<Bond>::Instance().GetHandle(item.first));
+		mids.push_back(TickPrice::FromDouble(99.0).GetTicks());
+	}
+	vector<string> books = { "TRSY1", "TRSY2", "TRSY3" };
+
+	mt19937_64 random(39373);
+	vector<Trade<Bond>> trades;
+	size_t prices = 0;
+	double tradeSeconds = 0.0, priceSeconds = 0.0;
+	for (size_t n = 0; n < count; n++)
+	{
+		size_t k = random() % handles.size();
+		if (priceEvery > 0 && n % priceEvery == 0)
+		{
+			mids[k] += static_cast<long>(random() % 5) - 2;
+			Price<Bond> price(handles[k], TickPrice(mids[k]), TickPrice(mids[k] + 2));
+			auto start = steady_clock::now();
+			service.AddPrices(span<Price<Bond>>(&price, 1));
+			priceSeconds += duration<double>(steady_clock::now() - start).count();
+			prices++;
+		}
+		else
+		{
+			Side side = random() % 2 ? BUY : SELL;
+			long quantity = (1 + static_cast<long>(random() % 10)) * 1000000;
+			TickPrice price(mids[k] + static_cast<long>(random() % 5) - 2);
+			trades.push_back(Trade<Bond>(handles[k], "T" + to_string(n), price, books[random() % books.size()], quantity, side));
+			auto start = steady_clock::now();
+			service.AddTrade(trades.back());
+			tradeSeconds += duration<double>(steady_clock::now() - start).count();
+		}
+	}
+
+	// replay the trades of every product and book with the average cost rule
+	double maxError = 0.0, bookRealised[3] = {}, bookUnrealised[3] = {};
+	bool bookTraded[3] = {};
+	for (size_t k = 0; k < handles.size(); k++)
+	{
+		double mark = (mids[k] + 1) / static_cast<double>(TICKS_PER_POINT);
+		double productTotal = 0.0;
+		for (size_t b = 0; b < books.size(); b++)
+		{
+			long position = 0;
+			double average = 0.0, realised = 0.0;
+			bool traded = false;
+			for (auto& trade : trades)
+			{
+				if (trade.GetProductHandle() != handles[k] || trade.GetBook() != books[b])
+				{
+					continue;
+				}
+				traded = true;
+				long change = trade.GetSide() == BUY ? trade.GetQuantity() : -trade.GetQuantity();
+				double price = trade.GetPrice();
+				if (position == 0 || (position > 0) == (change > 0))
+				{
+					average = (average * labs(position) + price * labs(change)) / labs(position + change);
+				}
+				else
+				{
+					long closed = min(labs(change), labs(position));
+					realised += (position > 0 ? 1.0 : -1.0) * closed * (price - average) / PRICE_FACE;
+					if (position + change == 0)
+					{
+						average = 0.0;
+					}
+					else if ((position + change > 0) != (position > 0))
+					{
+						average = price;
+					}
+				}
+				position += change;
+			}
+			if (!traded)
+			{
+				continue;
+			}
+			double unrealised = position * (mark - average) / PRICE_FACE;
+			PnL<Bond> pnl = service.GetPnL(handles[k], books[b]);
+			maxError = max(maxError, abs(pnl.GetRealised() - realised) / max(1.0, abs(realised)));
+			maxError = max(maxError, abs(pnl.GetUnrealised() - unrealised) / max(1.0, abs(unrealised)));
+			bookTraded[b] = true;
+			bookRealised[b] += realised;
+			bookUnrealised[b] += unrealised;
+			productTotal += realised + unrealised;
+		}
+		maxError = max(maxError, abs(service.GetData(handles[k]).GetTotal() - productTotal) / max(1.0, abs(productTotal)));
+	}
+	for (size_t b = 0; b < books.size(); b++)
+	{
+		double realised, unrealised;
+		if (!service.GetBookPnL(books[b], realised, unrealised))
+		{
+			if (bookTraded[b])
+			{
+				cout << "pnl, book " << books[b] << " traded but has no PnL" << endl;
+				return 1;
+			}
+			continue;
+		}
+		maxError = max(maxError, abs(realised - bookRealised[b]) / max(1.0, abs(bookRealised[b])));
+		maxError = max(maxError, abs(unrealised - bookUnrealised[b]) / max(1.0, abs(bookUnrealised[b])));
+	}
+
+	cout << "pnl, " << trades.size() << " trades and " << prices << " prices on " << handles.size() << " products x " << books.size() << " books" << endl;
+	cout << "  " << left << setw(24) << "trade" << right << setw(10) << fixed << setprecision(1) << tradeSeconds * 1e9 / max<size_t>(1, trades.size()) << " ns/trade" << endl;
+	cout << "  " << left << setw(24) << "price" << right << setw(10) << priceSeconds * 1e9 / max<size_t>(1, prices) << " ns/price" << endl;
+	cout << "  max relative difference " << scientific << setprecision(2) << maxError << " against replaying every trade" << endl;
+	return maxError < 1e-9 ? 0 : 1;
+}
+
+// Count the scenario results published
+class ScenarioCounter : public ServiceListener<ScenarioRisk<Bond>>
+{
+public:
+	size_t results = 0;
+	void ProcessAdd(ScenarioRisk<Bond>& data) override { results++; }
+	void ProcessRemove(ScenarioRisk<Bond>& data) override {}
+	void ProcessUpdate(ScenarioRisk<Bond>& data) override {}
+	void ProcessAddBatch(span<ScenarioRisk<Bond>> batch) override { results += batch.size(); }
+};
+
+/**
+ * Evaluate a grid of parallel, twist and key rate scenarios over a book of random positions, check some
+ * scenarios against revaluing every bond coupon by coupon and time the whole grid.
+ */
+int BenchScenarios(const vector<string>& args)
+{
+	int productCount = args.size() > 0 ? stoi(args[0]) : 10000;
+	size_t scenarioCount = args.size() > 1 ? stoul(args[1]) : 200;
+	size_t workers = args.size() > 2 ? stoul(args[2]) : 0;
+
+	vector<string> products = BenchProducts(productCount);
+	ScenarioRiskService<Bond> service(workers);
+	ScenarioCounter counter;
+	service.AddListener(&counter);
+
+	// a third each of parallel shifts, twists and key rate shocks
+	vector<CurveScenario> scenarios;
+	for (size_t j = 0; j < scenarioCount; j++)
+	{
+		double basisPoints = -300.0 + 600.0 * (j / 3) / max<size_t>(1, (scenarioCount - 1) / 3);
+		scenarios.push_back(j % 3 == 0 ? ParallelScenario(basisPoints) : j % 3 == 1 ? TwistScenario(basisPoints)
+			: KeyRateScenario(static_cast<int>(j / 3 % KEY_RATE_COUNT), basisPoints));
+	}
+	service.SetScenarios(scenarios);
+
+	mt19937_64 random(39373);
+	vector<long> quantities;
+	for (auto& product : products)
+	{
+		Position<Bond> position(ProductRegistry<Bond>::Instance().GetHandle(product));
+		position.AddPosition("TRSY1", static_cast<long>(random() % 2000001) - 1000000);
+		quantities.push_back(position.GetAggregatePosition());
+		service.AddPosition(position);
+	}
+
+	service.Evaluate();
+	auto start = steady_clock::now();
+	const vector<ScenarioRisk<Bond>>& results = service.Evaluate();
+	double seconds = duration<double>(steady_clock::now() - start).count();
+
+	// check the first scenarios against every bond valued coupon by coupon at par
+	double maxError = 0.0;
+	size_t checked = min<size_t>(scenarioCount, 6);
+	for (size_t j = 0; j < checked; j++)
+	{
+		double expected = 0.0;
+		for (size_t i = 0; i < products.size(); i++)
+		{
+			const Bond& bond = ProductRegistry<Bond>::Instance().Get(ProductRegistry<Bond>::Instance().GetHandle(products[i]));
+			BondTerms terms = GetBondTerms(bond.GetCoupon(), bond.GetMaturityDate(), PV01_SETTLEMENT);
+			int pillar;
+			double weight, base, shocked, first, second;
+			GetPillarWeight(terms.GetYears(), pillar, weight);
+			double y = bond.GetCoupon();
+			SumBondMoments(terms.coupon, terms.periods, terms.fraction, y / 2, base, first, second);
+			SumBondMoments(terms.coupon, terms.periods, terms.fraction, (y + scenarios[j].GetShift(pillar, weight)) / 2, shocked, first, second);
+			expected += quantities[i] / PRICE_FACE * (shocked - base);
+		}
+		double scale = max(abs(expected), 1.0);
+		maxError = max(maxError, abs(results[j].GetPnL() - expected) / scale);
+	}
+
+	cout << "scenarios, " << productCount << " bonds x " << scenarioCount << " scenarios on " << (workers > 0 ? workers : thread::hardware_concurrency()) << " workers" << endl;
+	cout << "  " << left << setw(24) << "evaluate" << right << setw(10) << fixed << setprecision(3) << seconds * 1e3 << " ms, "
+		<< setprecision(1) << seconds * 1e9 / (productCount * scenarioCount) << " ns/point" << endl;
+	cout << "  " << counter.results << " results published, max relative error " << scientific << setprecision(2) << maxError
+		<< " against coupon by coupon valuation of " << checked << " scenarios" << endl;
+	return maxError < 1e-9 ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	map<string, function<int(const vector<string>&)>> benchmarks = {
+		{"orderbook", BenchOrderBook}, // orderbook [marketdata.txt] [window] [legacy ticks]
+		{"fracprice", BenchFracPrice}, // fracprice [repeat]
+		{"timestamp", BenchTimestamp}, // timestamp [count]
+		{"logger", BenchLogger}, // logger [records] [threads]
+		{"timers", BenchTimers}, // timers [timers]
+		{"snapshot", BenchSnapshot}, // snapshot [prices] [readers]
+		{"sectors", BenchSectors}, // sectors [positions]
+		{"keyrates", BenchKeyRates}, // keyrates [positions] [price every]
+		{"pnl", BenchPnL}, // pnl [events] [price every]
+		{"livepv01", BenchLivePV01}, // livepv01 [products] [prices] [batch]
+		{"bonds", BenchBondAnalytics}, // bonds [bonds] [scenarios]
+		{"scenarios", BenchScenarios}, // scenarios [bonds] [scenarios] [workers]
+		{"pipeline", BenchPipeline}, // pipeline [ticks]
+		{"sharded", BenchSharded}, // sharded [products] [ticks per product] [max workers]
+		{"generate", BenchGenerate}, // generate [products] [ticks per product] [max threads] [csv|binary]
+		{"replay", BenchReplay}, // replay [products] [ticks per product]
+		{"flows", BenchFlows}, // flows [all|price|marketdata|trade|inquiry] [products] [ticks per product]
+	};
+
+	if (argc < 2 || benchmarks.find(argv[1]) == benchmarks.end())
+	{
+		cout << "Usage: benchmark <name> [args...]" << endl << "Benchmarks:";
+		for (auto& benchmark : benchmarks)
+		{
+			cout << " " << benchmark.first;
+		}
+		cout << endl;
+		return 1;
+	}
+
+	vector<string> args(argv + 2, argv + argc);
+	return benchmarks[argv[1]](args);
+}
@@ -0,0 +1,267 @@
+// bondanalytics.hpp
+//
+// Purpose: 1. Defines closed-form analytics of fixed coupon bonds: price, yield, duration, convexity and DV01.
+// 2. Defines the batch kernels that solve the yields of many bonds and value many bonds across many
+//    yield scenarios in one call, over plain arrays.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef BOND_ANALYTICS_HPP
+#define BOND_ANALYTICS_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <array>
+#include <stdexcept>
+
+#include "boost/date_time/gregorian/gregorian.hpp"
+
+using namespace std;
+
+// Per-period rate below which the closed forms lose precision and the cash flows are summed instead
+const double SMALL_RATE = 1e-3;
+
+// Key rate pillars of the treasury curve, in years
+const int KEY_RATE_COUNT = 7;
+const double KEY_RATE_PILLARS[KEY_RATE_COUNT] = { 2, 3, 5, 7, 10, 20, 30 };
+
+// One value per key rate pillar
+typedef array<double, KEY_RATE_COUNT> KeyRateVector;
+
+/**
+ * Cash flow terms of a fixed coupon bond at a settlement date, per 100 face.
+ * The next coupon is a fraction of a period away and the remaining coupons follow one period apart,
+ * the last one paid with the redemption.
+ */
+struct BondTerms
+{
+	double coupon = 0.0; // coupon paid per period
+	double periods = 0.0; // remaining coupons, 0 if the bond has matured
+	double fraction = 1.0; // fraction of a period to the next coupon
+	int frequency = 2; // coupons per year
+
+	// Get the coupon accrued since the last coupon date
+	double GetAccrued() const { return coupon * (1.0 - fraction); }
+
+	// Get the time to maturity in years
+	double GetYears() const { return periods > 0.0 ? (periods - 1.0 + fraction) / frequency : 0.0; }
+};
+
+// Analytics of a bond at a yield, per 100 face
+struct BondRisk
+{
+	double price = 0.0; // dirty price
+	double cleanPrice = 0.0;
+	double macaulayDuration = 0.0; // in years
+	double modifiedDuration = 0.0; // -dP/dy / P
+	double convexity = 0.0; // d2P/dy2 / P
+	double dv01 = 0.0; // price change for a one basis point fall in yield
+};
+
+// Get the terms of a bond at a settlement date, coupon dates stepping back from maturity by whole periods
+BondTerms GetBondTerms(double couponRate, const boost::gregorian::date& maturity, const boost::gregorian::date& settlement, int frequency = 2)
+{
+	BondTerms terms;
+	terms.coupon = 100.0 * couponRate / frequency;
+	terms.frequency = frequency;
+	if (maturity <= settlement)
+	{
+		terms.periods = 0.0;
+		return terms;
+	}
+
+	// walk the coupon dates back from maturity to the last one on or before settlement
+	boost::gregorian::months period(12 / frequency);
+	int count = 1;
+	boost::gregorian::date next = maturity;
+	boost::gregorian::date previous = maturity - period;
+	while (previous > settlement)
+	{
+		next = previous;
+		previous = previous - period;
+		count++;
+	}
+	terms.periods = count;
+	terms.fraction = static_cast<double>((next - settlement).days()) / static_cast<double>((next - previous).days());
+	return terms;
+}
+
+// Get the terms of a bond a whole number of years from maturity on a coupon date, as CalculatePV01 values it
+BondTerms GetBondTerms(double couponRate, int years, int frequency = 2)
+{
+	BondTerms terms;
+	terms.coupon = 100.0 * couponRate / frequency;
+	terms.periods = years * frequency;
+	terms.fraction = 1.0;
+	terms.frequency = frequency;
+	return terms;
+}
+
+// Get the key rate pillar at or below a maturity and the weight of the pillar above it:
+// a curve shock given at the pillars is linear between them and flat beyond the first and the last
+void GetPillarWeight(double years, int& pillar, double& weight)
+{
+	pillar = 0;
+	while (pillar < KEY_RATE_COUNT - 2 && years > KEY_RATE_PILLARS[pillar + 1])
+	{
+		pillar++;
+	}
+	weight = (years - KEY_RATE_PILLARS[pillar]) / (KEY_RATE_PILLARS[pillar + 1] - KEY_RATE_PILLARS[pillar]);
+	weight = fmin(fmax(weight, 0.0), 1.0);
+}
+
+// Get the dirty price and the sums of t CF v^t and t (t+1) CF v^t over the cash flows, t in periods,
+// at a per-period rate r, by summing the cash flows (reference for the closed form, and its fallback near r = 0)
+void SumBondMoments(double coupon, double periods, double fraction, double r, double& price, double& first, double& second)
+{
+	price = first = second = 0.0;
+	int count = static_cast<int>(periods);
+	for (int k = 0; k < count; k++)
+	{
+		double t = k + fraction;
+		double flow = coupon + (k == count - 1 ? 100.0 : 0.0);
+		double discounted = flow * pow(1.0 + r, -t);
+		price += discounted;
+		first += t * discounted;
+		second += t * (t + 1.0) * discounted;
+	}
+}
+
+// Get the dirty price and the sums of t CF v^t and t (t+1) CF v^t over the cash flows in closed form:
+// the coupons are an annuity, sum of v^(k+w) = v^w (1 - v^N) / (1 - v), and the weighted sums follow from
+// its derivatives in v. One log and two exponentials, whatever the number of coupons.
+inline void BondMoments(double coupon, double periods, double fraction, double r, double& price, double& first, double& second)
+{
+	if (periods <= 0.0)
+	{
+		price = first = second = 0.0;
+		return;
+	}
+	if (fabs(r) < SMALL_RATE)
+	{
+		SumBondMoments(coupon, periods, fraction, r, price, first, second);
+		return;
+	}
+
+	double x = log1p(r);
+	double v = 1.0 / (1.0 + r);
+	double vw = exp(-fraction * x);
+	double oneMinusVN = -expm1(-periods * x); // 1 - v^N
+	double vn = 1.0 - oneMinusVN;
+	double u = r / (1.0 + r); // 1 - v
+
+	// G = sum of v^k for k < N, and its first two derivatives in v
+	double g = oneMinusVN / u;
+	double numerator = oneMinusVN - periods * vn / v * u;
+	double g1 = numerator / (u * u);
+	double g2 = (2.0 * numerator - periods * (periods - 1.0) * vn / (v * v) * u * u) / (u * u * u);
+	double s1 = v * g1; // sum of k v^k
+	double s2 = v * g1 + v * v * g2; // sum of k^2 v^k
+
+	double t = periods - 1.0 + fraction; // time of the redemption
+	double redemption = 100.0 * vn / v * vw;
+	price = coupon * vw * g + redemption;
+	first = coupon * vw * (s1 + fraction * g) + t * redemption;
+	second = coupon * vw * (s2 + (2.0 * fraction + 1.0) * s1 + fraction * (fraction + 1.0) * g) + t * (t + 1.0) * redemption;
+}
+
+// Get the dirty price of a bond at a yield
+double BondPrice(const BondTerms& terms, double yield)
+{
+	double price, first, second;
+	BondMoments(terms.coupon, terms.periods, terms.fraction, yield / terms.frequency, price, first, second);
+	return price;
+}
+
+// Get the analytics of a bond at a yield
+BondRisk AnalyzeBond(const BondTerms& terms, double yield)
+{
+	BondRisk risk;
+	double r = yield / terms.frequency;
+	double first, second;
+	BondMoments(terms.coupon, terms.periods, terms.fraction, r, risk.price, first, second);
+	if (risk.price == 0.0)
+	{
+		return risk;
+	}
+	double v = 1.0 / (1.0 + r);
+	double f = terms.frequency;
+	risk.cleanPrice = risk.price - terms.GetAccrued();
+	risk.macaulayDuration = first / risk.price / f;
+	risk.modifiedDuration = v * first / risk.price / f;
+	risk.convexity = v * v * second / risk.price / (f * f);
+	risk.dv01 = v * first / f * 1e-4;
+	return risk;
+}
+
+// Get the PV01 of a face value of a bond as CalculatePV01 does, the price at the yield less the price one basis point higher
+double BondPV01(const BondTerms& terms, double yield, double faceValue)
+{
+	return (BondPrice(terms, yield) - BondPrice(terms, yield + 0.0001)) * faceValue / 100.0;
+}
+
+// Solve the yields of n bonds from their dirty prices by Newton's method in lockstep, starting from the given yields,
+// and get their DV01 per 100 face at the solved yields; returns the number of iterations
+// a bond whose price does not move with its yield (no coupons left) keeps its starting yield
+int SolveBondYields(size_t n, const double* dirty, const double* coupon, const double* periods, const double* fraction,
+	int frequency, double* yield, double* dv01)
+{
+	const int MAX_ITERATIONS = 50;
+	const double TOLERANCE = 1e-12;
+	const double MIN_SLOPE = 1e-12;
+	int iteration = 0;
+	double step = 1.0;
+	while (iteration < MAX_ITERATIONS && step > TOLERANCE)
+	{
+		iteration++;
+		step = 0.0;
+		// one Newton step for every bond
+		for (size_t i = 0; i < n; i++)
+		{
+			double r = yield[i] / frequency;
+			double price, first, second;
+			BondMoments(coupon[i], periods[i], fraction[i], r, price, first, second);
+			double slope = -first / (1.0 + r); // dP/dr
+			dv01[i] = -slope / frequency * 1e-4;
+			// a flat price has no Newton step, and a step off to infinity is not taken
+			if (!(fabs(slope) > MIN_SLOPE))
+			{
+				continue;
+			}
+			double delta = (price - dirty[i]) / slope;
+			double next = yield[i] - delta * frequency;
+			if (!isfinite(next))
+			{
+				continue;
+			}
+			yield[i] = next;
+			step = fmax(step, fabs(delta));
+		}
+	}
+	return iteration;
+}
+
+// Value n bonds at m parallel yield scenarios: prices[j * n + i] is bond i at yields[i] + shifts[j],
+// and dv01s (if not null) the DV01 per 100 face at the same point
+void PriceBondGrid(size_t n, const double* coupon, const double* periods, const double* fraction, int frequency,
+	const double* yields, size_t m, const double* shifts, double* prices, double* dv01s)
+{
+	for (size_t j = 0; j < m; j++)
+	{
+		double* row = prices + j * n;
+		double* dv01Row = dv01s == nullptr ? nullptr : dv01s + j * n;
+		for (size_t i = 0; i < n; i++)
+		{
+			double r = (yields[i] + shifts[j]) / frequency;
+			double first, second;
+			BondMoments(coupon[i], periods[i], fraction[i], r, row[i], first, second);
+			if (dv01Row != nullptr)
+			{
+				dv01Row[i] = first / (1.0 + r) / frequency * 1e-4;
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,214 @@
+// csvreader.hpp
+//
+// Purpose: 1. Defines a memory-mapped input file and a zero-copy CSV line/field tokenizer.
+// 2. Shared by the inbound connectors so that fields are string_views into the mapped file.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef CSV_READER_HPP
+#define CSV_READER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <charconv>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+/**
+ * A read-only memory mapping of a whole file.
+ * The mapping lives as long as the object, so views into it stay valid until then.
+ */
+class MappedFile
+{
+
+public:
+	// ctor, maps the file (throws if the file cannot be opened or mapped)
+	MappedFile(const string& path);
+
+	// dtor, unmaps the file
+	~MappedFile();
+
+	// a mapping is owned by exactly one object
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Get the first byte of the file
+	const char* GetData() const;
+
+	// Get the size of the file in bytes
+	size_t GetSize() const;
+
+private:
+	const char* data;
+	size_t size;
+
+};
+
+MappedFile::MappedFile(const string& path) : data(nullptr), size(0)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Cannot open file: " + path);
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		throw std::runtime_error("Cannot stat file: " + path);
+	}
+	size = static_cast<size_t>(st.st_size);
+
+	// mmap of an empty file fails, an empty file is simply an empty view
+	if (size > 0)
+	{
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED)
+		{
+			close(fd);
+			throw std::runtime_error("Cannot map file: " + path);
+		}
+		// the file is read front to back exactly once
+		madvise(mapped, size, MADV_SEQUENTIAL);
+		data = static_cast<const char*>(mapped);
+	}
+	close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data != nullptr)
+	{
+		munmap(const_cast<char*>(data), size);
+	}
+}
+
+const char* MappedFile::GetData() const
+{
+	return data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return size;
+}
+
+/**
+ * Zero-copy CSV tokenizer over a mapped file.
+ * NextLine() advances line by line (blank lines are skipped); fields of the current line are
+ * string_views into the mapping and stay valid for the lifetime of the reader.
+ */
+class CsvReader
+{
+
+public:
+	// ctor
+	CsvReader(const string& path, char _delimiter = ',');
+
+	// Advance to the next non-blank line, returns false at the end of the file
+	bool NextLine();
+
+	// Get the current line (without the line terminator)
+	string_view GetLine() const;
+
+	// Get the number of fields on the current line
+	size_t GetFieldCount() const;
+
+	// Get a field of the current line
+	string_view operator[](size_t index) const;
+
+private:
+	MappedFile file;
+	const char* cursor;
+	const char* end;
+	char delimiter;
+	string_view line;
+	vector<string_view> fields; // reused across lines
+
+};
+
+CsvReader::CsvReader(const string& path, char _delimiter) :
+	file(path), cursor(file.GetData()), end(file.GetData() + file.GetSize()), delimiter(_delimiter)
+{
+	fields.reserve(32);
+}
+
+bool CsvReader::NextLine()
+{
+	do
+	{
+		if (cursor == nullptr || cursor >= end)
+		{
+			return false;
+		}
+
+		// find the end of the line
+		const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+		const char* next = (lineEnd == nullptr) ? end : lineEnd + 1;
+		if (lineEnd == nullptr)
+		{
+			lineEnd = end;
+		}
+		if (lineEnd > cursor && *(lineEnd - 1) == '\r')
+		{
+			lineEnd--;
+		}
+		line = string_view(cursor, lineEnd - cursor);
+		cursor = next;
+	} while (line.empty());
+
+	// split the line into fields
+	fields.clear();
+	const char* fieldStart = line.data();
+	const char* lineStop = line.data() + line.size();
+	while (true)
+	{
+		const char* fieldEnd = static_cast<const char*>(memchr(fieldStart, delimiter, lineStop - fieldStart));
+		if (fieldEnd == nullptr)
+		{
+			fields.emplace_back(fieldStart, lineStop - fieldStart);
+			break;
+		}
+		fields.emplace_back(fieldStart, fieldEnd - fieldStart);
+		fieldStart = fieldEnd + 1;
+	}
+	return true;
+}
+
+string_view CsvReader::GetLine() const
+{
+	return line;
+}
+
+size_t CsvReader::GetFieldCount() const
+{
+	return fields.size();
+}
+
+string_view CsvReader::operator[](size_t index) const
+{
+	return fields[index];
+}
+
+// Parse an integer field without allocating
+long ParseLong(string_view field)
+{
+	long value = 0;
+	auto result = from_chars(field.data(), field.data() + field.size(), value);
+	if (result.ec != errc())
+	{
+		throw std::invalid_argument("Invalid integer: " + string(field));
+	}
+	return value;
+}
+
+#endif
@@ -10,6 +10,7 @@
 #define EXECUTION_SERVICE_HPP
 
 #include <string>
+#include <mutex>
 #include "soa.hpp"
 #include "algoexecutionservice.hpp"
 
@@ -65,13 +66,14 @@ public:
 
 private:
     map<string, ExecutionOrder<T>> executionOrderData; // store execution order data keyed by product identifier
+    mutex executionOrderLock; // guards the order map, sharded edges add orders of different products at once
     vector<ServiceListener<ExecutionOrder<T>>*> listeners; // list of listeners to this service
     ExecutionServiceConnector<T>* connector; // connector related to this server
     ExecutionServiceListener<T>* executionservicelistener; // listener related to this server
 };
 
 template<typename T>
-ExecutionService<T>::ExecutionService() : executionservicelistener(new ExecutionServiceListener<T>(this))
+ExecutionService<T>::ExecutionService() : connector(new ExecutionServiceConnector<T>(this)), executionservicelistener(new ExecutionServiceListener<T>(this))
 { 
 }
 
@@ -141,8 +143,11 @@ void ExecutionService<T>::AddExecutionOrder(const AlgoExecution<T>& algoExecutio
 {
     ExecutionOrder<T> executionOrder = algoExecution.GetExecutionOrder();
     string orderId = executionOrder.GetOrderId();
-    if (executionOrderData.find(orderId) != executionOrderData.end()) { executionOrderData.erase(orderId); }
-    executionOrderData.insert(pair<string, ExecutionOrder<T>>(orderId, executionOrder));
+    {
+        lock_guard<mutex> guard(executionOrderLock);
+        if (executionOrderData.find(orderId) != executionOrderData.end()) { executionOrderData.erase(orderId); }
+        executionOrderData.insert(pair<string, ExecutionOrder<T>>(orderId, executionOrder));
+    }
 
     // notify the listener
     for (auto& l : listeners) {
@@ -159,6 +164,7 @@ class ExecutionServiceConnector : public Connector<ExecutionOrder<T>>
 {
 private:
   ExecutionService<T>* service; // execution service related to this connector
+  SampledSink console; // sampled console output of the orders
 
 public:
     // ctor
@@ -166,13 +172,25 @@ public:
     // dtor
     ~ExecutionServiceConnector() = default;
 
-    // Publish data to the Connector
+    // Publish data to the Connector, does nothing: orders are published with their market
+    void Publish(ExecutionOrder<T>& order) override;
+
+    // Publish an order executed on a market
     void Publish(const ExecutionOrder<T>& order, Market& market);
 };
 
 template<typename T>
 ExecutionServiceConnector<T>::ExecutionServiceConnector(ExecutionService<T>* _service)
-: service(_service)
+: service(_service),
+  console("ExecutionOrder: \n"
+    "\tProduct: {}\tOrderId: {}\tTrade Market: {}\n"
+    "\tPricingSide: {}\tOrderType: {}\t\tIsChildOrder: {}\n"
+    "\tPrice: {}\tVisibleQuantity: {}\tHiddenQuantity: {}\n\n")
+{
+}
+
+template<typename T>
+void ExecutionServiceConnector<T>::Publish(ExecutionOrder<T>& order)
 {
 }
 
@@ -182,9 +200,11 @@ ExecutionServiceConnector<T>::ExecutionServiceConnector(ExecutionService<T>* _se
 template<typename T>
 void ExecutionServiceConnector<T>::Publish(const ExecutionOrder<T>& order, Market& market)
 {
+    if (!console.Sample()) return;
+
     // print the execution order data
-    auto product = order.GetProduct();
-    string order_type;
+    const T& product = order.GetProduct();
+    const char* order_type = "";
     switch (order.GetOrderType())
     {
     case FOK:
@@ -203,7 +223,7 @@ void ExecutionServiceConnector<T>::Publish(const ExecutionOrder<T>& order, Marke
         order_type = "IOC";
         break;
     }
-    string tradeMarket;
+    const char* tradeMarket = "";
     switch (market) {
     case BROKERTEC:
         tradeMarket = "BROKERTEC";
@@ -215,12 +235,9 @@ void ExecutionServiceConnector<T>::Publish(const ExecutionOrder<T>& order, Marke
         CME: tradeMarket = "CME";
             break;
     }
-    cout << "ExecutionOrder: \n"
-        << "\tProduct: " << product.GetProductId() << "\tOrderId: " << order.GetOrderId() << "\tTrade Market: " << tradeMarket << "\n"
-        << "\tPricingSide: " << (order.GetSide() == BID ? "Bid" : "Offer")
-        << "\tOrderType: " << order_type << "\t\tIsChildOrder: " << (order.IsChildOrder() ? "True" : "False") << "\n"
-        << "\tPrice: " << order.GetPrice() << "\tVisibleQuantity: " << order.GetVisibleQuantity()
-        << "\tHiddenQuantity: " << order.GetHiddenQuantity() << endl << endl;
+    console.Print(product.GetProductId(), order.GetOrderId(), tradeMarket,
+        order.GetSide() == BID ? "Bid" : "Offer", order_type, order.IsChildOrder() ? "True" : "False",
+        order.GetPrice(), order.GetVisibleQuantity(), order.GetHiddenQuantity());
 }
 
 /**
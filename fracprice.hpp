@@ -0,0 +1,202 @@
+// fracprice.hpp
+//
+// Purpose: 1. Defines a fast parser for US Treasury fractional prices ("99-16+" = 99 + 16/32 + 4/256).
+// 2. Works on string_view without allocating, validates with lookup tables, and parses batches
+//    eight characters at a time in one 64-bit register (SWAR).
+// 3. Defines the matching formatter, writing ticks of 1/256 into a character buffer.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef FRAC_PRICE_HPP
+#define FRAC_PRICE_HPP
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <array>
+#include <charconv>
+#include "tickprice.hpp"
+
+using namespace std;
+
+// Value of a character in a fractional price: digits map to 0-9, everything else is invalid (0xFF)
+constexpr array<uint8_t, 256> FracDigitTable()
+{
+	array<uint8_t, 256> table{};
+	for (int c = 0; c < 256; c++)
+	{
+		table[c] = (c >= '0' && c <= '9') ? static_cast<uint8_t>(c - '0') : 0xFF;
+	}
+	return table;
+}
+
+// Value of the 256ths character: '0'-'7' map to 0-7 and '+' means 4 (half of a 32nd)
+constexpr array<uint8_t, 256> FracEighthTable()
+{
+	array<uint8_t, 256> table{};
+	for (int c = 0; c < 256; c++)
+	{
+		table[c] = (c >= '0' && c <= '7') ? static_cast<uint8_t>(c - '0') : 0xFF;
+	}
+	table['+'] = 4;
+	return table;
+}
+
+inline constexpr array<uint8_t, 256> fracDigits = FracDigitTable();
+inline constexpr array<uint8_t, 256> fracEighths = FracEighthTable();
+
+/**
+ * Parse a fractional price "I-XYZ" into ticks of 1/256.
+ * I is 1 to 3 digits, XY is 00-31 and Z is 0-7 or '+'.
+ * Returns false if the text is malformed. There are no data-dependent branches after the
+ * length check: every character is validated through a table and the errors are OR-ed together.
+ */
+bool ParseFracTicks(string_view text, long& ticks)
+{
+	size_t len = text.size();
+	if (len < 5 || len > 7)
+	{
+		return false;
+	}
+
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+	const unsigned char* frac = p + len - 3;
+
+	// whole part, right aligned into three digits
+	uint32_t h = (len == 7) ? fracDigits[p[0]] : 0;
+	uint32_t t = (len >= 6) ? fracDigits[p[len - 6]] : 0;
+	uint32_t o = fracDigits[p[len - 5]];
+	uint32_t x = fracDigits[frac[0]];
+	uint32_t y = fracDigits[frac[1]];
+	uint32_t z = fracEighths[frac[2]];
+
+	uint32_t bad = (h | t | o | x | y | z) & 0x80;
+	uint32_t xy = x * 10 + y;
+	bad |= (xy >= 32) | (frac[-1] != '-');
+
+	ticks = static_cast<long>((h * 100 + t * 10 + o) * 256 + xy * 8 + z);
+	return bad == 0;
+}
+
+// Parse a fractional price into a decimal price (throws on malformed input)
+double ParseFracPrice(string_view text)
+{
+	long ticks;
+	if (!ParseFracTicks(text, ticks))
+	{
+		throw std::invalid_argument("Invalid fractional price: " + string(text));
+	}
+	return ticks / 256.0;
+}
+
+// Parse a fractional price into a tick price (throws on malformed input)
+TickPrice ParseTickPrice(string_view text)
+{
+	long ticks;
+	if (!ParseFracTicks(text, ticks))
+	{
+		throw std::invalid_argument("Invalid fractional price: " + string(text));
+	}
+	return TickPrice(ticks);
+}
+
+/**
+ * Parse a batch of fractional prices into ticks of 1/256.
+ * Each price is packed into one 64-bit word from two overlapping 4-byte loads: the low half
+ * holds the whole part right aligned and padded with '0', the high half holds "-XYZ".
+ * All eight characters are then validated and converted at once with SWAR arithmetic.
+ * Returns the number of prices parsed; a return value below count is the index of the
+ * first malformed price.
+ */
+size_t ParseFracTicks(const string_view* texts, long* ticks, size_t count)
+{
+	const uint64_t zeros = 0x3030303030303030ULL;
+	const uint64_t highNibbles = 0xF0F0F0F0F0F0F0F0ULL;
+	const uint64_t six = 0x0606060606060606ULL;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t len = texts[i].size();
+		if (len < 5 || len > 7)
+		{
+			return i;
+		}
+
+		// load the first and the last four characters (little endian: byte k is character k)
+		const char* p = texts[i].data();
+		uint32_t head, tail;
+		memcpy(&head, p, 4);
+		memcpy(&tail, p + len - 4, 4);
+
+		// whole part: shift out the characters after it and pad the front with '0'
+		uint32_t shift = static_cast<uint32_t>(8 - len) * 8;
+		uint32_t low = (head << shift) | (0x30303030u >> (32 - shift));
+
+		// fractional part: the dash becomes '0' and a '+' becomes '4'
+		bool dash = (tail & 0xFF) == '-';
+		uint32_t zc = tail >> 24;
+		zc += (zc == '+') * ('4' - '+');
+		tail = (tail & 0x00FFFF00u) | 0x30u | (zc << 24);
+
+		uint64_t word = low | (static_cast<uint64_t>(tail) << 32);
+
+		// every byte must be an ASCII digit: high nibble 3 before and after adding 6
+		bool digits = ((word & highNibbles) == zeros) & (((word + six) & highNibbles) == zeros);
+		uint64_t d = word - zeros;
+
+		uint32_t whole = ((d >> 8) & 0xFF) * 100 + ((d >> 16) & 0xFF) * 10 + ((d >> 24) & 0xFF);
+		uint32_t xy = ((d >> 40) & 0xFF) * 10 + ((d >> 48) & 0xFF);
+		uint32_t z = (d >> 56) & 0xFF;
+		bool ok = digits & dash & (xy < 32) & (z < 8);
+		if (!ok)
+		{
+			return i;
+		}
+		ticks[i] = static_cast<long>(whole * 256 + xy * 8 + z);
+	}
+	return count;
+}
+
+// Parse a batch of fractional prices into decimal prices (throws on the first malformed input)
+void ParseFracPrices(const string_view* texts, double* prices, size_t count)
+{
+	const size_t chunk = 16;
+	long ticks[chunk];
+	for (size_t start = 0; start < count; start += chunk)
+	{
+		size_t n = (count - start < chunk) ? count - start : chunk;
+		size_t parsed = ParseFracTicks(texts + start, ticks, n);
+		if (parsed < n)
+		{
+			throw std::invalid_argument("Invalid fractional price: " + string(texts[start + parsed]));
+		}
+		for (size_t i = 0; i < n; i++)
+		{
+			prices[start + i] = ticks[i] / 256.0;
+		}
+	}
+}
+
+/**
+ * Format ticks of 1/256 as a fractional price "I-XYZ" into out, which must hold 24 characters.
+ * Returns the end of the written text. Gives the same text as Price2Frac(), without allocating.
+ */
+char* FormatFracTicks(long ticks, char* out)
+{
+	long whole = (ticks >= 0) ? ticks / 256 : -((-ticks + 255) / 256);
+	long frac = ticks - whole * 256;
+	long xy = frac / 8;
+	long z = frac % 8;
+
+	out = to_chars(out, out + 20, whole).ptr;
+	out[0] = '-';
+	out[1] = static_cast<char>('0' + xy / 10);
+	out[2] = static_cast<char>('0' + xy % 10);
+	out[3] = (z == 4) ? '+' : static_cast<char>('0' + z);
+	return out + 4;
+}
+
+#endif
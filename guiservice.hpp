@@ -11,6 +11,8 @@
 #include "soa.hpp"  
 #include "utilities.hpp"
 #include "pricingservice.hpp"
+#include "timerwheel.hpp"
+#include "guisnapshot.hpp"
 
  // fwd declaration of GUIConnector and GUIServiceListener
 template<typename T>
@@ -21,6 +23,10 @@ class GUIServiceListener;
 
 /**
 * Service for outputing GUI with a certain throttle.
+* Each product publishes at most one price per throttle interval: the first price after a quiet
+* interval goes out at once and starts a timer, prices arriving before the timer fires are conflated
+* into the latest one, which the timer publishes when it fires. Prices are never timed on arrival,
+* only the timer service looks at the clock.
 * Keyed on product identifier.
 * Type T is the product type.
 */
@@ -28,23 +34,43 @@ template<typename T>
 class GUIService : public Service<string, Price<T> >
 {
 private:
-    map<string, Price<T>> priceData; // store price data keyed by product identifier
+    // conflated price of one product
+    struct Snapshot
+    {
+        mutex lock; // taken by the price thread and the timer thread
+        Price<T> price; // last published price
+        Price<T> latest; // latest price waiting for the timer
+        bool published = false; // a price has been published
+        bool pending = false; // latest has not been published yet
+        TimerId timer = 0; // running throttle timer, 0 if the product is quiet
+        uint64_t updates = 0; // prices received
+    };
+
+    ProductStore<Snapshot> snapshots; // conflated prices keyed by product handle
     vector<ServiceListener<Price<T>>*> listeners; // list of listeners to this service
     GUIConnector<T>* connector; // connector related to this server
     GUIServiceListener<T>* guiservicelistener; // listener related to this server
-    int throttle; // throttle of the service   
-    std::chrono::system_clock::time_point startTime; // start time
+    int throttle; // throttle of the service in milliseconds
+    TimerService& timers; // timer service running the throttle timers
+    atomic<bool> closing; // set by the dtor, timers stop rescheduling
+    unique_ptr<GUISnapshotWriter> snapshotWriter; // shared memory snapshot, if enabled
+
+    // Timer callback at the end of a throttle interval, publishes the conflated price if any
+    void OnThrottle(Snapshot& snapshot);
 
 public:
     // ctor
     GUIService();
 
-    // dtor
-    ~GUIService() = default;
+    // dtor, stops the throttle timers and publishes the prices still waiting
+    ~GUIService();
 
-    // Get data on our service given a key
+    // Get the last published price given a key
     Price<T>& GetData(string key) override;
 
+    // Get the last published price given a product handle
+    Price<T>& GetData(ProductHandle handle);
+
     // The callback that a Connector should invoke for any new or updated data
     void OnMessage(Price<T>& data) override;
 
@@ -63,29 +89,59 @@ public:
     // Get the throttle
     int GetThrottle() const;
 
-    // Publish the throttled price through connector
+    // Publish the price through connector, or conflate it until the throttle interval ends
+    // with a shared memory snapshot, every price is also stored in the slot of its product
     void PublishThrottledPrice(Price<T>& price);
 
+    // Publish the latest price of every product into a shared memory snapshot (see guisnapshot.hpp)
+    // for viewer processes, sized for the registered products (throws if it cannot be created)
+    void EnableSnapshot(const string& name = GUI_SNAPSHOT_NAME);
+
 };
 
 template<typename T>
 GUIService<T>::GUIService() :
-    connector(new GUIConnector<T>(this)), guiservicelistener(new GUIServiceListener<T>(this)), throttle(300), startTime(std::chrono::system_clock::now())
+    connector(new GUIConnector<T>(this)), guiservicelistener(new GUIServiceListener<T>(this)), throttle(300), timers(TimerService::Instance()), closing(false)
+{
+    snapshots.Reserve(ProductRegistry<T>::Instance().GetSize());
+}
+
+template<typename T>
+GUIService<T>::~GUIService()
 {
+    closing.store(true);
+    snapshots.ForEach([this](Snapshot& snapshot) {
+        TimerId timer;
+        {
+            lock_guard<mutex> guard(snapshot.lock);
+            timer = snapshot.timer;
+        }
+        timers.Cancel(timer);
+
+        lock_guard<mutex> guard(snapshot.lock);
+        snapshot.timer = 0;
+        if (snapshot.pending) {
+            snapshot.pending = false;
+            snapshot.price = snapshot.latest;
+            connector->Publish(snapshot.price);
+        }
+    });
 }
 
 template<typename T>
 Price<T>& GUIService<T>::GetData(string key)
 {
-    auto it = priceData.find(key);
-    if (it != priceData.end())
-    {
-        return it->second;
-    }
-    else
-    {
+    return GetData(ProductRegistry<T>::Instance().GetHandle(key));
+}
+
+template<typename T>
+Price<T>& GUIService<T>::GetData(ProductHandle handle)
+{
+    Snapshot* snapshot = snapshots.Find(handle);
+    if (snapshot == nullptr || !snapshot->published) {
         throw std::runtime_error("Key not found");
     }
+    return snapshot->price;
 }
 
 // no need to implement OnMessage
@@ -127,19 +183,59 @@ int GUIService<T>::GetThrottle() const
 template<typename T>
 void GUIService<T>::PublishThrottledPrice(Price<T>& price)
 {
-    // only publish price to GUI if the time interval is larger than throttle
-    auto now = std::chrono::system_clock::now();
-    auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime);
-    if (diff.count() > throttle) {
-        // update the time
-        startTime = now;
-        // publish the price
-        connector->Publish(price);
+    Snapshot& snapshot = snapshots[price.GetProductHandle()];
+    lock_guard<mutex> guard(snapshot.lock);
+    if (snapshotWriter) {
+        // the lock makes this the only writer of the slot
+        GUIQuote quote = {};
+        strncpy(quote.productId, price.GetProduct().GetProductId().c_str(), sizeof(quote.productId) - 1);
+        quote.bid = price.GetBid().ToDouble();
+        quote.offer = price.GetOffer().ToDouble();
+        quote.timestamp = price.GetTimestamp();
+        quote.updates = ++snapshot.updates;
+        snapshotWriter->Publish(price.GetProductHandle(), quote);
+    }
+    if (snapshot.timer != 0) {
+        // inside the throttle interval, keep only the latest price
+        snapshot.latest = price;
+        snapshot.pending = true;
+        return;
+    }
+
+    // quiet product, publish now and hold the next prices back for a throttle interval
+    snapshot.price = price;
+    snapshot.published = true;
+    connector->Publish(snapshot.price);
+    if (!closing.load()) {
+        snapshot.timer = timers.Schedule(throttle, [this, &snapshot]() { OnThrottle(snapshot); });
+    }
+}
+
+template<typename T>
+void GUIService<T>::EnableSnapshot(const string& name)
+{
+    snapshotWriter.reset(new GUISnapshotWriter(name, ProductRegistry<T>::Instance().GetSize()));
+}
+
+template<typename T>
+void GUIService<T>::OnThrottle(Snapshot& snapshot)
+{
+    lock_guard<mutex> guard(snapshot.lock);
+    snapshot.timer = 0;
+    if (!snapshot.pending) {
+        return;
+    }
+    snapshot.pending = false;
+    snapshot.price = snapshot.latest;
+    connector->Publish(snapshot.price);
+    if (!closing.load()) {
+        snapshot.timer = timers.Schedule(throttle, [this, &snapshot]() { OnThrottle(snapshot); });
     }
 }
 
 /**
 * GUI Connector publishing data from GUI Service.
+* Prices may be published from the price thread and the timer thread, so records are written under a lock.
 * Type T is the product type.
 */
 template<typename T>
@@ -147,6 +243,10 @@ class GUIConnector : public Connector<Price<T>>
 {
 private:
     GUIService<T>* service;
+    mutex lock; // serialises the records of the publishing threads
+    ofstream outFile; // gui.txt, kept open between records
+    TimestampFormatter timestamps; // formats the cached clock time of each record
+    string record; // record being written
 
 public:
     // ctor
@@ -159,17 +259,17 @@ public:
 template<typename T>
 GUIConnector<T>::GUIConnector(GUIService<T>* _service) : service(_service)
 {
+    outFile.open("../res/gui.txt", ios::app);
 }
 
 // publish to external source gui.txt
 template<typename T>
 void GUIConnector<T>::Publish(Price<T>& data)
 {
-    ofstream outFile;
-    outFile.open("../res/gui.txt", ios::app);
-    // need overloading operator<< for Price<T>
-    outFile << getTime() << "," << data << endl;
-    outFile.close();
+    lock_guard<mutex> guard(lock);
+    record.clear();
+    timestamps.Append(CachedClock::Instance().GetWallTime(), record);
+    outFile << record << "," << data << endl;
 }
 
 /**
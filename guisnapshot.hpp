@@ -0,0 +1,309 @@
+// guisnapshot.hpp
+//
+// Purpose: 1. Defines the layout of the GUI snapshot, the latest quote of every product in a POSIX shared memory segment.
+// 2. Defines the writer used by the GUI service and the reader used by viewer processes; every slot is
+//    guarded by a seqlock, so publishing is a few stores and readers never block the writer.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef GUI_SNAPSHOT_HPP
+#define GUI_SNAPSHOT_HPP
+
+#include <string>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Default name of the GUI snapshot segment
+const string GUI_SNAPSHOT_NAME = "/tradingsystem_gui";
+
+// Latest quote of one product
+struct GUIQuote
+{
+	char productId[16]; // zero-terminated
+	double bid;
+	double offer;
+	int64_t timestamp; // event time in nanoseconds since the epoch, 0 if unknown
+	uint64_t updates; // number of quotes published for the product
+};
+
+/**
+ * Shared memory layout: a header followed by one cache line per product handle.
+ * A slot holds a sequence number and the quote as plain words. The writer makes the sequence odd,
+ * stores the words and makes it even again; a reader copies the words between two reads of the
+ * sequence and retries if they differ or are odd.
+ */
+struct GUISnapshotHeader
+{
+	static const uint64_t MAGIC = 0x31504e5349554753; // "SGUISNP1"
+	static const uint32_t VERSION = 1;
+
+	uint64_t magic;
+	uint32_t version;
+	uint32_t slotSize;
+	uint64_t capacity; // number of slots
+	atomic<uint64_t> used; // one past the highest slot written
+	atomic<uint64_t> closed; // set when the writer goes away
+	uint64_t reserved[3];
+};
+
+struct alignas(64) GUISnapshotSlot
+{
+	static const size_t WORDS = sizeof(GUIQuote) / sizeof(uint64_t);
+
+	atomic<uint64_t> sequence; // odd while the quote is being written, 0 if never written
+	atomic<uint64_t> words[WORDS];
+};
+
+static_assert(sizeof(GUIQuote) % sizeof(uint64_t) == 0, "GUIQuote must be a whole number of words");
+static_assert(sizeof(GUISnapshotHeader) == 64, "GUISnapshotHeader must fill one cache line");
+static_assert(sizeof(GUISnapshotSlot) == 64, "GUISnapshotSlot must fill one cache line");
+static_assert(atomic<uint64_t>::is_always_lock_free, "the snapshot needs lock-free 64-bit atomics");
+
+/**
+ * Writer of the GUI snapshot.
+ * Creates the segment (replacing a stale one of the same name) and removes its name again in the dtor;
+ * viewers that already mapped it keep reading the last quotes. Each slot must have a single writer
+ * at a time, different slots may be written from different threads.
+ */
+class GUISnapshotWriter
+{
+
+public:
+	// ctor, creates a segment with a number of slots (throws if it cannot be created)
+	GUISnapshotWriter(const string& _name, size_t capacity);
+
+	// dtor, marks the snapshot closed and removes the segment name
+	~GUISnapshotWriter();
+
+	GUISnapshotWriter(const GUISnapshotWriter&) = delete;
+	GUISnapshotWriter& operator=(const GUISnapshotWriter&) = delete;
+
+	// Publish the quote of a slot, returns false if the slot is beyond the capacity
+	bool Publish(size_t slot, const GUIQuote& quote);
+
+	// Get the number of slots
+	size_t GetCapacity() const;
+
+	// Get the name of the segment
+	const string& GetName() const;
+
+private:
+	string name;
+	size_t size; // bytes mapped
+	GUISnapshotHeader* header;
+	GUISnapshotSlot* slots;
+
+};
+
+GUISnapshotWriter::GUISnapshotWriter(const string& _name, size_t capacity) : name(_name)
+{
+	size = sizeof(GUISnapshotHeader) + capacity * sizeof(GUISnapshotSlot);
+	shm_unlink(name.c_str());
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Cannot open shared memory: " + name);
+	}
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+	{
+		close(fd);
+		shm_unlink(name.c_str());
+		throw std::runtime_error("Cannot size shared memory: " + name);
+	}
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		shm_unlink(name.c_str());
+		throw std::runtime_error("Cannot map shared memory: " + name);
+	}
+
+	// the segment is zero-filled, so every slot starts with sequence 0
+	header = static_cast<GUISnapshotHeader*>(data);
+	slots = reinterpret_cast<GUISnapshotSlot*>(static_cast<char*>(data) + sizeof(GUISnapshotHeader));
+	header->version = GUISnapshotHeader::VERSION;
+	header->slotSize = sizeof(GUISnapshotSlot);
+	header->capacity = capacity;
+	header->used.store(0, memory_order_relaxed);
+	header->closed.store(0, memory_order_relaxed);
+	// readers check the magic last
+	atomic_thread_fence(memory_order_release);
+	header->magic = GUISnapshotHeader::MAGIC;
+}
+
+GUISnapshotWriter::~GUISnapshotWriter()
+{
+	header->closed.store(1, memory_order_release);
+	munmap(header, size);
+	shm_unlink(name.c_str());
+}
+
+bool GUISnapshotWriter::Publish(size_t slot, const GUIQuote& quote)
+{
+	if (slot >= header->capacity)
+	{
+		return false;
+	}
+	GUISnapshotSlot& target = slots[slot];
+	uint64_t words[GUISnapshotSlot::WORDS];
+	memcpy(words, &quote, sizeof(GUIQuote));
+
+	uint64_t sequence = target.sequence.load(memory_order_relaxed);
+	target.sequence.store(sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	for (size_t i = 0; i < GUISnapshotSlot::WORDS; i++)
+	{
+		target.words[i].store(words[i], memory_order_relaxed);
+	}
+	target.sequence.store(sequence + 2, memory_order_release);
+
+	uint64_t used = header->used.load(memory_order_relaxed);
+	while (used <= slot && !header->used.compare_exchange_weak(used, slot + 1, memory_order_release, memory_order_relaxed))
+	{
+	}
+	return true;
+}
+
+size_t GUISnapshotWriter::GetCapacity() const
+{
+	return header->capacity;
+}
+
+const string& GUISnapshotWriter::GetName() const
+{
+	return name;
+}
+
+/**
+ * Reader of the GUI snapshot, for viewer processes.
+ * Maps the segment read-only; reads never make a system call and never block the writer.
+ */
+class GUISnapshotReader
+{
+
+public:
+	// ctor, maps an existing segment (throws if it does not exist or is not a GUI snapshot)
+	GUISnapshotReader(const string& _name);
+
+	// dtor, unmaps the segment
+	~GUISnapshotReader();
+
+	GUISnapshotReader(const GUISnapshotReader&) = delete;
+	GUISnapshotReader& operator=(const GUISnapshotReader&) = delete;
+
+	// Read a consistent quote of a slot, returns false if the slot has never been written
+	bool Read(size_t slot, GUIQuote& quote) const;
+
+	// Get the number of slots that may have been written
+	size_t GetUsed() const;
+
+	// Get the number of slots
+	size_t GetCapacity() const;
+
+	// Check whether the writer has gone away
+	bool IsClosed() const;
+
+private:
+	string name;
+	size_t size; // bytes mapped
+	const GUISnapshotHeader* header;
+	const GUISnapshotSlot* slots;
+
+};
+
+GUISnapshotReader::GUISnapshotReader(const string& _name) : name(_name)
+{
+	int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+	{
+		throw std::runtime_error("Cannot open shared memory: " + name);
+	}
+	struct stat status;
+	if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(GUISnapshotHeader))
+	{
+		close(fd);
+		throw std::runtime_error("Invalid GUI snapshot: " + name);
+	}
+	size = static_cast<size_t>(status.st_size);
+	void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		throw std::runtime_error("Cannot map shared memory: " + name);
+	}
+
+	header = static_cast<const GUISnapshotHeader*>(data);
+	slots = reinterpret_cast<const GUISnapshotSlot*>(static_cast<const char*>(data) + sizeof(GUISnapshotHeader));
+	bool valid = header->magic == GUISnapshotHeader::MAGIC;
+	atomic_thread_fence(memory_order_acquire);
+	if (!valid || header->version != GUISnapshotHeader::VERSION || header->slotSize != sizeof(GUISnapshotSlot)
+		|| sizeof(GUISnapshotHeader) + header->capacity * sizeof(GUISnapshotSlot) > size)
+	{
+		munmap(data, size);
+		throw std::runtime_error("Invalid GUI snapshot: " + name);
+	}
+}
+
+GUISnapshotReader::~GUISnapshotReader()
+{
+	munmap(const_cast<GUISnapshotHeader*>(header), size);
+}
+
+bool GUISnapshotReader::Read(size_t slot, GUIQuote& quote) const
+{
+	if (slot >= header->capacity)
+	{
+		return false;
+	}
+	const GUISnapshotSlot& source = slots[slot];
+	uint64_t words[GUISnapshotSlot::WORDS];
+	while (true)
+	{
+		uint64_t before = source.sequence.load(memory_order_acquire);
+		if (before == 0)
+		{
+			return false;
+		}
+		if (before & 1)
+		{
+			continue;
+		}
+		for (size_t i = 0; i < GUISnapshotSlot::WORDS; i++)
+		{
+			words[i] = source.words[i].load(memory_order_relaxed);
+		}
+		atomic_thread_fence(memory_order_acquire);
+		if (source.sequence.load(memory_order_relaxed) == before)
+		{
+			break;
+		}
+	}
+	memcpy(&quote, words, sizeof(GUIQuote));
+	return true;
+}
+
+size_t GUISnapshotReader::GetUsed() const
+{
+	return header->used.load(memory_order_acquire);
+}
+
+size_t GUISnapshotReader::GetCapacity() const
+{
+	return header->capacity;
+}
+
+bool GUISnapshotReader::IsClosed() const
+{
+	return header->closed.load(memory_order_acquire) != 0;
+}
+
+#endif
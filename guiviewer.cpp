@@ -0,0 +1,73 @@
+// guiviewer.cpp
+//
+// Purpose: 1. Demo GUI reading the shared memory snapshot of the trading system (see guisnapshot.hpp).
+// 2. Usage: guiviewer [segment name] [interval ms] [frames], frames 0 runs until the trading system exits.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "guisnapshot.hpp"
+#include "timestamp.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+// Print every quote of the snapshot
+void PrintFrame(const GUISnapshotReader& reader, TimestampFormatter& formatter)
+{
+	cout << left << setw(12) << "Product" << right << setw(14) << "Bid" << setw(14) << "Offer" << setw(14) << "Mid"
+		<< setw(12) << "Spread" << "  " << left << setw(24) << "Time" << right << setw(10) << "Updates" << endl;
+	GUIQuote quote;
+	for (size_t slot = 0; slot < reader.GetUsed(); slot++)
+	{
+		if (!reader.Read(slot, quote))
+		{
+			continue;
+		}
+		string time;
+		if (quote.timestamp != 0)
+		{
+			formatter.Append(system_clock::time_point(duration_cast<system_clock::duration>(nanoseconds(quote.timestamp))), time);
+		}
+		cout << left << setw(12) << quote.productId << right << fixed << setprecision(6)
+			<< setw(14) << quote.bid << setw(14) << quote.offer << setw(14) << (quote.bid + quote.offer) / 2.0
+			<< setw(12) << quote.offer - quote.bid << "  " << left << setw(24) << time << right << setw(10) << quote.updates << endl;
+	}
+	cout << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	string name = argc > 1 ? argv[1] : GUI_SNAPSHOT_NAME;
+	int interval = argc > 2 ? stoi(argv[2]) : 500;
+	long frames = argc > 3 ? stol(argv[3]) : 0;
+
+	try
+	{
+		GUISnapshotReader reader(name);
+		TimestampFormatter formatter;
+		for (long frame = 0; frames == 0 || frame < frames; frame++)
+		{
+			bool closed = reader.IsClosed();
+			PrintFrame(reader, formatter);
+			if (closed)
+			{
+				cout << "Trading system closed the snapshot." << endl;
+				break;
+			}
+			this_thread::sleep_for(milliseconds(interval));
+		}
+	}
+	catch (const exception& e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -15,9 +15,33 @@
 #include "executionservice.hpp"
 #include "inquiryservice.hpp"
 #include "positionservice.hpp"
+#include "scenarioriskservice.hpp"
+#include "pnlservice.hpp"
 #include "utilities.hpp"
+#include "asyncfilewriter.hpp"
+#include <memory>
+#include <sstream>
+#include <mutex>
 
-enum ServiceType {POSITION, RISK, EXECUTION, STREAMING, INQUIRY};
+enum ServiceType {POSITION, RISK, EXECUTION, STREAMING, INQUIRY, SCENARIO, PNL};
+
+// Get the persistent key of the data
+// the product identifier for positions, risk and streams, the product and book for PnL,
+// the scenario name for scenario risk, the order or inquiry identifier otherwise
+template<typename T>
+string PersistKey(const Position<T>& data) { return data.GetProduct().GetProductId(); }
+template<typename T>
+string PersistKey(const PV01<T>& data) { return data.GetProduct().GetProductId(); }
+template<typename T>
+string PersistKey(const PriceStream<T>& data) { return data.GetProduct().GetProductId(); }
+template<typename T>
+string PersistKey(const ExecutionOrder<T>& data) { return data.GetOrderId(); }
+template<typename T>
+string PersistKey(const Inquiry<T>& data) { return data.GetInquiryId(); }
+template<typename T>
+string PersistKey(const ScenarioRisk<T>& data) { return data.GetScenario(); }
+template<typename T>
+string PersistKey(const PnL<T>& data) { return data.GetProduct().GetProductId() + "," + data.GetBook(); }
 
 
 // pre declaration
@@ -36,9 +60,8 @@ template<typename T>
 class HistoricalDataService : Service<string,T>
 {
 public:
-    // ctor and dtor
-    HistoricalDataService(ServiceType _type);  
-    ~HistoricalDataService()=default;
+    // ctor
+    HistoricalDataService(ServiceType _type, FsyncPolicy _fsyncPolicy = FSYNC_NEVER);
 
     // Get data on our service given a key
     T& GetData(string key) override;
@@ -61,20 +84,28 @@ public:
     // Get the type of the service
     ServiceType GetServiceType() const;
 
+    // Get the fsync policy of the output file
+    FsyncPolicy GetFsyncPolicy() const;
+
     // Persist data to a store
     // call the connector to persist/publish data to an external store (such as KDB database)
     void PersistData(string persistKey, T& data);
 
+    // Persist a batch of data to a store with one connector call
+    void PersistDataBatch(span<T> batch);
+
 private:
     map<string, T> hisData; // store data keyed by some persistent key
     vector<ServiceListener<T>*> listeners; // list of listeners to this service
-    HistoricalDataConnector<T>* connector; // connector related to this server
+    unique_ptr<HistoricalDataConnector<T>> connector; // connector related to this server, owns the output file and writes out whatever is still buffered when freed
     ServiceType type; // type of the service
-    HistoricalDataServiceListener<T>* historicalservicelistener; // listener to this service
+    unique_ptr<HistoricalDataServiceListener<T>> historicalservicelistener; // listener to this service
+    FsyncPolicy fsyncPolicy; // fsync policy of the output file
+    mutex persistLock; // serialises persisting, sharded edges persist data of different products at once
 };
 
 template<typename T>
-HistoricalDataService<T>::HistoricalDataService(ServiceType _type) : type(_type), historicalservicelistener(new HistoricalDataServiceListener<T>(this)), connector(new HistoricalDataConnector<T>(this))
+HistoricalDataService<T>::HistoricalDataService(ServiceType _type, FsyncPolicy _fsyncPolicy) : connector(new HistoricalDataConnector<T>(this)), type(_type), historicalservicelistener(new HistoricalDataServiceListener<T>(this)), fsyncPolicy(_fsyncPolicy)
 {
 }
 
@@ -116,13 +147,13 @@ const vector< ServiceListener<T>* >& HistoricalDataService<T>::GetListeners() co
 template<typename T>
 HistoricalDataServiceListener<T>* HistoricalDataService<T>::GetHistoricalDataServiceListener()
 {
-    return historicalservicelistener;
+    return historicalservicelistener.get();
 }
 
 template<typename T>
 HistoricalDataConnector<T>* HistoricalDataService<T>::GetConnector()
 {
-    return connector;
+    return connector.get();
 }
 
 template<typename T>
@@ -131,12 +162,19 @@ ServiceType HistoricalDataService<T>::GetServiceType() const
     return type;
 }
 
+template<typename T>
+FsyncPolicy HistoricalDataService<T>::GetFsyncPolicy() const
+{
+    return fsyncPolicy;
+}
+
 // Historical data service listener subscribes data from position, risk, execution, streaming and inquiry services.
 // call the connector to persist/publish data to an external store (such as KDB database)
 // NOTE: since data from different services are keyed by different keys, we need to pass in the key as function parameter as well
 template<typename T>
 void HistoricalDataService<T>::PersistData(string persistKey, T& data)
 {
+    lock_guard<mutex> guard(persistLock);
     // save position/risk/execution/inquiry/streaming data to the service
     if (hisData.find(persistKey) == hisData.end())
     hisData.insert(pair<string, T>(persistKey, data));
@@ -147,12 +185,25 @@ void HistoricalDataService<T>::PersistData(string persistKey, T& data)
     connector->Publish(data);
 }
 
+template<typename T>
+void HistoricalDataService<T>::PersistDataBatch(span<T> batch)
+{
+    lock_guard<mutex> guard(persistLock);
+    for (auto& data : batch)
+    {
+        hisData[PersistKey(data)] = data;
+    }
+
+    // persist/publish the whole batch to an external data store
+    connector->PublishBatch(batch);
+}
+
 /**
 * Historical Data Connector publishing data from Historical Data Service.
 * Type T is the data type to persist.
  */
 template<typename T>
-class HistoricalDataConnector : public Connector<T>
+class HistoricalDataConnector final : public Connector<T>
 {
 private:
     HistoricalDataService<T>* service;
@@ -162,6 +213,26 @@ public:
     HistoricalDataConnector(HistoricalDataService<T>* _service);
     // Publish-only connector, publish to external source
     void Publish(T& data);
+
+    // Publish a batch of data with one write to the output file
+    void PublishBatch(span<T> batch);
+
+    // Block until everything published so far is in the output file
+    void Flush();
+
+private:
+    // Get the output file of the service
+    string GetFileName() const;
+
+    // Get the writer of the output file, opening it on first use
+    AsyncFileWriter& GetWriter();
+
+    // Format one record into the record buffer, stamped with the event time of the data if it carries one, else now
+    void FormatRecord(const T& data, std::chrono::system_clock::time_point now);
+
+    unique_ptr<AsyncFileWriter> writer; // keeps the output file open between records
+    TimestampFormatter timestamps;
+    ostringstream record; // reused formatting buffer
 };
 
 template<typename T>
@@ -174,13 +245,72 @@ HistoricalDataConnector<T>::HistoricalDataConnector(HistoricalDataService<T>* _s
  * Publish data to the Connector
  * call the connector to persist/publish data to an external store (such as KDB database)
  * for data from different services, obtain the string representation of these objects and vend out 
- * into positions.txt, risk.txt, executions.txt, allinquiries.txt, streaming.txt
+ * into positions.txt, risk.txt, executions.txt, allinquiries.txt, streaming.txt, scenarios.txt, pnl.txt
  */
 template<typename T>
 void HistoricalDataConnector<T>::Publish(T& data)
+{
+    SOA_RECORD_SINCE_INGRESS("publish." + GetFileName().substr(GetFileName().rfind('/') + 1));
+    record.str("");
+    FormatRecord(data, std::chrono::system_clock::now());
+    GetWriter().Write(record.view());
+}
+
+template<typename T>
+void HistoricalDataConnector<T>::PublishBatch(span<T> batch)
+{
+    SOA_RECORD_SINCE_INGRESS("publish." + GetFileName().substr(GetFileName().rfind('/') + 1));
+    record.str("");
+    auto now = std::chrono::system_clock::now();
+    for (auto& data : batch)
+    {
+        FormatRecord(data, now);
+    }
+    GetWriter().Write(record.view());
+}
+
+template<typename T>
+void HistoricalDataConnector<T>::Flush()
+{
+    if (writer)
+    {
+        writer->Flush();
+    }
+}
+
+template<typename T>
+AsyncFileWriter& HistoricalDataConnector<T>::GetWriter()
+{
+    // opened lazily: the connector is built before the service has set its type
+    if (!writer)
+    {
+        writer.reset(new AsyncFileWriter(GetFileName(), service->GetFsyncPolicy()));
+    }
+    return *writer;
+}
+
+template<typename T>
+void HistoricalDataConnector<T>::FormatRecord(const T& data, std::chrono::system_clock::time_point now)
+{
+    auto time = now;
+    if constexpr (requires { data.GetTimestamp(); })
+    {
+        if (data.GetTimestamp() != 0)
+        {
+            time = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(data.GetTimestamp())));
+        }
+    }
+    char timestamp[TimestampFormatter::LENGTH];
+    timestamps.Format(time, timestamp);
+    // need overloading operator<< for different data types
+    record.write(timestamp, TimestampFormatter::LENGTH);
+    record << ',' << data << '\n';
+}
+
+template<typename T>
+string HistoricalDataConnector<T>::GetFileName() const
 {
     ServiceType type = service->GetServiceType();
-    ofstream outFile;
     string fileName;
     switch (type)
     {
@@ -199,16 +329,16 @@ void HistoricalDataConnector<T>::Publish(T& data)
     case INQUIRY:
         fileName = "./result/allinquiries.txt";
         break;
+    case SCENARIO:
+        fileName = "./result/scenarios.txt";
+        break;
+    case PNL:
+        fileName = "./result/pnl.txt";
+        break;
     default:
         break;
   }
-    outFile.open(fileName, ios::app);
-    if (outFile.is_open())
-    {
-        // need overloading operator<< for different data types
-        outFile << getTime() << "," << data << endl;
-    }
-    outFile.close();
+    return fileName;
 }
 
 /**
@@ -216,7 +346,7 @@ void HistoricalDataConnector<T>::Publish(T& data)
 * Type T is the data type to persist.
 */
 template<typename T>
-class HistoricalDataServiceListener : public ServiceListener<T>
+class HistoricalDataServiceListener final : public ServiceListener<T>
 {
 private:
     HistoricalDataService<T>* service;
@@ -230,11 +360,15 @@ public:
     void ProcessAdd(PriceStream<Bond>& data);
     void ProcessAdd(ExecutionOrder<Bond>& data);
     void ProcessAdd(Inquiry<Bond>& data);
+    void ProcessAdd(ScenarioRisk<Bond>& data);
+    void ProcessAdd(PnL<Bond>& data);
 
     // Listener callback to process a remove event to the Service
     void ProcessRemove(T& data) override;
     // Listener callback to process an update event to the Service
     void ProcessUpdate(T& data) override;
+    // Listener callback to process a batch of add events to the Service
+    void ProcessAddBatch(span<T> batch) override;
 };
 
 template<typename T>
@@ -284,6 +418,25 @@ void HistoricalDataServiceListener<T>::ProcessAdd(Inquiry<Bond>& data)
     service->PersistData(persistKey, data);
 }
 
+template<typename T>
+void HistoricalDataServiceListener<T>::ProcessAdd(ScenarioRisk<Bond>& data)
+{
+    string persistKey = data.GetScenario();
+    service->PersistData(persistKey, data);
+}
+
+template<typename T>
+void HistoricalDataServiceListener<T>::ProcessAdd(PnL<Bond>& data)
+{
+    service->PersistData(PersistKey(data), data);
+}
+
+
+template<typename T>
+void HistoricalDataServiceListener<T>::ProcessAddBatch(span<T> batch)
+{
+    service->PersistDataBatch(batch);
+}
 
 template<typename T>
 void HistoricalDataServiceListener<T>::ProcessRemove(T& data)
@@ -12,6 +12,7 @@
 #include "soa.hpp"
 #include "utilities.hpp"
 #include "tradebookingservice.hpp"
+#include "csvreader.hpp"
 
 // Various inqyury states
 enum InquiryState { RECEIVED, QUOTED, DONE, REJECTED, CUSTOMER_REJECTED };
@@ -31,6 +32,8 @@ public:
 
     // ctor for an inquiry
     Inquiry(string _inquiryId, const T& _product, Side _side, long _quantity, double _price, InquiryState _state);
+    Inquiry(string _inquiryId, const T& _product, Side _side, long _quantity, TickPrice _price, InquiryState _state);
+    Inquiry(string _inquiryId, ProductHandle _product, Side _side, long _quantity, TickPrice _price, InquiryState _state);
 
     // dtor
     ~Inquiry() = default;
@@ -41,6 +44,9 @@ public:
     // Get the product
     const T& GetProduct() const;
 
+    // Get the registry handle of the product
+    ProductHandle GetProductHandle() const;
+
     // Get the side on the inquiry
     Side GetSide() const;
 
@@ -50,11 +56,15 @@ public:
     // Get the price that we have responded back with
     double GetPrice() const;
 
+    // Get the tick price that we have responded back with
+    TickPrice GetTickPrice() const;
+
     // Get the current state on the inquiry
     InquiryState GetState() const;
 
     // Set the price
     void SetPrice(double _price);
+    void SetPrice(TickPrice _price);
 
     // Set the current state on the inquiry
     void SetState(InquiryState state);
@@ -65,10 +75,10 @@ public:
 
 private:
     string inquiryId;
-    T product;
+    ProductHandle product = EMPTY_PRODUCT;
     Side side;
     long quantity;
-    double price;
+    TickPrice price;
     InquiryState state;
 
 };
@@ -76,7 +86,19 @@ private:
 
 template<typename T>
 Inquiry<T>::Inquiry(string _inquiryId, const T& _product, Side _side, long _quantity, double _price, InquiryState _state) :
-    product(_product), inquiryId(_inquiryId), side(_side), quantity(_quantity), price(_price), state(_state)
+    Inquiry(move(_inquiryId), _product, _side, _quantity, TickPrice::FromDouble(_price), _state)
+{
+}
+
+template<typename T>
+Inquiry<T>::Inquiry(string _inquiryId, const T& _product, Side _side, long _quantity, TickPrice _price, InquiryState _state) :
+    Inquiry(move(_inquiryId), ProductRegistry<T>::Instance().Intern(_product), _side, _quantity, _price, _state)
+{
+}
+
+template<typename T>
+Inquiry<T>::Inquiry(string _inquiryId, ProductHandle _product, Side _side, long _quantity, TickPrice _price, InquiryState _state) :
+    inquiryId(_inquiryId), product(_product), side(_side), quantity(_quantity), price(_price), state(_state)
 {
 }
 
@@ -88,6 +110,12 @@ const string& Inquiry<T>::GetInquiryId() const
 
 template<typename T>
 const T& Inquiry<T>::GetProduct() const
+{
+    return ProductRegistry<T>::Instance().Get(product);
+}
+
+template<typename T>
+ProductHandle Inquiry<T>::GetProductHandle() const
 {
     return product;
 }
@@ -106,12 +134,24 @@ long Inquiry<T>::GetQuantity() const
 
 template<typename T>
 double Inquiry<T>::GetPrice() const
+{
+    return price.ToDouble();
+}
+
+template<typename T>
+TickPrice Inquiry<T>::GetTickPrice() const
 {
     return price;
 }
 
 template<typename T>
 void Inquiry<T>::SetPrice(double _price)
+{
+    price = TickPrice::FromDouble(_price);
+}
+
+template<typename T>
+void Inquiry<T>::SetPrice(TickPrice _price)
 {
     price = _price;
 }
@@ -131,9 +171,8 @@ void Inquiry<T>::SetState(InquiryState _state)
 template<typename T>
 ostream& operator<<(ostream& output, const Inquiry<T>& inquiry)
 {
-    string inquiryId = inquiry.GetInquiryId();
-    T product = inquiry.GetProduct();
-    string productId = product.GetProductId();
+    const string& inquiryId = inquiry.GetInquiryId();
+    const string& productId = inquiry.GetProduct().GetProductId();
 
     Side side = inquiry.GetSide();
     string _side;
@@ -148,7 +187,7 @@ ostream& operator<<(ostream& output, const Inquiry<T>& inquiry)
     }
 
     long quantity = inquiry.GetQuantity();
-    double price = inquiry.GetPrice();
+    TickPrice price = inquiry.GetTickPrice();
 
     string state;
     switch (inquiry.GetState())
@@ -352,8 +391,16 @@ public:
     // Subscribe data from connector
     void Subscribe(ifstream& _datafile);
 
+    // Subscribe data from a file, fields are read straight from the mapped file
+    void Subscribe(const string& _path);
+
     // Subcribe updated inquiry record from the connector
     void SubscribeUpdate(Inquiry<T>& data);
+
+private:
+    // Build an inquiry from the fields of one line and send it to the service
+    template<typename Fields>
+    void SubscribeLine(const Fields& fields);
 };
 
 template<typename T>
@@ -386,19 +433,38 @@ void InquiryConnector<T>::Subscribe(ifstream& _datafile)
         {
             tokens.push_back(token);
         }
-        // create inquiry
-        string inquiryId = tokens[0];
-        string productId = tokens[1];
-        T product = QueryProduct<T>(productId);
-        Side side = tokens[2] == "BUY" ? BUY : SELL;
-        long quantity = stol(tokens[3]);
-        double price = Frac2Price(tokens[4]);
-        InquiryState state = tokens[5] == "RECEIVED" ? RECEIVED : tokens[5] == "QUOTED" ? QUOTED : tokens[5] == "DONE" ? DONE : tokens[5] == "REJECTED" ? REJECTED : CUSTOMER_REJECTED;
-        Inquiry<T> inquiry(inquiryId, product, side, quantity, price, state);
-        service->OnMessage(inquiry);
+        SubscribeLine(tokens);
     }
 }
 
+template <typename T>
+void InquiryConnector<T>::Subscribe(const string& _path)
+{
+    CsvReader reader(_path);
+    while (reader.NextLine())
+    {
+        SubscribeLine(reader);
+    }
+}
+
+template <typename T>
+template <typename Fields>
+void InquiryConnector<T>::SubscribeLine(const Fields& tokens)
+{
+    SOA_STAMP_INGRESS();
+    // create inquiry
+    string inquiryId(tokens[0]);
+    string productId(tokens[1]);
+    ProductHandle product = QueryProductHandle<T>(productId);
+    Side side = tokens[2] == "BUY" ? BUY : SELL;
+    long quantity = ParseLong(tokens[3]);
+    TickPrice price = ParseTickPrice(tokens[4]);
+    InquiryState state = tokens[5] == "RECEIVED" ? RECEIVED : tokens[5] == "QUOTED" ? QUOTED : tokens[5] == "DONE" ? DONE : tokens[5] == "REJECTED" ? REJECTED : CUSTOMER_REJECTED;
+    Inquiry<T> inquiry(inquiryId, product, side, quantity, price, state);
+    SOA_TIME_SCOPE("inquiry.onmessage");
+    service->OnMessage(inquiry);
+}
+
 template<typename T>
 void InquiryConnector<T>::SubscribeUpdate(Inquiry<T>& data)
 {
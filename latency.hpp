@@ -0,0 +1,391 @@
+// latency.hpp
+//
+// Purpose: 1. Defines lock-free log-linear latency histograms in the style of HdrHistogram.
+// 2. Defines the registry that names the histograms and dumps them periodically to a file.
+// 3. Only included by soa.hpp when the build defines SOA_INSTRUMENT.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef LATENCY_HPP
+#define LATENCY_HPP
+
+#include <string>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <array>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+#include <span>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+
+using namespace std;
+
+// Current monotonic time in nanoseconds
+long long LatencyClock()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Time the event being processed on this thread entered the system, 0 if it was not stamped
+thread_local long long eventIngress = 0;
+
+// Batch an inbound connector is handing to its service on this thread, with the ingress time of each event
+struct IngressBatch
+{
+	const char* first = nullptr; // first event of the batch
+	size_t stride = 0; // size of one event
+	size_t size = 0; // number of events
+	const long long* stamps = nullptr; // one per event
+};
+
+thread_local IngressBatch ingressBatch;
+
+// Time an event entered the system: its own stamp if it is an event of the batch being handed over on this thread,
+// otherwise the stamp of the event being processed
+template<typename V>
+long long IngressOf(const V& data)
+{
+	const char* address = reinterpret_cast<const char*>(&data);
+	if (ingressBatch.stride == sizeof(V) && address >= ingressBatch.first && address < ingressBatch.first + ingressBatch.size * sizeof(V))
+	{
+		return ingressBatch.stamps[(address - ingressBatch.first) / sizeof(V)];
+	}
+	return eventIngress;
+}
+
+/**
+ * Hands the ingress stamps of a connector batch to the listeners for the scope of the service call.
+ * Listeners given the batch itself find the stamp of each event with IngressOf(); data derived from the batch
+ * further down carries the stamp of the oldest event, so it counts the time the whole batch waited.
+ * The stamps are cleared for the next batch when the scope ends.
+ */
+class ScopedIngressBatch
+{
+
+public:
+	// ctor, the stamps are those of the events of the batch, in order
+	template<typename V>
+	ScopedIngressBatch(span<V> batch, vector<long long>& _stamps);
+
+	// dtor, withdraws the batch and clears its stamps
+	~ScopedIngressBatch();
+
+private:
+	vector<long long>& stamps;
+
+};
+
+template<typename V>
+ScopedIngressBatch::ScopedIngressBatch(span<V> batch, vector<long long>& _stamps) : stamps(_stamps)
+{
+	if (stamps.size() != batch.size())
+	{
+		throw std::logic_error("Ingress stamps do not match the batch");
+	}
+	ingressBatch = IngressBatch{ reinterpret_cast<const char*>(batch.data()), sizeof(V), batch.size(), stamps.data() };
+	eventIngress = stamps.empty() ? 0 : stamps.front();
+}
+
+ScopedIngressBatch::~ScopedIngressBatch()
+{
+	ingressBatch = IngressBatch();
+	stamps.clear();
+}
+
+/**
+ * Histogram of latencies in nanoseconds with a fixed relative precision.
+ * Values below 64 ns are counted exactly; above that every power of two is split into 32
+ * linear sub-buckets, so a recorded value is known to within 1/32 (about 3%) at any magnitude.
+ * Record() is a relaxed atomic increment and can be called from any number of threads;
+ * readers see a consistent enough snapshot for reporting.
+ */
+class LatencyHistogram
+{
+
+public:
+	// Number of exactly counted values, and linear sub-buckets per power of two above them
+	static const int EXACT_VALUES = 64;
+	static const int SUB_BUCKETS = 32;
+	static const int BUCKETS = EXACT_VALUES + 58 * SUB_BUCKETS;
+
+	// ctor
+	LatencyHistogram();
+
+	// Record one latency, negative values count as 0
+	void Record(long long nanos);
+
+	// Get the number of recorded values
+	uint64_t GetCount() const;
+
+	// Get the largest recorded value
+	long long GetMax() const;
+
+	// Get the mean of the recorded values
+	double GetMean() const;
+
+	// Get the value at a percentile in [0, 100], the upper end of its bucket
+	long long GetPercentile(double percentile) const;
+
+private:
+	// Get the bucket of a value
+	static int BucketOf(uint64_t value);
+
+	// Get the largest value of a bucket
+	static long long BucketTop(int bucket);
+
+	array<atomic<uint64_t>, BUCKETS> counts;
+	atomic<uint64_t> count;
+	atomic<uint64_t> sum;
+	atomic<long long> max;
+
+};
+
+LatencyHistogram::LatencyHistogram() : count(0), sum(0), max(0)
+{
+	for (auto& bucket : counts)
+	{
+		bucket.store(0, memory_order_relaxed);
+	}
+}
+
+void LatencyHistogram::Record(long long nanos)
+{
+	uint64_t value = nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+	counts[BucketOf(value)].fetch_add(1, memory_order_relaxed);
+	count.fetch_add(1, memory_order_relaxed);
+	sum.fetch_add(value, memory_order_relaxed);
+
+	long long current = max.load(memory_order_relaxed);
+	while (static_cast<long long>(value) > current && !max.compare_exchange_weak(current, static_cast<long long>(value), memory_order_relaxed))
+	{
+	}
+}
+
+uint64_t LatencyHistogram::GetCount() const
+{
+	return count.load(memory_order_relaxed);
+}
+
+long long LatencyHistogram::GetMax() const
+{
+	return max.load(memory_order_relaxed);
+}
+
+double LatencyHistogram::GetMean() const
+{
+	uint64_t n = GetCount();
+	return n == 0 ? 0.0 : static_cast<double>(sum.load(memory_order_relaxed)) / n;
+}
+
+long long LatencyHistogram::GetPercentile(double percentile) const
+{
+	uint64_t n = GetCount();
+	if (n == 0)
+	{
+		return 0;
+	}
+
+	// rank of the value, counted from 1
+	uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * n + 0.5);
+	rank = rank < 1 ? 1 : (rank > n ? n : rank);
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < BUCKETS; bucket++)
+	{
+		seen += counts[bucket].load(memory_order_relaxed);
+		if (seen >= rank)
+		{
+			long long top = BucketTop(bucket);
+			return top < GetMax() ? top : GetMax();
+		}
+	}
+	return GetMax();
+}
+
+int LatencyHistogram::BucketOf(uint64_t value)
+{
+	if (value < EXACT_VALUES)
+	{
+		return static_cast<int>(value);
+	}
+	// keep the leading six bits: the top bit picks the power of two, the next five the sub-bucket
+	int shift = (63 - countl_zero(value)) - 5;
+	return EXACT_VALUES + (shift - 1) * SUB_BUCKETS + static_cast<int>((value >> shift) - SUB_BUCKETS);
+}
+
+long long LatencyHistogram::BucketTop(int bucket)
+{
+	if (bucket < EXACT_VALUES)
+	{
+		return bucket;
+	}
+	int shift = (bucket - EXACT_VALUES) / SUB_BUCKETS + 1;
+	long long sub = (bucket - EXACT_VALUES) % SUB_BUCKETS + SUB_BUCKETS;
+	return ((sub + 1) << shift) - 1;
+}
+
+/**
+ * Times the rest of a scope into a histogram.
+ */
+class ScopedLatency
+{
+
+public:
+	// ctor, starts the clock
+	ScopedLatency(LatencyHistogram& _histogram) : histogram(_histogram), start(LatencyClock()) {}
+
+	// dtor, records the time since the ctor
+	~ScopedLatency() { histogram.Record(LatencyClock() - start); }
+
+private:
+	LatencyHistogram& histogram;
+	long long start;
+
+};
+
+/**
+ * Registry of the named latency histograms of the process.
+ * Histograms are created on first use and live for the lifetime of the program, so callers
+ * look a name up once and keep the reference. A background thread can write every histogram
+ * to a file at a fixed interval; each dump is a cumulative snapshot.
+ */
+class LatencyRegistry
+{
+
+public:
+	// Get the registry of the process
+	static LatencyRegistry& Instance();
+
+	// dtor, stops the dump thread
+	~LatencyRegistry();
+
+	// Get the histogram of a name, creating it if needed
+	LatencyHistogram& Get(const string& name);
+
+	// Write a snapshot of every histogram
+	void Dump(ostream& out);
+
+	// Start dumping every histogram to a file at a fixed interval (throws if the file cannot be opened)
+	void StartDump(const string& path, int intervalMillis);
+
+	// Stop the dump thread after one last snapshot
+	void StopDump();
+
+private:
+	// ctor
+	LatencyRegistry();
+
+	// Dump thread body
+	void Run();
+
+	mutex lock;
+	map<string, unique_ptr<LatencyHistogram>> histograms; // sorted by name, so related hops dump together
+
+	ofstream dumpFile;
+	chrono::milliseconds dumpInterval;
+	chrono::steady_clock::time_point dumpStart;
+	int snapshots;
+	bool dumping;
+	condition_variable wakeDumper;
+	thread dumper;
+
+};
+
+LatencyRegistry& LatencyRegistry::Instance()
+{
+	static LatencyRegistry registry;
+	return registry;
+}
+
+LatencyRegistry::LatencyRegistry() : dumpInterval(1000), snapshots(0), dumping(false)
+{
+}
+
+LatencyRegistry::~LatencyRegistry()
+{
+	StopDump();
+}
+
+LatencyHistogram& LatencyRegistry::Get(const string& name)
+{
+	lock_guard<mutex> guard(lock);
+	unique_ptr<LatencyHistogram>& histogram = histograms[name];
+	if (!histogram)
+	{
+		histogram.reset(new LatencyHistogram());
+	}
+	return *histogram;
+}
+
+void LatencyRegistry::Dump(ostream& out)
+{
+	lock_guard<mutex> guard(lock);
+	long long elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - dumpStart).count();
+	out << "# snapshot " << ++snapshots << " at " << elapsed << " ms" << '\n';
+	out << "histogram,count,mean,p50,p90,p99,p99.9,max (ns)" << '\n';
+	for (auto& entry : histograms)
+	{
+		const LatencyHistogram& histogram = *entry.second;
+		out << entry.first << ',' << histogram.GetCount() << ',' << fixed << setprecision(0) << histogram.GetMean() << ','
+			<< histogram.GetPercentile(50.0) << ',' << histogram.GetPercentile(90.0) << ','
+			<< histogram.GetPercentile(99.0) << ',' << histogram.GetPercentile(99.9) << ',' << histogram.GetMax() << '\n';
+	}
+	out << '\n';
+	out.flush();
+}
+
+void LatencyRegistry::StartDump(const string& path, int intervalMillis)
+{
+	StopDump();
+	dumpFile.open(path, ios::out | ios::trunc);
+	if (!dumpFile)
+	{
+		throw std::runtime_error("Cannot open file: " + path);
+	}
+	dumpInterval = chrono::milliseconds(intervalMillis);
+	dumpStart = chrono::steady_clock::now();
+	snapshots = 0;
+	dumping = true;
+	dumper = thread(&LatencyRegistry::Run, this);
+}
+
+void LatencyRegistry::StopDump()
+{
+	if (!dumper.joinable())
+	{
+		return;
+	}
+	{
+		lock_guard<mutex> guard(lock);
+		dumping = false;
+	}
+	wakeDumper.notify_one();
+	dumper.join();
+	Dump(dumpFile);
+	dumpFile.close();
+}
+
+void LatencyRegistry::Run()
+{
+	while (true)
+	{
+		{
+			unique_lock<mutex> guard(lock);
+			if (wakeDumper.wait_for(guard, dumpInterval, [this]() { return !dumping; }))
+			{
+				return;
+			}
+		}
+		Dump(dumpFile);
+	}
+}
+
+#endif
@@ -15,6 +15,8 @@
 #include "marketdataservice.hpp"
 #include "pricingservice.hpp"
 #include "riskservice.hpp"
+#include "scenarioriskservice.hpp"
+#include "pnlservice.hpp"
 #include "executionservice.hpp"
 #include "positionservice.hpp"
 #include "inquiryservice.hpp"
@@ -24,11 +26,72 @@
 #include "tradebookingservice.hpp"
 #include "algoexecutionservice.hpp"
 #include "guiservice.hpp"
+#include "asynclistener.hpp"
+#include "staticpipeline.hpp"
 #include "utilities.hpp"
 
 using namespace std;
 
-int main(){
+// Usage: tradingsystem [--async <edge>|all]... [--pin] [--fsync never|flush|close] [--dynamic] [--shards <workers>] [--ticks] [--console <every>] [--gui-snapshot <name>] [--live-risk] [--scenarios] [--pnl]
+// --async runs the named listener edge (e.g. pricing-algostreaming) on its own thread, --pin pins those threads.
+// --fsync sets when the historical data files are forced to disk (default never).
+// --dynamic links the price chain through dynamic listeners instead of the static pipeline.
+// --shards runs each product flow on a pool of workers, one strand per product (replaces --async).
+// --ticks generates prices and order books as binary tick files and replays them without parsing.
+// --console prints one in every <every> price streams and execution orders (default 1, 0 for none).
+// --live-risk links the pricing service to the risk service, so the unit PV01 follows the yields of the live prices.
+// --scenarios evaluates the standard curve stress grid over the final positions into result/scenarios.txt.
+// --pnl marks the trades to the mid per product and book, realised and unrealised, into result/pnl.txt.
+// --gui-snapshot publishes the latest price of every product into a shared memory segment (e.g. /tradingsystem_gui) for guiviewer.
+int main(int argc, char* argv[]){
+
+	set<string> asyncEdges;
+	bool pin = false;
+	bool dynamic = false;
+	bool binaryTicks = false;
+	size_t shards = 0;
+	string guiSnapshot;
+	bool liveRisk = false;
+	bool scenarios = false;
+	bool pnl = false;
+	FsyncPolicy fsyncPolicy = FSYNC_NEVER;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--async" && i + 1 < argc) {
+			asyncEdges.insert(argv[++i]);
+		}
+		else if (arg == "--pin") {
+			pin = true;
+		}
+		else if (arg == "--dynamic") {
+			dynamic = true;
+		}
+		else if (arg == "--console" && i + 1 < argc) {
+			SampledSink::SetInterval(stoul(argv[++i]));
+		}
+		else if (arg == "--gui-snapshot" && i + 1 < argc) {
+			guiSnapshot = argv[++i];
+		}
+		else if (arg == "--live-risk") {
+			liveRisk = true;
+		}
+		else if (arg == "--scenarios") {
+			scenarios = true;
+		}
+		else if (arg == "--pnl") {
+			pnl = true;
+		}
+		else if (arg == "--ticks") {
+			binaryTicks = true;
+		}
+		else if (arg == "--shards" && i + 1 < argc) {
+			shards = stoul(argv[++i]);
+		}
+		else if (arg == "--fsync" && i + 1 < argc) {
+			string policy = argv[++i];
+			fsyncPolicy = (policy == "flush") ? FSYNC_ON_FLUSH : (policy == "close") ? FSYNC_ON_CLOSE : FSYNC_NEVER;
+		}
+	}
 
 	// ----- Data Path Setup -----
 	string dataPath = "./data";
@@ -46,21 +109,23 @@ int main(){
 	filesystem::create_directory(resPath);
 
 	// Define paths for different data files
-	const string pricePath = "./data/prices.txt";
-	const string marketDataPath = "./data/marketdata.txt";
+	const string pricePath = binaryTicks ? "./data/prices.ticks" : "./data/prices.txt";
+	const string marketDataPath = binaryTicks ? "./data/marketdata.ticks" : "./data/marketdata.txt";
 	const string tradePath = "./data/trades.txt";
 	const string inquiryPath = "./data/inquiries.txt";
 
 	// ----- Data Generation -----
 	log(LogLevel::INFO, "Generating price and orderbook data...");
 	vector<string> bonds = { "9128283H1", "9128283L2", "912828M80", "9128283J7", "9128283F5", "912810TW8", "912810RZ3" };
-	genOrderBook(bonds, pricePath, marketDataPath, 39373, 1000000);
+	genOrderBook(bonds, pricePath, marketDataPath, 39373, 1000000, 0, binaryTicks ? BINARY_TICKS : CSV_TICKS);
 	genTrades(bonds, tradePath, 39373);
 	genInquiries(bonds, inquiryPath, 39373);
 	log(LogLevel::INFO, "Data generation complete.");
 
     // ----- create services -----
     log(LogLevel::INFO, "Initializing service components...");
+	// intern every product before the services start handing out handles
+	RegisterProducts<Bond>();
 	PricingService<Bond> pricingService;
 	AlgoStreamingService<Bond> algoStreamingService;
 	StreamingService<Bond> streamingService;
@@ -70,61 +135,122 @@ int main(){
 	TradeBookingService<Bond> tradeBookingService;
 	PositionService<Bond> positionService;
 	RiskService<Bond> riskService;
+	ScenarioRiskService<Bond> scenarioRiskService;
+	PnLService<Bond> pnlService;
 	GUIService<Bond> guiService;
 	InquiryService<Bond> inquiryService;
+	if (!guiSnapshot.empty()) {
+		guiService.EnableSnapshot(guiSnapshot);
+	}
 
 	// ----- HistoricalDataService initialize -----
-	HistoricalDataService<Position<Bond>> historicalPositionService(POSITION);
-	HistoricalDataService<PV01<Bond>> historicalRiskService(RISK);
-	HistoricalDataService<ExecutionOrder<Bond>> historicalExecutionService(EXECUTION);
-	HistoricalDataService<PriceStream<Bond>> historicalStreamingService(STREAMING);
-	HistoricalDataService<Inquiry<Bond>> historicalInquiryService(INQUIRY);
+	HistoricalDataService<Position<Bond>> historicalPositionService(POSITION, fsyncPolicy);
+	HistoricalDataService<PV01<Bond>> historicalRiskService(RISK, fsyncPolicy);
+	HistoricalDataService<ExecutionOrder<Bond>> historicalExecutionService(EXECUTION, fsyncPolicy);
+	HistoricalDataService<PriceStream<Bond>> historicalStreamingService(STREAMING, fsyncPolicy);
+	HistoricalDataService<Inquiry<Bond>> historicalInquiryService(INQUIRY, fsyncPolicy);
+	HistoricalDataService<ScenarioRisk<Bond>> historicalScenarioService(SCENARIO, fsyncPolicy);
+	HistoricalDataService<PnL<Bond>> historicalPnLService(PNL, fsyncPolicy);
 	log(LogLevel::INFO, "Trading services initialized.");
 
 	// ----- create listeners -----
 	log(LogLevel::INFO, "Linking service listeners...");
-	pricingService.AddListener(algoStreamingService.GetAlgoStreamingListener());
-	pricingService.AddListener(guiService.GetGUIServiceListener());
-	algoStreamingService.AddListener(streamingService.GetStreamingServiceListener());
-	marketDataService.AddListener(algoExecutionService.GetAlgoExecutionServiceListener());
-	algoExecutionService.AddListener(executionService.GetExecutionServiceListener());
-	executionService.AddListener(tradeBookingService.GetTradeBookingServiceListener());
-	tradeBookingService.AddListener(positionService.GetPositionListener());
-	positionService.AddListener(riskService.GetRiskServiceListener());
-
-	positionService.AddListener(historicalPositionService.GetHistoricalDataServiceListener());
-	executionService.AddListener(historicalExecutionService.GetHistoricalDataServiceListener());
-	streamingService.AddListener(historicalStreamingService.GetHistoricalDataServiceListener());
-	riskService.AddListener(historicalRiskService.GetHistoricalDataServiceListener());
-	inquiryService.AddListener(historicalInquiryService.GetHistoricalDataServiceListener());
+	StaticPipeline<Price<Bond>, AlgoStreamingService<Bond>, StreamingService<Bond>> pricePipeline(algoStreamingService, streamingService);
+	if (shards > 0 && !asyncEdges.empty()) {
+		// sharded edges feed their downstream edges from many workers, which a single-producer edge cannot take
+		log(LogLevel::WARNING, "--shards replaces --async, all other edges run synchronously on the workers.");
+		asyncEdges.clear();
+	}
+	ServiceWiring wiring(asyncEdges, pin);
+	if (shards > 0) {
+		// the entry edge of each product flow runs on the workers, everything after it stays on the product's strand
+		wiring.Shard({ "pricing-algostreaming", "marketdata-algoexecution", "tradebooking-position" }, shards);
+	}
+	// pricing -> algo streaming -> streaming is composed at compile time,
+	// unless asked for dynamic listeners or the inner edge has to run on its own thread
+	if (dynamic || wiring.IsAsync("algostreaming-streaming")) {
+		wiring.Link(pricingService, algoStreamingService.GetAlgoStreamingListener(), "pricing-algostreaming");
+		wiring.Link(algoStreamingService, streamingService.GetStreamingServiceListener(), "algostreaming-streaming");
+	}
+	else {
+		wiring.Link(pricingService, &pricePipeline, "pricing-algostreaming");
+	}
+	wiring.Link(pricingService, guiService.GetGUIServiceListener(), "pricing-gui");
+	if (liveRisk) {
+		wiring.Link(pricingService, riskService.GetRiskPriceListener(), "pricing-risk");
+	}
+	wiring.Link(marketDataService, algoExecutionService.GetAlgoExecutionServiceListener(), "marketdata-algoexecution");
+	wiring.Link(algoExecutionService, executionService.GetExecutionServiceListener(), "algoexecution-execution");
+	wiring.Link(executionService, tradeBookingService.GetTradeBookingServiceListener(), "execution-tradebooking");
+	wiring.Link(tradeBookingService, positionService.GetPositionListener(), "tradebooking-position");
+	wiring.Link(positionService, riskService.GetRiskServiceListener(), "position-risk");
+	if (pnl) {
+		wiring.Link(pricingService, pnlService.GetPnLPriceListener(), "pricing-pnl");
+		wiring.Link(tradeBookingService, pnlService.GetPnLTradeListener(), "tradebooking-pnl");
+	}
+	if (scenarios) {
+		if (liveRisk) {
+			wiring.Link(pricingService, scenarioRiskService.GetScenarioPriceListener(), "pricing-scenario");
+		}
+		wiring.Link(positionService, scenarioRiskService.GetScenarioPositionListener(), "position-scenario");
+	}
+
+	wiring.Link(positionService, historicalPositionService.GetHistoricalDataServiceListener(), "position-historical");
+	wiring.Link(executionService, historicalExecutionService.GetHistoricalDataServiceListener(), "execution-historical");
+	wiring.Link(streamingService, historicalStreamingService.GetHistoricalDataServiceListener(), "streaming-historical");
+	wiring.Link(riskService, historicalRiskService.GetHistoricalDataServiceListener(), "risk-historical");
+	wiring.Link(inquiryService, historicalInquiryService.GetHistoricalDataServiceListener(), "inquiry-historical");
+	wiring.Link(scenarioRiskService, historicalScenarioService.GetHistoricalDataServiceListener(), "scenario-historical");
+	wiring.Link(pnlService, historicalPnLService.GetHistoricalDataServiceListener(), "pnl-historical");
 	log(LogLevel::INFO, "Service listeners linked.");
 
+	// per-hop latency histograms, written every second when built with SOA_INSTRUMENT
+	SOA_START_LATENCY_DUMP("./result/latency.txt", 1000);
+
 	// ----- test the data flows -----
 	// -- price data -> pricing service -> algo streaming service -> streaming service -> historical data service --
-	cout << fixed << setprecision(6);
     log(LogLevel::INFO, "Processing price data...");
-	ifstream pricedata(pricePath.c_str());
-	pricingService.GetConnector()->Subscribe(pricedata);
+	if (binaryTicks) {
+		pricingService.GetConnector()->SubscribeTicks(pricePath);
+	}
+	else {
+		pricingService.GetConnector()->Subscribe(pricePath);
+	}
+	wiring.DrainAll();
 	log(LogLevel::INFO, "Price data flows succeed.");
 
 	// -- orderbook data -> market data service -> algo execution service -> execution service -> historical data service --
 	log(LogLevel::INFO, "Processing market data...");
-	ifstream marketdata(marketDataPath.c_str());
-	marketDataService.GetConnector()->Subscribe(marketdata);
+	if (binaryTicks) {
+		marketDataService.GetConnector()->SubscribeTicks(marketDataPath);
+	}
+	else {
+		marketDataService.GetConnector()->Subscribe(marketDataPath);
+	}
+	wiring.DrainAll();
 	log(LogLevel::INFO, "Market data flows succeed.");
 
 	// -- trade data -> trade booking service -> position service -> risk service -> historical data service --
 	log(LogLevel::INFO, "Processing trade data...");
-	ifstream tradedata(tradePath.c_str());
-	tradeBookingService.GetConnector()->Subscribe(tradedata);
+	tradeBookingService.GetConnector()->Subscribe(tradePath);
+	wiring.DrainAll();
 	log(LogLevel::INFO, "Trade data flows succeed.");
 
+	// -- positions -> scenario risk service -> historical data service --
+	if (scenarios) {
+		log(LogLevel::INFO, "Evaluating scenario risk...");
+		scenarioRiskService.Evaluate();
+		wiring.DrainAll();
+		log(LogLevel::INFO, "Scenario risk evaluated.");
+	}
+
 	// -- inquiry data -> inquiry service -> historical data service --
 	log(LogLevel::INFO, "Processing inquiry data...");
-	ifstream inquirydata(inquiryPath.c_str());
-	inquiryService.GetConnector()->Subscribe(inquirydata);
+	inquiryService.GetConnector()->Subscribe(inquiryPath);
+	wiring.DrainAll();
 	log(LogLevel::INFO, "Inquiry data flows succeed.");
-	std::cout << std::endl << std::endl;
+	SOA_STOP_LATENCY_DUMP();
+	AsyncLogger::Instance().Log(LogFormat("\n\n"));
 	log(LogLevel::FINAL, "Trading system built successfully.");
 
 }
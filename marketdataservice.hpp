@@ -15,6 +15,7 @@
 #include <algorithm>
 #include "soa.hpp"
 #include "utilities.hpp"
+#include "csvreader.hpp"
 
 using namespace std;
 
@@ -34,9 +35,15 @@ public:
 	// ctor for an order
 	Order(double _price, long _quantity, PricingSide _side);
 
+	// ctor for an order at a tick price
+	Order(TickPrice _price, long _quantity, PricingSide _side);
+
 	// Get the price on the order
 	double GetPrice() const;
 
+	// Get the tick price on the order
+	TickPrice GetTickPrice() const;
+
 	// Get the quantity on the order
 	long GetQuantity() const;
 
@@ -44,18 +51,28 @@ public:
 	PricingSide GetSide() const;
 
 private:
-	double price;
+	TickPrice price;
 	long quantity;
 	PricingSide side;
 
 };
 
 Order::Order(double _price, long _quantity, PricingSide _side) :
+  price(TickPrice::FromDouble(_price)), quantity(_quantity), side(_side)
+{
+}
+
+Order::Order(TickPrice _price, long _quantity, PricingSide _side) :
   price(_price), quantity(_quantity), side(_side)
 {
 }
 
 double Order::GetPrice() const
+{
+	return price.ToDouble();
+}
+
+TickPrice Order::GetTickPrice() const
 {
 	return price;
 }
@@ -112,6 +129,9 @@ const Order& BidOffer::GetOfferOrder() const
 
 /**
  * Order book with a bid and offer stack.
+ * A book built from raw stacks keeps every order as pushed (stack mode). A book built with
+ * a depth is a fixed-depth book: each side holds at most depth aggregated price levels,
+ * sorted best first (bids descending, offers ascending) and updated in place.
  * Type T is the product type.
  */
 template<typename T>
@@ -123,37 +143,89 @@ public:
 	// default ctor, needed for the map data structure
 	OrderBook() = default;
 
-	// ctor for the order book
+	// ctor for the order book (stack mode)
 	OrderBook(const T &_product, const vector<Order> &_bidStack, const vector<Order> &_offerStack);
 
+	// ctor for a fixed-depth order book with at most _depth price levels per side
+	OrderBook(const T &_product, int _depth);
+	OrderBook(ProductHandle _product, int _depth);
+
 	// Get the product
 	const T& GetProduct() const;
 
+	// Get the registry handle of the product
+	ProductHandle GetProductHandle() const;
+
 	// Get the bid stack
 	vector<Order>& GetBidStack();
 
 	// Get the offer stack
 	vector<Order>& GetOfferStack();
 
+	// Get the maximum number of levels per side (0 for a stack mode book)
+	int GetDepth() const;
+
+	// Is this a fixed-depth book?
+	bool IsFixedDepth() const;
+
+	// Replace both sides of a fixed-depth book with a snapshot of levels, in place
+	void UpdateSnapshot(const Order* bids, int numBids, const Order* offers, int numOffers);
+
+	// Apply a single level delta to a fixed-depth book; a zero quantity removes the level
+	void UpdateLevel(const Order& order);
+
 	// Get the best bid/offer order
 	BidOffer BestBidOffer() const;
 
+	// Get the event time of the last update in nanoseconds since the epoch, 0 if unknown
+	int64_t GetTimestamp() const;
+
+	// Set the event time of the last update
+	void SetTimestamp(int64_t _timestamp);
+
 
 private:
-	T product;
+	// Insert, replace or remove one level on a sorted side
+	// (accumulate adds the quantity to an existing level instead of replacing it)
+	void ApplyLevel(vector<Order>& levels, const Order& order, bool accumulate);
+
+	ProductHandle product = EMPTY_PRODUCT;
 	vector<Order> bidStack;
 	vector<Order> offerStack;
+	int depth = 0;
+	int64_t timestamp = 0;
 
 };
 
 template<typename T>
 OrderBook<T>::OrderBook(const T &_product, const vector<Order> &_bidStack, const vector<Order> &_offerStack) :
-  product(_product), bidStack(_bidStack), offerStack(_offerStack)
+  product(ProductRegistry<T>::Instance().Intern(_product)), bidStack(_bidStack), offerStack(_offerStack)
 {
 }
 
+template<typename T>
+OrderBook<T>::OrderBook(const T &_product, int _depth) :
+  OrderBook(ProductRegistry<T>::Instance().Intern(_product), _depth)
+{
+}
+
+template<typename T>
+OrderBook<T>::OrderBook(ProductHandle _product, int _depth) :
+  product(_product), depth(_depth)
+{
+	// reserve the full depth up front so in-place updates never reallocate
+	bidStack.reserve(depth);
+	offerStack.reserve(depth);
+}
+
 template<typename T>
 const T& OrderBook<T>::GetProduct() const
+{
+	return ProductRegistry<T>::Instance().Get(product);
+}
+
+template<typename T>
+ProductHandle OrderBook<T>::GetProductHandle() const
 {
 	return product;
 }
@@ -170,16 +242,113 @@ vector<Order>& OrderBook<T>::GetOfferStack()
 	return offerStack;
 }
 
+template<typename T>
+int OrderBook<T>::GetDepth() const
+{
+	return depth;
+}
+
+template<typename T>
+bool OrderBook<T>::IsFixedDepth() const
+{
+	return depth > 0;
+}
+
+template<typename T>
+void OrderBook<T>::UpdateSnapshot(const Order* bids, int numBids, const Order* offers, int numOffers)
+{
+	bidStack.clear();
+	offerStack.clear();
+	for (int i = 0; i < numBids; i++)
+	{
+		ApplyLevel(bidStack, bids[i], true);
+	}
+	for (int i = 0; i < numOffers; i++)
+	{
+		ApplyLevel(offerStack, offers[i], true);
+	}
+}
+
+template<typename T>
+void OrderBook<T>::UpdateLevel(const Order& order)
+{
+	ApplyLevel(order.GetSide() == BID ? bidStack : offerStack, order, false);
+}
+
+/**
+ * Levels are kept sorted best first, so a level is found with a short linear scan
+ * (depth is small) and the vector never grows beyond the reserved depth.
+ */
+template<typename T>
+void OrderBook<T>::ApplyLevel(vector<Order>& levels, const Order& order, bool accumulate)
+{
+	TickPrice price = order.GetTickPrice();
+	bool isBid = (order.GetSide() == BID);
+
+	// find the first level that is not better than the order price
+	size_t pos = 0;
+	while (pos < levels.size() && (isBid ? levels[pos].GetTickPrice() > price : levels[pos].GetTickPrice() < price))
+	{
+		pos++;
+	}
+
+	// the price level already exists
+	if (pos < levels.size() && levels[pos].GetTickPrice() == price)
+	{
+		long quantity = accumulate ? levels[pos].GetQuantity() + order.GetQuantity() : order.GetQuantity();
+		if (quantity == 0)
+		{
+			levels.erase(levels.begin() + pos);
+		}
+		else
+		{
+			levels[pos] = Order(price, quantity, order.GetSide());
+		}
+		return;
+	}
+
+	// a new price level, dropping the worst level if the book is full
+	if (order.GetQuantity() == 0 || pos >= static_cast<size_t>(depth))
+	{
+		return;
+	}
+	if (levels.size() == static_cast<size_t>(depth))
+	{
+		levels.pop_back();
+	}
+	levels.insert(levels.begin() + pos, order);
+}
+
 template<typename T>
 BidOffer OrderBook<T>::BestBidOffer() const
 {
+	// a fixed-depth book is sorted, so the best bid/offer is always the front level
+	if (IsFixedDepth())
+	{
+		Order bestBid = bidStack.empty() ? Order(TickPrice(), 0, BID) : bidStack.front();
+		Order bestOffer = offerStack.empty() ? Order(TickPrice(), 0, OFFER) : offerStack.front();
+		return BidOffer(bestBid, bestOffer);
+	}
+
 	// iterate bid stack and offer stack to find the best bid/offer order
-	auto bestBid = std::max_element(bidStack.begin(), bidStack.end(), [](const Order& a, const Order& b) {return a.GetPrice() < b.GetPrice(); });
-	auto bestOffer = std::min_element(offerStack.begin(), offerStack.end(), [](const Order& a, const Order& b) {return a.GetPrice() < b.GetPrice(); });
+	auto bestBid = std::max_element(bidStack.begin(), bidStack.end(), [](const Order& a, const Order& b) {return a.GetTickPrice() < b.GetTickPrice(); });
+	auto bestOffer = std::min_element(offerStack.begin(), offerStack.end(), [](const Order& a, const Order& b) {return a.GetTickPrice() < b.GetTickPrice(); });
 	return BidOffer(*bestBid, *bestOffer);
   
 }
 
+template<typename T>
+int64_t OrderBook<T>::GetTimestamp() const
+{
+	return timestamp;
+}
+
+template<typename T>
+void OrderBook<T>::SetTimestamp(int64_t _timestamp)
+{
+	timestamp = _timestamp;
+}
+
 
 // forward declaration of MarketDataConnector
 template<typename T>
@@ -196,7 +365,7 @@ class MarketDataService : public Service<string,OrderBook <T> >
 {
 private:
 	MarketDataConnector<T>* connector;
-	map<string, OrderBook<T>> orderBookMap;
+	ProductStore<OrderBook<T>> orderBookMap; // order books keyed by product handle
 	vector<ServiceListener<OrderBook<T>>*> listeners;
 	int bookDepth;
 public:
@@ -207,6 +376,9 @@ public:
 	// Get data on our service given a key
 	OrderBook<T>& GetData(string key) override;
 
+	// Get data on our service given a product handle
+	OrderBook<T>& GetData(ProductHandle handle);
+
 	// The callback that a Connector should invoke for any new or updated data
 	void OnMessage(OrderBook<T>& data) override;
 
@@ -224,10 +396,12 @@ public:
 
 
 	// Get the best bid/offer order
-	const BidOffer& BestBidOffer(const string &productId);
+	BidOffer BestBidOffer(const string &productId);
+	BidOffer BestBidOffer(ProductHandle handle);
 
 	// Aggregate the order book
 	const OrderBook<T>& AggregateDepth(const string &productId);
+	const OrderBook<T>& AggregateDepth(ProductHandle handle);
 
 };
 
@@ -240,23 +414,30 @@ MarketDataService<T>::MarketDataService() : connector(new MarketDataConnector<T>
 template<typename T>
 OrderBook<T>& MarketDataService<T>::GetData(string key)
 {
-	// if the order book does not exist, create a new one
-	if (orderBookMap.find(key) == orderBookMap.end()) 
+	return GetData(QueryProductHandle<T>(key));
+}
+
+template<typename T>
+OrderBook<T>& MarketDataService<T>::GetData(ProductHandle handle)
+{
+	// if the order book does not exist, create a new fixed-depth one
+	OrderBook<T>* orderBook = orderBookMap.Find(handle);
+	if (orderBook == nullptr)
 	{
-	orderBookMap.insert(pair<string, OrderBook<T>>(key, OrderBook<T>(QueryProduct<T>(key),vector<Order>(), vector<Order>())));
+		orderBook = &orderBookMap.Put(handle, OrderBook<T>(handle, bookDepth));
 	}
-	return orderBookMap[key];
+	return *orderBook;
 }
 
 template<typename T>
 void MarketDataService<T>::OnMessage(OrderBook<T>& data)
 {
-	string key = data.GetProduct().GetProductId();
-	if (orderBookMap.find(key) != orderBookMap.end()) 
-	{ 
-		orderBookMap.erase(key); 
+	// the connector updates the stored book in place, in which case there is nothing to copy
+	OrderBook<T>* orderBook = orderBookMap.Find(data.GetProductHandle());
+	if (orderBook != &data)
+	{
+		orderBookMap.Put(data.GetProductHandle(), data);
 	}
-	orderBookMap.insert(pair<string, OrderBook<T>>(key, data));
 
 
 	for (auto& listener : listeners)
@@ -290,51 +471,68 @@ int MarketDataService<T>::GetBookDepth() const
 }
 
 template<typename T>
-const BidOffer& MarketDataService<T>::BestBidOffer(const string &productId)
+BidOffer MarketDataService<T>::BestBidOffer(const string &productId)
 {
-	return orderBookMap[productId].BestBidOffer();
+	return BestBidOffer(QueryProductHandle<T>(productId));
+}
+
+template<typename T>
+BidOffer MarketDataService<T>::BestBidOffer(ProductHandle handle)
+{
+	return GetData(handle).BestBidOffer();
 }
 
 template<typename T>
 const OrderBook<T>& MarketDataService<T>::AggregateDepth(const string &productId)
+{
+	return AggregateDepth(QueryProductHandle<T>(productId));
+}
+
+template<typename T>
+const OrderBook<T>& MarketDataService<T>::AggregateDepth(ProductHandle handle)
 {
 	// get the order book
-	OrderBook<T>& orderBook = orderBookMap[productId];
+	OrderBook<T>& orderBook = GetData(handle);
+	// a fixed-depth book keeps one level per price already, nothing to aggregate
+	if (orderBook.IsFixedDepth())
+	{
+		return orderBook;
+	}
 	// get the bid stack and offer stack
 	vector<Order>& bidStack = orderBook.GetBidStack();
 	vector<Order>& offerStack = orderBook.GetOfferStack();
 	// aggregate the bid stack
-	unordered_map<double, long> aggBidMap;
+	unordered_map<long, long> aggBidMap;
 	for (auto& order : bidStack){
-	double price = order.GetPrice();
+	long price = order.GetTickPrice().GetTicks();
 	long quantity = order.GetQuantity();
 	if (aggBidMap.find(price) != aggBidMap.end()) {
 		aggBidMap[price] += quantity;
 	}
 	else {
-		aggBidMap.insert(pair<double, long>(price, quantity));
+		aggBidMap.insert(pair<long, long>(price, quantity));
 	}
 	}
 	vector<Order> aggBid;
 	for (auto& item : aggBidMap) {
-	aggBid.push_back(Order(item.first, item.second, BID));
+	aggBid.push_back(Order(TickPrice(item.first), item.second, BID));
 	}
 
 	// aggregate the offer stack
-	unordered_map<double, long> aggOfferMap;
+	unordered_map<long, long> aggOfferMap;
 	for (auto& order : offerStack) {
-	double price = order.GetPrice();
+	long price = order.GetTickPrice().GetTicks();
 	long quantity = order.GetQuantity();
 	if (aggOfferMap.find(price) != aggOfferMap.end()) {
 		aggOfferMap[price] += quantity;
 	}
 	else {
-		aggOfferMap.insert(pair<double, long>(price, quantity));
+		aggOfferMap.insert(pair<long, long>(price, quantity));
 	}
 	}
 	vector<Order> aggOffer;
 	for (auto& item : aggOfferMap) {
-	aggOffer.push_back(Order(item.first, item.second, OFFER));
+	aggOffer.push_back(Order(TickPrice(item.first), item.second, OFFER));
 	}
   
 	// update the order book
@@ -364,6 +562,27 @@ public:
 	// Subscribe data
 	void Subscribe(ifstream& _data);
 
+	// Subscribe data from a file, fields are read straight from the mapped file
+	void Subscribe(const string& _path);
+
+	// Subscribe data from an order book tick file, ticks are read straight from the mapped file without parsing
+	void SubscribeTicks(const string& _path);
+
+private:
+	// Apply the snapshot on one line to its order book and send it to the service
+	template<typename Fields>
+	void SubscribeLine(const Fields& fields);
+
+	// Apply the levels in bids and offers to the order book of a product and send it to the service
+	void SendSnapshot(ProductHandle product, int depth, int64_t timestamp);
+
+	// level and price buffers reused across lines
+	vector<Order> bids;
+	vector<Order> offers;
+	vector<string_view> priceTexts;
+	vector<long> ticks;
+	TimestampParser timestamps;
+
 };
 
 template<typename T>
@@ -395,27 +614,106 @@ void MarketDataConnector<T>::Subscribe(ifstream& _data)
 			splitdata.push_back(block);
 		}
 
-		string timestamp = splitdata[0];
-		string productID = splitdata[1];
-		OrderBook<T>& orderBook = service->GetData(productID);
+		SubscribeLine(splitdata);
+	}
+}
 
-		for (int i = 0; i < service->GetBookDepth(); i++)
-		{
-			double bidPrice = Frac2Price(splitdata[4 * i + 2]);
-			long bidQuantity = stol(splitdata[4 * i + 3]);
-			double askPrice = Frac2Price(splitdata[4 * i + 4]);
-			long askQuantity = stol(splitdata[4 * i + 5]);
+template<typename T>
+void MarketDataConnector<T>::Subscribe(const string& _path)
+{
+	CsvReader reader(_path);
+	reader.NextLine();
 
-			Order bidOrder(bidPrice, bidQuantity, BID);
-			Order askOrder(askPrice, askQuantity, OFFER);
+	while (reader.NextLine())
+	{
+		SubscribeLine(reader);
+	}
+}
 
-			orderBook.GetBidStack().push_back(bidOrder);
-			orderBook.GetOfferStack().push_back(askOrder);
-		}
+template<typename T>
+template<typename Fields>
+void MarketDataConnector<T>::SubscribeLine(const Fields& fields)
+{
+	SOA_STAMP_INGRESS();
+	// map the identifier to its dense handle once per line
+	ProductHandle product = QueryProductHandle<T>(string(fields[1]));
+
+	int depth = service->GetBookDepth();
+	bids.resize(depth);
+	offers.resize(depth);
+
+	// parse all bid and ask prices of the line as one batch of ticks
+	priceTexts.resize(2 * depth);
+	ticks.resize(2 * depth);
+	for (int i = 0; i < depth; i++)
+	{
+		priceTexts[2 * i] = fields[4 * i + 2];
+		priceTexts[2 * i + 1] = fields[4 * i + 4];
+	}
+	size_t parsed = ParseFracTicks(priceTexts.data(), ticks.data(), 2 * depth);
+	if (parsed < priceTexts.size())
+	{
+		throw std::invalid_argument("Invalid fractional price: " + string(priceTexts[parsed]));
+	}
+
+	for (int i = 0; i < depth; i++)
+	{
+		long bidQuantity = ParseLong(fields[4 * i + 3]);
+		long askQuantity = ParseLong(fields[4 * i + 5]);
+
+		bids[i] = Order(TickPrice(ticks[2 * i]), bidQuantity, BID);
+		offers[i] = Order(TickPrice(ticks[2 * i + 1]), askQuantity, OFFER);
+	}
 
-		OrderBook<T> aggregatedOrderBook = service->AggregateDepth(productID);
-		service->OnMessage(aggregatedOrderBook);
+	SendSnapshot(product, depth, timestamps.Parse(fields[0]));
+}
+
+template<typename T>
+void MarketDataConnector<T>::SubscribeTicks(const string& _path)
+{
+	TickFileReader reader(_path);
+	int depth = service->GetBookDepth();
+	if (reader.GetKind() != BOOK_TICKS || reader.GetDepth() < static_cast<uint32_t>(depth))
+	{
+		throw std::invalid_argument("Not an order book tick file of depth " + to_string(depth) + ": " + _path);
 	}
+	bids.resize(depth);
+	offers.resize(depth);
+
+	// map the product table to dense handles once per file
+	vector<ProductHandle> products;
+	for (const auto& productID : reader.GetProducts())
+	{
+		products.push_back(QueryProductHandle<T>(productID));
+	}
+
+	TickBlock block;
+	while (reader.NextBlock(block))
+	{
+		ProductHandle product = products[block.GetProduct()];
+		const int64_t* times = block.GetTimestamps();
+		for (uint32_t row = 0; row < block.GetRows(); row++)
+		{
+			SOA_STAMP_INGRESS();
+			for (int i = 0; i < depth; i++)
+			{
+				bids[i] = Order(TickPrice(block.GetBids(i)[row]), block.GetBidSizes(i)[row], BID);
+				offers[i] = Order(TickPrice(block.GetAsks(i)[row]), block.GetAskSizes(i)[row], OFFER);
+			}
+			SendSnapshot(product, depth, times[row]);
+		}
+	}
+}
+
+template<typename T>
+void MarketDataConnector<T>::SendSnapshot(ProductHandle product, int depth, int64_t timestamp)
+{
+	// each line is a full snapshot of the book, applied in place
+	OrderBook<T>& orderBook = service->GetData(product);
+	orderBook.UpdateSnapshot(bids.data(), depth, offers.data(), depth);
+	orderBook.SetTimestamp(timestamp);
+	SOA_TIME_SCOPE("marketdata.onmessage");
+	service->OnMessage(orderBook);
 }
 
 #endif
@@ -0,0 +1,656 @@
+// pnlservice.hpp
+//
+// Purpose: 1. Defines the data types and Service for real-time profit and loss.
+// 2. Trades move an average cost position per product and book, prices mark the positions to the mid;
+//    every update is a constant amount of work per product, book totals are running sums.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef PNL_SERVICE_HPP
+#define PNL_SERVICE_HPP
+
+#include <string>
+#include <vector>
+#include <span>
+#include <mutex>
+#include <memory>
+#include <cstdlib>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "soa.hpp"
+#include "tradebookingservice.hpp"
+#include "pricingservice.hpp"
+
+using namespace std;
+
+// Book name of the profit and loss of a product across all books
+const string ALL_BOOKS = "ALL";
+
+/**
+ * Profit and loss of a position in a product, in one book or across all books.
+ * Realised PnL is locked in by trades reducing the position against its average cost,
+ * unrealised PnL is the position marked from its average cost to the mid. PnL is in currency,
+ * with quantities as face amounts (see PRICE_FACE).
+ * Type T is the product type.
+ */
+template<typename T>
+class PnL
+{
+
+public:
+	// ctor
+	PnL() = default;
+	PnL(ProductHandle _product, const string& _book, long _position, double _averagePrice, double _mark,
+		double _realised, double _unrealised, int64_t _timestamp = 0);
+
+	// Get the product
+	const T& GetProduct() const;
+
+	// Get the registry handle of the product
+	ProductHandle GetProductHandle() const;
+
+	// Get the book, ALL_BOOKS for the product across all books
+	const string& GetBook() const;
+
+	// Get the position
+	long GetPosition() const;
+
+	// Get the average price the position was built at, 0 if flat
+	double GetAveragePrice() const;
+
+	// Get the mid the position is marked at
+	double GetMark() const;
+
+	// Get the realised PnL
+	double GetRealised() const;
+
+	// Get the unrealised PnL
+	double GetUnrealised() const;
+
+	// Get the realised plus unrealised PnL
+	double GetTotal() const;
+
+	// Get the event time of the last trade or price, 0 if unknown
+	int64_t GetTimestamp() const;
+
+	// object printer
+	template<typename S>
+	friend ostream& operator<<(ostream& output, const PnL<S>& pnl);
+
+private:
+	ProductHandle product = EMPTY_PRODUCT;
+	string book;
+	long position = 0;
+	double averagePrice = 0.0;
+	double mark = 0.0;
+	double realised = 0.0;
+	double unrealised = 0.0;
+	int64_t timestamp = 0;
+
+};
+
+template<typename T>
+PnL<T>::PnL(ProductHandle _product, const string& _book, long _position, double _averagePrice, double _mark,
+	double _realised, double _unrealised, int64_t _timestamp) :
+	product(_product), book(_book), position(_position), averagePrice(_averagePrice), mark(_mark),
+	realised(_realised), unrealised(_unrealised), timestamp(_timestamp)
+{
+}
+
+template<typename T>
+const T& PnL<T>::GetProduct() const
+{
+	return ProductRegistry<T>::Instance().Get(product);
+}
+
+template<typename T>
+ProductHandle PnL<T>::GetProductHandle() const
+{
+	return product;
+}
+
+template<typename T>
+const string& PnL<T>::GetBook() const
+{
+	return book;
+}
+
+template<typename T>
+long PnL<T>::GetPosition() const
+{
+	return position;
+}
+
+template<typename T>
+double PnL<T>::GetAveragePrice() const
+{
+	return averagePrice;
+}
+
+template<typename T>
+double PnL<T>::GetMark() const
+{
+	return mark;
+}
+
+template<typename T>
+double PnL<T>::GetRealised() const
+{
+	return realised;
+}
+
+template<typename T>
+double PnL<T>::GetUnrealised() const
+{
+	return unrealised;
+}
+
+template<typename T>
+double PnL<T>::GetTotal() const
+{
+	return realised + unrealised;
+}
+
+template<typename T>
+int64_t PnL<T>::GetTimestamp() const
+{
+	return timestamp;
+}
+
+template<typename T>
+ostream& operator<<(ostream& output, const PnL<T>& pnl)
+{
+	output << pnl.GetProduct().GetProductId() << "," << pnl.book << "," << pnl.position << "," << pnl.averagePrice << ","
+		<< pnl.mark << "," << pnl.realised << "," << pnl.unrealised << "," << pnl.GetTotal();
+	return output;
+}
+
+// pre declaration of the listeners feeding the PnL service
+template<typename T>
+class PnLTradeListener;
+template<typename T>
+class PnLPriceListener;
+
+/**
+ * PnL Service keeping the realised and unrealised PnL of every product, per book and across books.
+ * A trade adding to a position moves its average price; a trade reducing it realises the closed quantity
+ * against the average price, and the remainder of a trade that flips the position opens at the trade price.
+ * A price marks the product to its mid, moving its unrealised PnL and that of the books holding it;
+ * until a product is priced it is marked at its last trade. The product totals keep the cost of the
+ * position (position x average price summed over books), so their unrealised PnL is one multiplication.
+ * Listeners get the book PnL and the product total of every trade, and the product total of every price
+ * that moves the mark of a traded product.
+ * Keyed on product identifier.
+ * Type T is the product type.
+ */
+template<typename T>
+class PnLService : public Service<string, PnL<T>>
+{
+
+public:
+	// ctor
+	PnLService();
+
+	// Get the PnL of a product across all books
+	// a reference to the stored total as the Service interface requires, only stable while no trade or price is flowing
+	PnL<T>& GetData(string key) override;
+
+	// Get the PnL of a product across all books given a product handle
+	// a copy taken under the lock, as trades and prices rewrite the total from other threads
+	PnL<T> GetData(ProductHandle handle);
+
+	// The callback that a Connector should invoke for any new or updated data
+	void OnMessage(PnL<T>& data) override;
+
+	// Add a listener to the Service for callbacks on add, remove, and update events
+	// for data to the Service.
+	void AddListener(ServiceListener<PnL<T>>* listener) override;
+
+	// Get all listeners on the Service.
+	const vector<ServiceListener<PnL<T>>*>& GetListeners() const override;
+
+	// Get the listener taking trades from the trade booking service
+	PnLTradeListener<T>* GetPnLTradeListener();
+
+	// Get the listener taking prices from the pricing service
+	PnLPriceListener<T>* GetPnLPriceListener();
+
+	// Add a trade and publish the PnL it moved
+	void AddTrade(const Trade<T>& trade);
+
+	// Add a batch of trades and publish the PnL they moved as one batch
+	void AddTradeBatch(span<Trade<T>> trades);
+
+	// Mark a batch of prices and publish the PnL they moved as one batch
+	void AddPrices(span<Price<T>> prices);
+
+	// Get the PnL of a product in a book (throws if the book never traded the product)
+	PnL<T> GetPnL(ProductHandle product, const string& book) const;
+
+	// Get the PnL of a book across all products, returns false if the book never traded
+	bool GetBookPnL(const string& book, double& realised, double& unrealised) const;
+
+private:
+	// position of one product in one book
+	struct Lot
+	{
+		bool traded = false; // listed in the books of the product
+		long position = 0;
+		double averagePrice = 0.0;
+		double realised = 0.0;
+		int64_t timestamp = 0;
+	};
+
+	// position of one product in every book
+	struct ProductPnL
+	{
+		bool marked = false; // priced at least once
+		double mark = 0.0;
+		long position = 0; // across books
+		double cost = 0.0; // position x average price summed over books
+		double realised = 0.0;
+		vector<Lot> lots; // by book index
+		vector<size_t> books; // indices of the books with a lot
+		PnL<T> total; // across books, as published
+	};
+
+	// running PnL of a book
+	struct BookPnL
+	{
+		double realised = 0.0;
+		double unrealised = 0.0;
+	};
+
+	// Apply a trade to its lot and product, append the PnL it moved to the batch
+	void ApplyTrade(const Trade<T>& trade);
+
+	// Mark a product to a price, append its total to the batch if the mark moved
+	void ApplyPrice(const Price<T>& price);
+
+	// Get the index of a book, adding it if needed
+	size_t GetBookIndex(const string& book);
+
+	// Refresh the published total of a product
+	void UpdateTotal(ProductHandle product, ProductPnL& entry, int64_t timestamp);
+
+	// Notify the listeners of the PnL in batch
+	void PublishBatch();
+
+	vector<ServiceListener<PnL<T>>*> listeners;
+	unique_ptr<PnLTradeListener<T>> tradeListener;
+	unique_ptr<PnLPriceListener<T>> priceListener;
+	ProductStore<ProductPnL> products; // keyed by product handle
+	unordered_map<string, size_t> bookIndex;
+	vector<string> bookNames;
+	vector<BookPnL> books;
+	vector<PnL<T>> batch; // PnL of the batch being published
+	mutable mutex lock; // guards everything, trades and prices may arrive on different threads
+
+};
+
+template<typename T>
+PnLService<T>::PnLService() :
+	tradeListener(new PnLTradeListener<T>(this)), priceListener(new PnLPriceListener<T>(this))
+{
+	products.Reserve(ProductRegistry<T>::Instance().GetSize());
+}
+
+template<typename T>
+PnL<T>& PnLService<T>::GetData(string key)
+{
+	ProductHandle handle = ProductRegistry<T>::Instance().GetHandle(key);
+	lock_guard<mutex> guard(lock);
+	return products.Get(handle).total;
+}
+
+template<typename T>
+PnL<T> PnLService<T>::GetData(ProductHandle handle)
+{
+	lock_guard<mutex> guard(lock);
+	return products.Get(handle).total;
+}
+
+/**
+ * OnMessage() used to be called by connector to subscribe data
+ * no need to implement here.
+ */
+template<typename T>
+void PnLService<T>::OnMessage(PnL<T>& data)
+{
+}
+
+template<typename T>
+void PnLService<T>::AddListener(ServiceListener<PnL<T>>* listener)
+{
+	listeners.push_back(listener);
+}
+
+template<typename T>
+const vector<ServiceListener<PnL<T>>*>& PnLService<T>::GetListeners() const
+{
+	return listeners;
+}
+
+template<typename T>
+PnLTradeListener<T>* PnLService<T>::GetPnLTradeListener()
+{
+	return tradeListener.get();
+}
+
+template<typename T>
+PnLPriceListener<T>* PnLService<T>::GetPnLPriceListener()
+{
+	return priceListener.get();
+}
+
+template<typename T>
+void PnLService<T>::AddTrade(const Trade<T>& trade)
+{
+	lock_guard<mutex> guard(lock);
+	batch.clear();
+	ApplyTrade(trade);
+	PublishBatch();
+}
+
+template<typename T>
+void PnLService<T>::AddTradeBatch(span<Trade<T>> trades)
+{
+	lock_guard<mutex> guard(lock);
+	batch.clear();
+	for (auto& trade : trades)
+	{
+		ApplyTrade(trade);
+	}
+	PublishBatch();
+}
+
+template<typename T>
+void PnLService<T>::AddPrices(span<Price<T>> prices)
+{
+	lock_guard<mutex> guard(lock);
+	batch.clear();
+	for (auto& price : prices)
+	{
+		ApplyPrice(price);
+	}
+	PublishBatch();
+}
+
+template<typename T>
+PnL<T> PnLService<T>::GetPnL(ProductHandle product, const string& book) const
+{
+	lock_guard<mutex> guard(lock);
+	const ProductPnL* entry = products.Find(product);
+	auto index = bookIndex.find(book);
+	if (entry == nullptr || index == bookIndex.end() || index->second >= entry->lots.size() || !entry->lots[index->second].traded)
+	{
+		throw std::invalid_argument("Book " + book + " has no position in product " + to_string(product));
+	}
+	const Lot& lot = entry->lots[index->second];
+	return PnL<T>(product, book, lot.position, lot.averagePrice, entry->mark, lot.realised,
+		lot.position * (entry->mark - lot.averagePrice) / PRICE_FACE, lot.timestamp);
+}
+
+template<typename T>
+bool PnLService<T>::GetBookPnL(const string& book, double& realised, double& unrealised) const
+{
+	lock_guard<mutex> guard(lock);
+	auto index = bookIndex.find(book);
+	if (index == bookIndex.end())
+	{
+		return false;
+	}
+	realised = books[index->second].realised;
+	unrealised = books[index->second].unrealised;
+	return true;
+}
+
+template<typename T>
+void PnLService<T>::ApplyTrade(const Trade<T>& trade)
+{
+	ProductHandle product = trade.GetProductHandle();
+	size_t book = GetBookIndex(trade.GetBook());
+	ProductPnL& entry = products[product];
+	if (entry.lots.size() <= book)
+	{
+		entry.lots.resize(book + 1);
+	}
+	Lot& lot = entry.lots[book];
+	if (!lot.traded)
+	{
+		lot.traded = true;
+		entry.books.push_back(book);
+	}
+	double price = trade.GetPrice();
+	if (!entry.marked)
+	{
+		// not priced yet, mark the other books at the trade price too
+		for (size_t other : entry.books)
+		{
+			books[other].unrealised += entry.lots[other].position * (price - entry.mark) / PRICE_FACE;
+		}
+		entry.mark = price;
+	}
+
+	// take the lot out of the totals, move it, and put it back
+	BookPnL& bookPnL = books[book];
+	double unrealised = lot.position * (entry.mark - lot.averagePrice) / PRICE_FACE;
+	entry.cost -= lot.position * lot.averagePrice;
+	long change = (trade.GetSide() == BUY) ? trade.GetQuantity() : -trade.GetQuantity();
+	long position = lot.position + change;
+	if (lot.position == 0 || (lot.position > 0) == (change > 0))
+	{
+		// adding to the position
+		lot.averagePrice = position != 0 ? (lot.averagePrice * labs(lot.position) + price * labs(change)) / labs(position) : 0.0;
+	}
+	else
+	{
+		// reducing it, the closed quantity realises against the average price
+		long closed = min(labs(change), labs(lot.position));
+		double realised = (lot.position > 0 ? 1.0 : -1.0) * closed * (price - lot.averagePrice) / PRICE_FACE;
+		lot.realised += realised;
+		entry.realised += realised;
+		bookPnL.realised += realised;
+		if (position == 0)
+		{
+			lot.averagePrice = 0.0;
+		}
+		else if ((position > 0) != (lot.position > 0))
+		{
+			// flipped, the remainder opens at the trade price
+			lot.averagePrice = price;
+		}
+	}
+	lot.position = position;
+	lot.timestamp = trade.GetTimestamp();
+	entry.position += change;
+	entry.cost += lot.position * lot.averagePrice;
+	bookPnL.unrealised += lot.position * (entry.mark - lot.averagePrice) / PRICE_FACE - unrealised;
+
+	batch.push_back(PnL<T>(product, trade.GetBook(), lot.position, lot.averagePrice, entry.mark, lot.realised,
+		lot.position * (entry.mark - lot.averagePrice) / PRICE_FACE, lot.timestamp));
+	UpdateTotal(product, entry, trade.GetTimestamp());
+	batch.push_back(entry.total);
+}
+
+template<typename T>
+void PnLService<T>::ApplyPrice(const Price<T>& price)
+{
+	ProductHandle product = price.GetProductHandle();
+	ProductPnL& entry = products[product];
+	double mark = price.GetMid();
+	bool moved = mark != entry.mark;
+	entry.marked = true;
+	if (!moved)
+	{
+		return;
+	}
+	// the books holding the product move by their position, the product total by the cost it keeps
+	for (size_t book : entry.books)
+	{
+		books[book].unrealised += entry.lots[book].position * (mark - entry.mark) / PRICE_FACE;
+	}
+	entry.mark = mark;
+	if (entry.books.empty())
+	{
+		return;
+	}
+	UpdateTotal(product, entry, price.GetTimestamp());
+	batch.push_back(entry.total);
+}
+
+template<typename T>
+size_t PnLService<T>::GetBookIndex(const string& book)
+{
+	auto it = bookIndex.find(book);
+	if (it != bookIndex.end())
+	{
+		return it->second;
+	}
+	size_t index = bookNames.size();
+	bookIndex.emplace(book, index);
+	bookNames.push_back(book);
+	books.push_back(BookPnL());
+	return index;
+}
+
+template<typename T>
+void PnLService<T>::UpdateTotal(ProductHandle product, ProductPnL& entry, int64_t timestamp)
+{
+	double averagePrice = entry.position != 0 ? entry.cost / entry.position : 0.0;
+	entry.total = PnL<T>(product, ALL_BOOKS, entry.position, averagePrice, entry.mark, entry.realised,
+		(entry.position * entry.mark - entry.cost) / PRICE_FACE, timestamp);
+}
+
+template<typename T>
+void PnLService<T>::PublishBatch()
+{
+	if (batch.size() == 1)
+	{
+		for (auto& listener : listeners)
+		{
+			listener->ProcessAdd(batch.front());
+		}
+	}
+	else if (!batch.empty())
+	{
+		for (auto& listener : listeners)
+		{
+			listener->ProcessAddBatch(span<PnL<T>>(batch));
+		}
+	}
+}
+
+/**
+ * PnL Trade Listener subscribing trades from Trade Booking Service to PnL Service.
+ * Type T is the product type.
+ */
+template<typename T>
+class PnLTradeListener final : public ServiceListener<Trade<T>>
+{
+private:
+	PnLService<T>* service;
+
+public:
+	// ctor
+	PnLTradeListener(PnLService<T>* _service);
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(Trade<T>& data) override;
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(Trade<T>& data) override;
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(Trade<T>& data) override;
+
+	// Listener callback to process a batch of add events to the Service
+	void ProcessAddBatch(span<Trade<T>> batch) override;
+
+};
+
+template<typename T>
+PnLTradeListener<T>::PnLTradeListener(PnLService<T>* _service) : service(_service)
+{
+}
+
+template<typename T>
+void PnLTradeListener<T>::ProcessAdd(Trade<T>& data)
+{
+	service->AddTrade(data);
+}
+
+template<typename T>
+void PnLTradeListener<T>::ProcessRemove(Trade<T>& data)
+{
+}
+
+template<typename T>
+void PnLTradeListener<T>::ProcessUpdate(Trade<T>& data)
+{
+}
+
+template<typename T>
+void PnLTradeListener<T>::ProcessAddBatch(span<Trade<T>> batch)
+{
+	service->AddTradeBatch(batch);
+}
+
+/**
+ * PnL Price Listener subscribing prices from Pricing Service to PnL Service, to mark the positions to the mid.
+ * Type T is the product type.
+ */
+template<typename T>
+class PnLPriceListener final : public ServiceListener<Price<T>>
+{
+private:
+	PnLService<T>* service;
+
+public:
+	// ctor
+	PnLPriceListener(PnLService<T>* _service);
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(Price<T>& data) override;
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(Price<T>& data) override;
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(Price<T>& data) override;
+
+	// Listener callback to process a batch of add events to the Service
+	void ProcessAddBatch(span<Price<T>> batch) override;
+
+};
+
+template<typename T>
+PnLPriceListener<T>::PnLPriceListener(PnLService<T>* _service) : service(_service)
+{
+}
+
+template<typename T>
+void PnLPriceListener<T>::ProcessAdd(Price<T>& data)
+{
+	service->AddPrices(span<Price<T>>(&data, 1));
+}
+
+template<typename T>
+void PnLPriceListener<T>::ProcessRemove(Price<T>& data)
+{
+}
+
+template<typename T>
+void PnLPriceListener<T>::ProcessUpdate(Price<T>& data)
+{
+}
+
+template<typename T>
+void PnLPriceListener<T>::ProcessAddBatch(span<Price<T>> batch)
+{
+	service->AddPrices(batch);
+}
+
+#endif
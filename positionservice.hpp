@@ -32,6 +32,7 @@ public:
 
 	// ctor for a position
 	Position(const T& _product);
+	Position(ProductHandle _product);
 
 	// dtor
 	~Position() = default;
@@ -39,33 +40,54 @@ public:
 	// Get the product
 	const T& GetProduct() const;
 
+	// Get the registry handle of the product
+	ProductHandle GetProductHandle() const;
+
 	// Get the position quantity
 	long GetPosition(string &book);
 
 	// Get the aggregate position
-	long GetAggregatePosition();
+	long GetAggregatePosition() const;
 
 	//  send position to risk service through listener
-	void AddPosition(string &book, long position);
+	void AddPosition(const string &book, long position);
+
+	// Get the event time of the last trade applied, 0 if unknown
+	int64_t GetTimestamp() const;
+
+	// Set the event time of the last trade applied
+	void SetTimestamp(int64_t _timestamp);
 
 	// object printer
 	template<typename S>
 	friend ostream& operator<<(ostream& output, const Position<S>& position);
 
 private:
-  T product;
+  ProductHandle product = EMPTY_PRODUCT;
   map<string,long> bookPositionData;
+  int64_t timestamp = 0;
 
 };
 
 
 template<typename T>
-Position<T>::Position(const T &productId) : product(productId)
+Position<T>::Position(const T &_product) : product(ProductRegistry<T>::Instance().Intern(_product))
+{
+}
+
+template<typename T>
+Position<T>::Position(ProductHandle _product) : product(_product)
 {
 }
 
 template<typename T>
 const T& Position<T>::GetProduct() const
+{
+  return ProductRegistry<T>::Instance().Get(product);
+}
+
+template<typename T>
+ProductHandle Position<T>::GetProductHandle() const
 {
   return product;
 }
@@ -77,7 +99,7 @@ long Position<T>::GetPosition(string &book)
 }
 
 template<typename T>
-long Position<T>::GetAggregatePosition()
+long Position<T>::GetAggregatePosition() const
 {
   long sum = 0;
   for (auto it = bookPositionData.begin(); it != bookPositionData.end(); ++it)
@@ -88,7 +110,7 @@ long Position<T>::GetAggregatePosition()
 }
 
 template<typename T>
-void Position<T>::AddPosition(string &book, long position)
+void Position<T>::AddPosition(const string &book, long position)
 {
 	if (bookPositionData.find(book) == bookPositionData.end())
 	{
@@ -101,12 +123,21 @@ void Position<T>::AddPosition(string &book, long position)
 }
 
 template<typename T>
-ostream& operator<<(ostream& output, const Position<T>& position)
+int64_t Position<T>::GetTimestamp() const
+{
+	return timestamp;
+}
+
+template<typename T>
+void Position<T>::SetTimestamp(int64_t _timestamp)
 {
-	T product = position.GetProduct();
-	string productId = product.GetProductId();
+	timestamp = _timestamp;
+}
 
-	output << productId;
+template<typename T>
+ostream& operator<<(ostream& output, const Position<T>& position)
+{
+	output << position.GetProduct().GetProductId();
 	for (const auto& bookPositionPair : position.bookPositionData)
 	{
 		output << "," << bookPositionPair.first << "," << bookPositionPair.second;
@@ -128,7 +159,7 @@ template<typename T>
 class PositionService : public Service<string,Position <T> >
 {
 private:
-  map<string,Position<T>> positionData;
+  ProductStore<Position<T>> positionData; // store positions keyed by product handle
   vector<ServiceListener<Position<T>>*> listeners;
   PositionServiceListener<T>* positionlistener;
 
@@ -140,6 +171,9 @@ public:
   // Get data on our service given a key
   Position<T>& GetData(string key);
 
+  // Get data on our service given a product handle
+  Position<T>& GetData(ProductHandle handle);
+
   // The callback that a Connector should invoke for any new or updated data
   void OnMessage(Position<T> &data);
 
@@ -156,26 +190,34 @@ public:
   // Add a trade to the service
   void AddTrade(const Trade<T> &trade);
 
+  // Add a batch of trades and publish the resulting positions to the listeners as one batch
+  void AddTradeBatch(span<Trade<T>> trades);
+
+private:
+  // Apply a trade to the position of its product and return the position
+  Position<T>& ApplyTrade(const Trade<T> &trade);
+
+  vector<Position<T>> batch; // positions of the batch being published
+
 };
 
 template<typename T>
 PositionService<T>::PositionService()
 {
   positionlistener = new PositionServiceListener<T>(this);
+  positionData.Reserve(ProductRegistry<T>::Instance().GetSize());
 }
 
 template<typename T>
 Position<T>& PositionService<T>::GetData(string key)
 {
-	auto it = positionData.find(key);
-	if (it != positionData.end())
-	{
-		return it->second;
-	}
-	else
-	{
-		throw std::runtime_error("Key not found");
-	}
+	return GetData(ProductRegistry<T>::Instance().GetHandle(key));
+}
+
+template<typename T>
+Position<T>& PositionService<T>::GetData(ProductHandle handle)
+{
+	return positionData.Get(handle);
 }
 
 /**
@@ -212,25 +254,42 @@ PositionServiceListener<T>* PositionService<T>::GetPositionListener()
 template<typename T>
 void PositionService<T>::AddTrade(const Trade<T> &trade)
 {
-  T product = trade.GetProduct();
-  string productId = product.GetProductId();
-  string book = trade.GetBook();
-  long quantity = (trade.GetSide() == BUY) ? trade.GetQuantity() : -trade.GetQuantity();
-  if (positionData.find(productId) == positionData.end())
+  Position<T>& position = ApplyTrade(trade);
+  for (auto& listener: listeners)
   {
-    Position<T> position(product);
-    position.AddPosition(book,quantity);
-    positionData.insert(pair<string,Position<T>>(productId,position));
+    listener->ProcessAdd(position);
   }
-  else
+
+}
+
+template<typename T>
+void PositionService<T>::AddTradeBatch(span<Trade<T>> trades)
+{
+  // each listener sees the position as of its trade, so the batch holds copies
+  batch.clear();
+  for (auto& trade : trades)
   {
-    positionData[productId].AddPosition(book,quantity);
+    batch.push_back(ApplyTrade(trade));
   }
   for (auto& listener: listeners)
   {
-    listener->ProcessAdd(positionData[productId]);
+    listener->ProcessAddBatch(span<Position<T>>(batch));
   }
+}
 
+template<typename T>
+Position<T>& PositionService<T>::ApplyTrade(const Trade<T> &trade)
+{
+  ProductHandle product = trade.GetProductHandle();
+  long quantity = (trade.GetSide() == BUY) ? trade.GetQuantity() : -trade.GetQuantity();
+  Position<T>* position = positionData.Find(product);
+  if (position == nullptr)
+  {
+    position = &positionData.Put(product, Position<T>(product));
+  }
+  position->AddPosition(trade.GetBook(),quantity);
+  position->SetTimestamp(trade.GetTimestamp());
+  return *position;
 }
 
 /**
@@ -257,6 +316,9 @@ public:
   // Listener callback to process an update event to the Service
   void ProcessUpdate(Trade<T> &data);
 
+  // Listener callback to process a batch of add events to the Service
+  void ProcessAddBatch(span<Trade<T>> batch) override;
+
 };
 
 template<typename T>
@@ -275,6 +337,12 @@ void PositionServiceListener<T>::ProcessAdd(Trade<T> &data)
   positionservice->AddTrade(data);
 }
 
+template<typename T>
+void PositionServiceListener<T>::ProcessAddBatch(span<Trade<T>> batch)
+{
+  positionservice->AddTradeBatch(batch);
+}
+
 template<typename T>
 void PositionServiceListener<T>::ProcessRemove(Trade<T> &data)
 {
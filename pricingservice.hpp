@@ -15,9 +15,11 @@
 #include <fstream>
 #include "soa.hpp"
 #include "utilities.hpp"
+#include "csvreader.hpp"
 
  /**
   * A price object consisting of mid and bid/offer spread.
+  * The bid and offer are held as exact tick prices; mid and spread are derived from them.
   * Type T is the product type.
   */
 template<typename T>
@@ -28,40 +30,75 @@ public:
     // default ctor (needed for map data structure later)
     Price() = default;
 
-    // ctor for a price
+    // ctor for a price (bid and offer are rounded to the nearest tick)
     Price(const T& _product, double _mid, double _bidOfferSpread);
 
+    // ctor for a price from tick bid and offer
+    Price(const T& _product, TickPrice _bid, TickPrice _offer);
+    Price(ProductHandle _product, TickPrice _bid, TickPrice _offer, int64_t _timestamp = 0);
+
     // dtor
     ~Price() = default;
 
     // Get the product
     const T& GetProduct() const;
 
+    // Get the registry handle of the product
+    ProductHandle GetProductHandle() const;
+
     // Get the mid price
     double GetMid() const;
 
     // Get the bid/offer spread around the mid
     double GetBidOfferSpread() const;
 
+    // Get the bid tick price
+    TickPrice GetBid() const;
+
+    // Get the offer tick price
+    TickPrice GetOffer() const;
+
+    // Get the event time in nanoseconds since the epoch, 0 if unknown
+    int64_t GetTimestamp() const;
+
     // Print the price object
     template<typename S>
     friend ostream& operator<<(ostream& output, const Price<S>& bond);
 
 private:
-    T product;
-    double mid;
-    double bidOfferSpread;
+    ProductHandle product = EMPTY_PRODUCT;
+    TickPrice bid;
+    TickPrice offer;
+    int64_t timestamp = 0;
 
 };
 
 template<typename T>
 Price<T>::Price(const T& _product, double _mid, double _bidOfferSpread)
-    : product(_product), mid(_mid), bidOfferSpread(_bidOfferSpread)
+    : Price(ProductRegistry<T>::Instance().Intern(_product), TickPrice::FromDouble(_mid - _bidOfferSpread / 2.0), TickPrice::FromDouble(_mid + _bidOfferSpread / 2.0))
+{
+}
+
+template<typename T>
+Price<T>::Price(const T& _product, TickPrice _bid, TickPrice _offer)
+    : Price(ProductRegistry<T>::Instance().Intern(_product), _bid, _offer)
+{
+}
+
+template<typename T>
+Price<T>::Price(ProductHandle _product, TickPrice _bid, TickPrice _offer, int64_t _timestamp)
+    : product(_product), bid(_bid), offer(_offer), timestamp(_timestamp)
 {
 }
 
 template<typename T>
 const T& Price<T>::GetProduct() const
+{
+    return ProductRegistry<T>::Instance().Get(product);
+}
+
+template<typename T>
+ProductHandle Price<T>::GetProductHandle() const
 {
     return product;
 }
@@ -69,13 +106,31 @@ const T& Price<T>::GetProduct() const
 template<typename T>
 double Price<T>::GetMid() const
 {
-    return mid;
+    return (bid.GetTicks() + offer.GetTicks()) / (2.0 * TICKS_PER_POINT);
 }
 
 template<typename T>
 double Price<T>::GetBidOfferSpread() const
 {
-    return bidOfferSpread;
+    return (offer - bid).ToDouble();
+}
+
+template<typename T>
+TickPrice Price<T>::GetBid() const
+{
+    return bid;
+}
+
+template<typename T>
+TickPrice Price<T>::GetOffer() const
+{
+    return offer;
+}
+
+template<typename T>
+int64_t Price<T>::GetTimestamp() const
+{
+    return timestamp;
 }
 
 // Print the price object
@@ -100,7 +155,7 @@ template<typename T>
 class PricingService : public Service<string, Price<T>>
 {
 private:
-    map<string, Price<T>> priceData; // store price data keyed by product identifier
+    ProductStore<Price<T>> priceData; // store price data keyed by product handle
     vector<ServiceListener<Price<T>>*> listeners; // list of listeners to this service
     PricingConnector<T>* connector; // connector related to this server
 
@@ -114,9 +169,15 @@ public:
     // Get data on our service given a key
     Price<T>& GetData(string key) override;
 
+    // Get data on our service given a product handle
+    Price<T>& GetData(ProductHandle handle);
+
     // The callback that a Connector should invoke for any new or updated data
     void OnMessage(Price<T>& data) override;
 
+    // The callback that a Connector should invoke for a batch of new or updated data
+    void OnMessageBatch(span<Price<T>> batch) override;
+
     // Add a listener to the Service for callbacks on add, remove, and update events
     // for data to the Service.
     void AddListener(ServiceListener<Price<T>>* listener) override;
@@ -138,28 +199,20 @@ PricingService<T>::PricingService() : connector(new PricingConnector<T>(this))
 template<typename T>
 Price<T>& PricingService<T>::GetData(string key)
 {
-    auto it = priceData.find(key);
-    if (it != priceData.end())
-    {
-        return it->second;
-    }
-    else
-    {
-        throw std::runtime_error("Key not found");
-    }
+    return GetData(ProductRegistry<T>::Instance().GetHandle(key));
+}
+
+template<typename T>
+Price<T>& PricingService<T>::GetData(ProductHandle handle)
+{
+    return priceData.Get(handle);
 }
 
 template<typename T>
 void PricingService<T>::OnMessage(Price<T>& data)
 {
-    // flow data
-    string key = data.GetProduct().GetProductId();
-    // update the price map
-    if (priceData.find(key) != priceData.end()) 
-    { 
-        priceData.erase(key); 
-    }
-    priceData.insert(pair<string, Price<Bond> >(key, data));
+    // update the price store in place
+    priceData.Put(data.GetProductHandle(), data);
 
     // flow the data to listeners
     for (auto& l : listeners) {
@@ -167,6 +220,20 @@ void PricingService<T>::OnMessage(Price<T>& data)
     }
 }
 
+template<typename T>
+void PricingService<T>::OnMessageBatch(span<Price<T>> batch)
+{
+    // update the price store in place
+    for (auto& data : batch) {
+        priceData.Put(data.GetProductHandle(), data);
+    }
+
+    // flow the whole batch to each listener
+    for (auto& l : listeners) {
+        l->ProcessAddBatch(batch);
+    }
+}
+
 template<typename T>
 void PricingService<T>::AddListener(ServiceListener<Price<T>>* listener)
 {
@@ -210,12 +277,33 @@ public:
     // Subscribe data
     void Subscribe(ifstream& _data);
 
+    // Subscribe data from a file, fields are read straight from the mapped file
+    void Subscribe(const string& _path);
+
+    // Subscribe data from a price tick file, ticks are read straight from the mapped file without parsing
+    void SubscribeTicks(const string& _path);
+
+private:
+    // Build a price from the fields of one line and add it to the batch
+    template<typename Fields>
+    void SubscribeLine(const Fields& fields);
+
+    // Send the collected batch to the service
+    void FlushBatch();
+
+    vector<Price<T>> batch; // prices collected for the next OnMessageBatch()
+#ifdef SOA_INSTRUMENT
+    vector<long long> ingressStamps; // time each price of the batch was read
+#endif
+    TimestampParser timestamps;
+
 };
 
 template<typename T>
 PricingConnector<T>::PricingConnector(PricingService<T>* _service)
     : service(_service)
 {
+    batch.reserve(CONNECTOR_BATCH_SIZE);
 }
 
 // inbound connector, does nothing
@@ -244,23 +332,95 @@ void PricingConnector<T>::Subscribe(ifstream& _data)
             splitdata.push_back(block);
         }
 
-        string timestamp = splitdata[0];
-        string productID = splitdata[1];
+        SubscribeLine(splitdata);
+    }
+    FlushBatch();
+}
+
+template<typename T>
+void PricingConnector<T>::Subscribe(const string& _path)
+{
+    CsvReader reader(_path);
+    // Skip the header
+    reader.NextLine();
+
+    // read lines in the data
+    while (reader.NextLine())
+    {
+        SubscribeLine(reader);
+    }
+    FlushBatch();
+}
+
+template<typename T>
+void PricingConnector<T>::SubscribeTicks(const string& _path)
+{
+    TickFileReader reader(_path);
+    if (reader.GetKind() != PRICE_TICKS)
+    {
+        throw std::invalid_argument("Not a price tick file: " + _path);
+    }
+
+    // map the product table to dense handles once per file
+    vector<ProductHandle> products;
+    for (const auto& productID : reader.GetProducts())
+    {
+        products.push_back(QueryProductHandle<T>(productID));
+    }
+
+    TickBlock block;
+    while (reader.NextBlock(block))
+    {
+        ProductHandle product = products[block.GetProduct()];
+        const int32_t* bids = block.GetBids(0);
+        const int32_t* asks = block.GetAsks(0);
+        const int64_t* times = block.GetTimestamps();
+        for (uint32_t row = 0; row < block.GetRows(); row++)
+        {
+            SOA_STAMP_BATCH_EVENT(ingressStamps);
+            batch.emplace_back(product, TickPrice(bids[row]), TickPrice(asks[row]), times[row]);
+            if (batch.size() == CONNECTOR_BATCH_SIZE)
+            {
+                FlushBatch();
+            }
+        }
+    }
+    FlushBatch();
+}
+
+template<typename T>
+template<typename Fields>
+void PricingConnector<T>::SubscribeLine(const Fields& fields)
+{
+    string productID(fields[1]);
 
-        // Convert the raw
-        double bid = Frac2Price(splitdata[2]);
-        double ask = Frac2Price(splitdata[3]);
+    // Convert the raw
+    int64_t timestamp = timestamps.Parse(fields[0]);
+    TickPrice bid = ParseTickPrice(fields[2]);
+    TickPrice ask = ParseTickPrice(fields[3]);
 
-        // Calculate mid and spread
-        double mid = (bid + ask) / 2.0;
-        double spread = ask - bid;
+    // Get the product
+    ProductHandle product = QueryProductHandle<T>(productID);
+    // stamped once the line has parsed, so a bad line leaves no stamp without a price
+    SOA_STAMP_BATCH_EVENT(ingressStamps);
+    batch.emplace_back(product, bid, ask, timestamp);
 
-        // Get the product
-        T product = QueryProduct<T>(productID);
-        Price<T> price(product, mid, spread);
+    // Update by communication once the batch is full
+    if (batch.size() == CONNECTOR_BATCH_SIZE)
+    {
+        FlushBatch();
+    }
+}
 
-        // Update by communication
-        service->OnMessage(price);
+template<typename T>
+void PricingConnector<T>::FlushBatch()
+{
+    if (!batch.empty())
+    {
+        SOA_INGRESS_BATCH(span<Price<T>>(batch), ingressStamps);
+        SOA_TIME_SCOPE("pricing.onmessage");
+        service->OnMessageBatch(span<Price<T>>(batch));
+        batch.clear();
     }
 }
 
@@ -0,0 +1,257 @@
+// productregistry.hpp
+//
+// Purpose: 1. Defines a registry that interns each product once and hands out small integer handles.
+// 2. Data objects hold a handle instead of a by-value product copy.
+// 3. Defines a flat per-service store addressed directly by product handle.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef PRODUCT_REGISTRY_HPP
+#define PRODUCT_REGISTRY_HPP
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+#include <optional>
+#include <stdexcept>
+#include <cstdint>
+
+using namespace std;
+
+// Handle of an interned product, a dense index into the product registry
+using ProductHandle = uint32_t;
+
+// Handle of the default-constructed product, held by default-constructed data objects
+const ProductHandle EMPTY_PRODUCT = 0;
+
+/**
+ * Registry owning one copy of every product, keyed on product identifier.
+ * References returned by Get() stay valid for the lifetime of the program.
+ * Products should be registered before any threads start; lookups are read-only after that.
+ * Type T is the product type.
+ */
+template<typename T>
+class ProductRegistry
+{
+
+public:
+	// Get the registry for product type T
+	static ProductRegistry<T>& Instance();
+
+	// Intern a product and return its handle (the existing handle if the identifier is known)
+	ProductHandle Intern(const T& product);
+
+	// Find the handle of a product identifier, returns false if it is not registered
+	bool Find(const string& productId, ProductHandle& handle) const;
+
+	// Get the handle of a registered product identifier (throws if it is not registered)
+	ProductHandle GetHandle(const string& productId) const;
+
+	// Get the product for a handle
+	const T& Get(ProductHandle handle) const;
+
+	// Get the number of handles (including the empty product)
+	size_t GetSize() const;
+
+private:
+	// ctor, handle 0 is the default-constructed product
+	ProductRegistry();
+
+	deque<T> products; // deque keeps references stable as products are added
+	unordered_map<string, ProductHandle> handles;
+
+};
+
+template<typename T>
+ProductRegistry<T>& ProductRegistry<T>::Instance()
+{
+	static ProductRegistry<T> registry;
+	return registry;
+}
+
+template<typename T>
+ProductRegistry<T>::ProductRegistry()
+{
+	products.push_back(T());
+}
+
+template<typename T>
+ProductHandle ProductRegistry<T>::Intern(const T& product)
+{
+	const string& productId = product.GetProductId();
+	auto it = handles.find(productId);
+	if (it != handles.end())
+	{
+		return it->second;
+	}
+
+	ProductHandle handle = static_cast<ProductHandle>(products.size());
+	products.push_back(product);
+	handles.insert(pair<string, ProductHandle>(productId, handle));
+	return handle;
+}
+
+template<typename T>
+bool ProductRegistry<T>::Find(const string& productId, ProductHandle& handle) const
+{
+	auto it = handles.find(productId);
+	if (it == handles.end())
+	{
+		return false;
+	}
+	handle = it->second;
+	return true;
+}
+
+template<typename T>
+ProductHandle ProductRegistry<T>::GetHandle(const string& productId) const
+{
+	auto it = handles.find(productId);
+	if (it == handles.end())
+	{
+		throw std::runtime_error("Key not found");
+	}
+	return it->second;
+}
+
+template<typename T>
+const T& ProductRegistry<T>::Get(ProductHandle handle) const
+{
+	return products[handle];
+}
+
+template<typename T>
+size_t ProductRegistry<T>::GetSize() const
+{
+	return products.size();
+}
+
+/**
+ * Flat store of one value per product, indexed by product handle.
+ * Lookups and updates are an array access, with no string hashing or comparison.
+ * Type V is the value type.
+ */
+template<typename V>
+class ProductStore
+{
+
+public:
+	// Find the value of a product, returns nullptr if there is none
+	V* Find(ProductHandle handle);
+	const V* Find(ProductHandle handle) const;
+
+	// Get the value of a product (throws if there is none)
+	V& Get(ProductHandle handle);
+
+	// Set the value of a product in place, adding it if needed
+	V& Put(ProductHandle handle, const V& value);
+
+	// Get the value of a product, default-constructing it if needed
+	V& operator[](ProductHandle handle);
+
+	// Visit every stored value in handle order
+	template<typename F>
+	void ForEach(F visit);
+
+	// Make room for a number of handles up front
+	// values of different products can then be put from different threads, since the store never grows
+	void Reserve(size_t size);
+
+private:
+	// Make room for a handle
+	void Grow(ProductHandle handle);
+
+	deque<optional<V>> values; // deque keeps references stable as the store grows
+
+};
+
+template<typename V>
+V* ProductStore<V>::Find(ProductHandle handle)
+{
+	if (handle >= values.size() || !values[handle])
+	{
+		return nullptr;
+	}
+	return &*values[handle];
+}
+
+template<typename V>
+const V* ProductStore<V>::Find(ProductHandle handle) const
+{
+	if (handle >= values.size() || !values[handle])
+	{
+		return nullptr;
+	}
+	return &*values[handle];
+}
+
+template<typename V>
+V& ProductStore<V>::Get(ProductHandle handle)
+{
+	V* value = Find(handle);
+	if (value == nullptr)
+	{
+		throw std::runtime_error("Key not found");
+	}
+	return *value;
+}
+
+template<typename V>
+V& ProductStore<V>::Put(ProductHandle handle, const V& value)
+{
+	Grow(handle);
+	if (values[handle])
+	{
+		*values[handle] = value;
+	}
+	else
+	{
+		values[handle].emplace(value);
+	}
+	return *values[handle];
+}
+
+template<typename V>
+V& ProductStore<V>::operator[](ProductHandle handle)
+{
+	Grow(handle);
+	if (!values[handle])
+	{
+		values[handle].emplace();
+	}
+	return *values[handle];
+}
+
+template<typename V>
+template<typename F>
+void ProductStore<V>::ForEach(F visit)
+{
+	for (auto& value : values)
+	{
+		if (value)
+		{
+			visit(*value);
+		}
+	}
+}
+
+template<typename V>
+void ProductStore<V>::Reserve(size_t size)
+{
+	if (size > values.size())
+	{
+		values.resize(size);
+	}
+}
+
+template<typename V>
+void ProductStore<V>::Grow(ProductHandle handle)
+{
+	if (handle >= values.size())
+	{
+		values.resize(handle + 1);
+	}
+}
+
+#endif
@@ -238,7 +238,7 @@ private:
 
 };
 
-Product::Product() : Product(0, BOND)
+Product::Product() : Product("", BOND)
 {
 }
 
@@ -257,7 +257,7 @@ ProductType Product::GetProductType() const
 	return productType;
 }
 
-Bond::Bond() : Product(0, BOND)
+Bond::Bond() : Product("", BOND)
 {
 }
 
@@ -297,7 +297,7 @@ ostream& operator<<(ostream& output, const Bond& bond)
 	return output;
 }
 
-IRSwap::IRSwap() : Product(0, IRSWAP)
+IRSwap::IRSwap() : Product("", IRSWAP)
 {
 }
 
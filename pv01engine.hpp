@@ -0,0 +1,233 @@
+// pv01engine.hpp
+//
+// Purpose: 1. Defines the live PV01 engine: the yield of each bond solved from its live mid price, and the PV01 at that yield.
+// 2. Only the products whose price changed are solved, together in one batch of lockstep Newton iterations.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef PV01_ENGINE_HPP
+#define PV01_ENGINE_HPP
+
+#include <vector>
+#include <span>
+#include <cmath>
+#include <stdexcept>
+
+#include "products.hpp"
+#include "productregistry.hpp"
+#include "pricingservice.hpp"
+#include "bondanalytics.hpp"
+
+using namespace std;
+
+// Settlement date of the live risk, the date the tenors of the static pv01 map are measured from
+const date PV01_SETTLEMENT = from_string("2017/12/15");
+
+// Face value the PV01 of one unit is quoted for, the scale of the static pv01 map
+const double PV01_FACE = 1000.0;
+
+/**
+ * Live PV01 of fixed coupon bonds.
+ * Each bond is reduced once to its cash flow terms at the settlement date: semi-annual coupon, number of
+ * remaining coupons and the fraction of a period to the next one. A price is taken as a clean price per 100
+ * face; its yield is found by Newton's method on the closed-form dirty price
+ *   P(r) = v^w (C (1 - v^N) / (1 - v) + 100 v^(N-1)), v = 1 / (1 + r), r = yield / 2
+ * and the PV01 is the analytic price change for a one basis point fall in yield, per PV01_FACE of face
+ * (see bondanalytics.hpp). Update() solves the products whose mid moved, starting from their last yield, as one batch so the
+ * iterations run in lockstep over plain arrays. Matured bonds have no yield and a PV01 of 0.
+ * Not thread safe; the risk service calls it under its lock.
+ * Type T is the product type, which must have GetCoupon() and GetMaturityDate().
+ */
+template<typename T>
+class PV01Engine
+{
+
+public:
+	// Coupons per year
+	static const int FREQUENCY = 2;
+
+	// ctor
+	PV01Engine(const date& _settlement = PV01_SETTLEMENT);
+
+	// Update the products of a batch of prices whose mid changed and append their handles to changed
+	void Update(span<const Price<T>> prices, vector<ProductHandle>& changed);
+
+	// Find the live PV01 of a product, returns false if it has not been priced
+	bool Find(ProductHandle product, double& pv01) const;
+
+	// Get the live yield of a product (throws if it has not been priced)
+	double GetYield(ProductHandle product) const;
+
+	// Get the event time of the price a product was last solved at, 0 if unknown
+	int64_t GetTimestamp(ProductHandle product) const;
+
+	// Get the settlement date
+	const date& GetSettlement() const;
+
+private:
+	// Compute the cash flow terms of a product on its first price
+	void AddProduct(ProductHandle product);
+
+	date settlement;
+
+	// per product handle
+	vector<double> coupon; // coupon paid per period per 100 face
+	vector<double> periods; // remaining coupons
+	vector<double> fraction; // fraction of a period to the next coupon
+	vector<long> mids; // bid + offer in ticks of the last solved price, -1 if never priced, 0 if matured
+	vector<double> yields;
+	vector<double> pv01s;
+	vector<int64_t> timestamps; // event time of the last solved price
+	vector<bool> known; // terms computed
+	vector<int> slots; // position in the batch being gathered, -1 if not in it
+
+	// gathered batch
+	vector<ProductHandle> batch;
+	vector<long> batchMid;
+	vector<int64_t> batchTimestamp;
+	vector<double> batchDirty, batchCoupon, batchPeriods, batchFraction, batchYield, batchPV01;
+
+};
+
+template<typename T>
+PV01Engine<T>::PV01Engine(const date& _settlement) : settlement(_settlement)
+{
+}
+
+template<typename T>
+void PV01Engine<T>::Update(span<const Price<T>> prices, vector<ProductHandle>& changed)
+{
+	// gather the products whose mid moved, a product priced twice in the batch is solved once at its last mid
+	batch.clear();
+	batchMid.clear();
+	batchTimestamp.clear();
+	for (auto& price : prices)
+	{
+		ProductHandle product = price.GetProductHandle();
+		AddProduct(product);
+		if (periods[product] == 0)
+		{
+			continue;
+		}
+		long mid = price.GetBid().GetTicks() + price.GetOffer().GetTicks();
+		if (slots[product] >= 0)
+		{
+			batchMid[slots[product]] = mid;
+			batchTimestamp[slots[product]] = price.GetTimestamp();
+		}
+		else if (mid != mids[product])
+		{
+			slots[product] = static_cast<int>(batch.size());
+			batch.push_back(product);
+			batchMid.push_back(mid);
+			batchTimestamp.push_back(price.GetTimestamp());
+		}
+	}
+	if (batch.empty())
+	{
+		return;
+	}
+
+	size_t n = batch.size();
+	batchDirty.resize(n);
+	batchCoupon.resize(n);
+	batchPeriods.resize(n);
+	batchFraction.resize(n);
+	batchYield.resize(n);
+	batchPV01.resize(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		ProductHandle product = batch[i];
+		batchCoupon[i] = coupon[product];
+		batchPeriods[i] = periods[product];
+		batchFraction[i] = fraction[product];
+		batchYield[i] = yields[product];
+		// the mid is a clean price, add the coupon accrued since the last coupon date
+		batchDirty[i] = TickPrice(batchMid[i]).ToDouble() / 2.0 + coupon[product] * (1.0 - fraction[product]);
+	}
+
+	SolveBondYields(n, batchDirty.data(), batchCoupon.data(), batchPeriods.data(), batchFraction.data(), FREQUENCY,
+		batchYield.data(), batchPV01.data());
+
+	for (size_t i = 0; i < n; i++)
+	{
+		ProductHandle product = batch[i];
+		slots[product] = -1;
+		mids[product] = batchMid[i];
+		yields[product] = batchYield[i];
+		pv01s[product] = batchPV01[i] * PV01_FACE / 100.0;
+		timestamps[product] = batchTimestamp[i];
+		changed.push_back(product);
+	}
+}
+
+template<typename T>
+bool PV01Engine<T>::Find(ProductHandle product, double& pv01) const
+{
+	if (product >= mids.size() || mids[product] < 0)
+	{
+		return false;
+	}
+	pv01 = pv01s[product];
+	return true;
+}
+
+template<typename T>
+double PV01Engine<T>::GetYield(ProductHandle product) const
+{
+	if (product >= mids.size() || mids[product] < 0)
+	{
+		throw std::invalid_argument("Product not priced: " + to_string(product));
+	}
+	return yields[product];
+}
+
+template<typename T>
+int64_t PV01Engine<T>::GetTimestamp(ProductHandle product) const
+{
+	return product < timestamps.size() ? timestamps[product] : 0;
+}
+
+template<typename T>
+const date& PV01Engine<T>::GetSettlement() const
+{
+	return settlement;
+}
+
+template<typename T>
+void PV01Engine<T>::AddProduct(ProductHandle product)
+{
+	if (product < known.size() && known[product])
+	{
+		return;
+	}
+	if (product >= known.size())
+	{
+		size_t size = product + 1;
+		coupon.resize(size, 0.0);
+		periods.resize(size, 0.0);
+		fraction.resize(size, 0.0);
+		mids.resize(size, -1);
+		yields.resize(size, 0.0);
+		pv01s.resize(size, 0.0);
+		timestamps.resize(size, 0);
+		known.resize(size, false);
+		slots.resize(size, -1);
+	}
+	known[product] = true;
+
+	const T& bond = ProductRegistry<T>::Instance().Get(product);
+	BondTerms terms = GetBondTerms(static_cast<double>(bond.GetCoupon()), bond.GetMaturityDate(), settlement, FREQUENCY);
+	coupon[product] = terms.coupon;
+	periods[product] = terms.periods;
+	fraction[product] = terms.fraction;
+	yields[product] = static_cast<double>(bond.GetCoupon());
+	if (terms.periods == 0)
+	{
+		// matured, nothing to solve
+		mids[product] = 0;
+	}
+}
+
+#endif
@@ -11,6 +11,8 @@
 
 #include "soa.hpp"
 #include "positionservice.hpp"
+#include "pricingservice.hpp"
+#include "pv01engine.hpp"
 #include "utilities.hpp"
 
 /**
@@ -28,6 +30,7 @@ public:
 
   // ctor for a PV01 value
   PV01(const T &_product, double _pv01, long _quantity);
+  PV01(ProductHandle _product, double _pv01, long _quantity, int64_t _timestamp = 0);
 
   // dtor
   ~PV01() = default;
@@ -35,6 +38,9 @@ public:
   // Get the product on this PV01 value
   const T& GetProduct() const;
 
+  // Get the registry handle of the product
+  ProductHandle GetProductHandle() const;
+
   // Get the PV01 value
   double GetPV01() const;
 
@@ -44,20 +50,33 @@ public:
   // Add quantity associated with this risk value
   void updateQuantity(long _quantity);
 
+  // Set the quantity that this risk value is associated with
+  void SetQuantity(long _quantity);
+
+  // Get the event time of the position this risk value was computed for, 0 if unknown
+  int64_t GetTimestamp() const;
+
   // Object printer
   template<typename S>
   friend ostream& operator<<(ostream& os, const PV01<S>& pv01);
 
 private:
-  T product;
+  ProductHandle product = EMPTY_PRODUCT;
   double pv01;
   long quantity;
+  int64_t timestamp = 0;
 
 };
 
 template<typename T>
 PV01<T>::PV01(const T &_product, double _pv01, long _quantity) :
-  product(_product)
+  PV01(ProductRegistry<T>::Instance().Intern(_product), _pv01, _quantity)
+{
+}
+
+template<typename T>
+PV01<T>::PV01(ProductHandle _product, double _pv01, long _quantity, int64_t _timestamp) :
+  product(_product), timestamp(_timestamp)
 {
   pv01 = _pv01;
   quantity = _quantity;
@@ -65,6 +84,12 @@ PV01<T>::PV01(const T &_product, double _pv01, long _quantity) :
 
 template<typename T>
 const T& PV01<T>::GetProduct() const
+{
+  return ProductRegistry<T>::Instance().Get(product);
+}
+
+template<typename T>
+ProductHandle PV01<T>::GetProductHandle() const
 {
   return product;
 }
@@ -87,11 +112,22 @@ void PV01<T>::updateQuantity(long _quantity)
   quantity += _quantity;
 }
 
+template<typename T>
+void PV01<T>::SetQuantity(long _quantity)
+{
+  quantity = _quantity;
+}
+
+template<typename T>
+int64_t PV01<T>::GetTimestamp() const
+{
+  return timestamp;
+}
+
 template<typename T>
 ostream& operator<<(ostream& output, const PV01<T>& pv01)
 {
-    T product = pv01.GetProduct();
-    string productId = product.GetProductId();
+    const string& productId = pv01.GetProduct().GetProductId();
     double pv01Value = pv01.GetPV01();
     long quantity = pv01.GetQuantity();
 
@@ -109,6 +145,9 @@ template<typename T>
 class BucketedSector
 {
 public:
+  // default ctor (needed for the sector registry)
+  BucketedSector() = default;
+
   // ctor for a bucket sector
   BucketedSector(const vector<T> &_products, string _name);
 
@@ -118,6 +157,9 @@ public:
   // Get the name of the bucket
   const string& GetName() const;
 
+  // Get the name of the bucket, the identifier of the sector in its product registry
+  const string& GetProductId() const;
+
 private:
   vector<T> products;
   string name;
@@ -143,13 +185,38 @@ const string& BucketedSector<T>::GetName() const
   return name;
 }
 
-// forward declaration of RiskServiceListener
+template<typename T>
+const string& BucketedSector<T>::GetProductId() const
+{
+  return name;
+}
+
+// Add a term to a compensated sum (Neumaier summation), so running totals do not drift from a rescan
+void CompensatedAdd(double& sum, double& compensation, double term)
+{
+  double next = sum + term;
+  compensation += abs(sum) >= abs(term) ? (sum - next) + term : (term - next) + sum;
+  sum = next;
+}
+
+// forward declaration of RiskServiceListener and RiskPriceListener
 template<typename T>
 class RiskServiceListener;
+template<typename T>
+class RiskPriceListener;
 
 
 /**
  * Risk Service to vend out risk for a particular security and across a risk bucketed sector.
+ * The unit PV01 of a product comes from the static pv01 map until the product is priced; linked to the
+ * pricing service through GetRiskPriceListener(), each price whose mid moved re-solves the product's yield
+ * (see pv01engine.hpp) and republishes the PV01 of its position at the new unit PV01.
+ * The PV01 of every sector (the standard front end, belly and long end, plus any added with AddSector)
+ * is kept up to date as positions change: a position moves the sums of the sectors holding its product
+ * by its change in quantity, so reading a sector is a lookup and sector listeners hear every change.
+ * Key rate ladders are kept the same way: the unit PV01 of a product is spread over the two key rate pillars
+ * around its maturity (the yield shift a key rate shock gives the bond, see GetPillarWeight), cached until
+ * its price moves, and the ladders of the sectors and of the whole book are running sums over positions.
  * Keyed on product identifier.
  * Type T is the product type.
  */
@@ -157,9 +224,42 @@ template<typename T>
 class RiskService : public Service<string,PV01 <T> >
 {
 private:
+  // running PV01 of a sector
+  struct SectorRisk
+  {
+    BucketedSector<T> sector;
+    double pv01 = 0.0; // total PV01 of the sector's positions
+    double compensation = 0.0; // rounding error of the running pv01 sum (Neumaier summation)
+    long quantity = 0; // total quantity of the sector's positions
+    int64_t timestamp = 0; // event time of the last position that moved the sector
+    PV01<BucketedSector<T>> risk; // the totals as published to the sector listeners
+    bool changed = false; // moved since the sector listeners were last notified
+    KeyRateVector keyRates = {}; // key rate ladder of the sector's positions
+    KeyRateVector keyRateCompensation = {};
+  };
+
+  // key rate ladder of one unit of a product
+  struct ProductKeyRates
+  {
+    int pillar = 0; // pillar at or below the maturity
+    double weight = 0.0; // share of the PV01 on the pillar above
+    KeyRateVector unit = {};
+  };
+
   vector<ServiceListener<PV01<T>>*> listeners;
-  map<string, PV01<T>> pv01Data;
+  ProductStore<PV01<T>> pv01Data; // store PV01 keyed by product handle
   RiskServiceListener<T>* riskservicelistener;
+  vector<ServiceListener<PV01<BucketedSector<T>>>*> sectorListeners;
+  ProductStore<SectorRisk> sectorRisk; // running sector totals keyed by sector handle
+  ProductStore<vector<ProductHandle>> productSectors; // handles of the sectors holding a product
+  vector<ProductHandle> changedSectors; // sectors moved since the sector listeners were last notified
+  RiskPriceListener<T>* riskpricelistener;
+  PV01Engine<T> engine; // live unit PV01 from the prices
+  vector<ProductHandle> repriced; // products whose unit PV01 the last prices moved
+  ProductStore<ProductKeyRates> productKeyRates; // unit key rate ladders keyed by product handle
+  KeyRateVector portfolioKeyRates = {}; // key rate ladder of every position
+  KeyRateVector portfolioCompensation = {};
+  mutable mutex lock; // guards the stored PV01 and the sector totals, prices and positions may arrive on different threads
 
 public:
   // ctor and dtor
@@ -169,6 +269,9 @@ public:
   // Get data on our service given a key
   PV01<T>& GetData(string key);
 
+  // Get data on our service given a product handle
+  PV01<T>& GetData(ProductHandle handle);
+
   // The callback that a Connector should invoke for any new or updated data
   void OnMessage(PV01<T> &data);
 
@@ -182,31 +285,91 @@ public:
   // Get the special listener for risk service
   RiskServiceListener<T>* GetRiskServiceListener();
 
+  // Get the listener taking prices from the pricing service to update the unit PV01
+  RiskPriceListener<T>* GetRiskPriceListener();
+
   // Add a position that the service will risk
   void AddPosition(Position<T> &position);
 
-  // Get the bucketed risk for the bucket sector
-  const PV01< BucketedSector<T> >& GetBucketedRisk(const BucketedSector<T> &sector) const;
+  // Add a batch of positions and publish their PV01 to the listeners as one batch
+  void AddPositionBatch(span<Position<T>> positions);
+
+  // Update the unit PV01 of the products of a batch of prices whose mid moved,
+  // and publish the PV01 of their positions
+  void AddPrices(span<Price<T>> prices);
+
+  // Track the risk of a sector from now on, returns its sector handle (the existing one if the name is known)
+  ProductHandle AddSector(const BucketedSector<T> &sector);
+
+  // Add a listener called with the PV01 of a sector whenever positions move it
+  // sector listeners are called one at a time, also when the product flows are sharded,
+  // under the service lock, so they take the risk from the callback rather than from the getters
+  void AddSectorListener(ServiceListener<PV01<BucketedSector<T>>> *listener);
+
+  // Get the bucketed risk for the bucket sector (throws if the sector is not tracked)
+  // note: for PV01 object of a sector, we store the total PV01 value instead of a single unit
+  PV01< BucketedSector<T> > GetBucketedRisk(const BucketedSector<T> &sector) const;
+
+  // Get the bucketed risk given a sector handle (throws if the sector is not tracked)
+  // a copy taken under the lock, as the sector rows move with every position
+  PV01< BucketedSector<T> > GetBucketedRisk(ProductHandle sector) const;
+
+  // Get the key rate ladder of one unit of a product (throws if the product has no risk yet)
+  KeyRateVector GetKeyRates(ProductHandle product) const;
+
+  // Get the key rate ladder of the positions of a sector (throws if the sector is not tracked)
+  KeyRateVector GetBucketedKeyRates(ProductHandle sector) const;
+
+  // Get the key rate ladder of every position
+  KeyRateVector GetPortfolioKeyRates() const;
+
+private:
+  // Update the stored PV01 of a position's product and the sectors holding it, return the PV01 of the position
+  PV01<T> UpdatePV01(const Position<T> &position);
+
+  // Spread the unit PV01 of a product over its key rate pillars
+  void UpdateKeyRates(ProductHandle product, double unitPV01);
+
+  // Move the portfolio key rates and the sectors holding a product by a change in its quantity
+  void UpdateSectors(ProductHandle product, double unitPV01, long change, int64_t timestamp);
+
+  // Notify the sector listeners of the sectors moved since the last call
+  void PublishSectors();
+
+  // Notify the listeners of the PV01 values in batch
+  void PublishBatch();
+
+  vector<PV01<T>> batch; // PV01 values of the batch being published
 
 };
 
 template<typename T>
-RiskService<T>::RiskService() : riskservicelistener(new RiskServiceListener<T>(this))
+RiskService<T>::RiskService() :
+  riskservicelistener(new RiskServiceListener<T>(this)), riskpricelistener(new RiskPriceListener<T>(this))
 {
+  pv01Data.Reserve(ProductRegistry<T>::Instance().GetSize());
+  productSectors.Reserve(ProductRegistry<T>::Instance().GetSize());
+
+  // the standard sectors of the curve
+  for (auto& item : sectorCusips){
+    vector<T> products;
+    for (auto& cusip : item.second){
+      products.push_back(QueryProduct<T>(cusip));
+    }
+    AddSector(BucketedSector<T>(products, item.first));
+  }
 }
 
 template<typename T>
 PV01<T>& RiskService<T>::GetData(string key)
 {
-    auto it = pv01Data.find(key);
-    if (it != pv01Data.end())
-    {
-        return it->second;
-    }
-    else
-    {
-        throw std::runtime_error("Key not found");
-    }
+    return GetData(ProductRegistry<T>::Instance().GetHandle(key));
+}
+
+template<typename T>
+PV01<T>& RiskService<T>::GetData(ProductHandle handle)
+{
+    return pv01Data.Get(handle);
 }
 
 /**
@@ -236,48 +399,256 @@ RiskServiceListener<T>* RiskService<T>::GetRiskServiceListener()
   return riskservicelistener;
 }
 
+template<typename T>
+RiskPriceListener<T>* RiskService<T>::GetRiskPriceListener()
+{
+  return riskpricelistener;
+}
+
 template<typename T>
 void RiskService<T>::AddPosition(Position<T> &position)
 {
-  T product = position.GetProduct();
-  string productId = product.GetProductId();
-  long quantity = position.GetAggregatePosition();
-  // note: this gives the PV01 value for a single unit
-  double pv01Val = QueryPV01(productId);
-
-  // create a PV01 object and publish it to the service
-  PV01<T> pv01(product, pv01Val, quantity);
-  if (pv01Data.find(productId) != pv01Data.end()){
-    pv01Data[productId].updateQuantity(quantity);
-  }else{
-    pv01Data.insert(pair<string, PV01<T>>(productId, pv01));
-  }
+  lock_guard<mutex> guard(lock);
+  PV01<T> pv01 = UpdatePV01(position);
 
   // notify listeners
   for(auto& listener : listeners)
     listener->ProcessAdd(pv01);
+  PublishSectors();
+}
+
+template<typename T>
+void RiskService<T>::AddPositionBatch(span<Position<T>> positions)
+{
+  lock_guard<mutex> guard(lock);
+  batch.clear();
+  for (auto& position : positions){
+    batch.push_back(UpdatePV01(position));
+  }
+
+  // notify listeners
+  PublishBatch();
+  PublishSectors();
 }
 
 template<typename T>
-const PV01<BucketedSector<T>>& RiskService<T>::GetBucketedRisk(const BucketedSector<T> &sector) const
+void RiskService<T>::AddPrices(span<Price<T>> prices)
 {
-  // create a bucketed sector object and publish it to the service
-  vector<T>& products = sector.GetProducts();
-  string name = sector.GetName();
-  double pv01Val = 0.0;
-  long quantity = 0;
-  for (auto& product : products){
-    string productId = product.GetProductId();
-    if (pv01Data.find(productId) != pv01Data.end()){
-      // total pv01 value for the sector is the weighted average
-      pv01Val += pv01Data[productId].GetPV01()*pv01Data[productId].GetQuantity();
-      // total quantity for the sector
-      quantity += pv01Data[productId].GetQuantity();
+  lock_guard<mutex> guard(lock);
+  repriced.clear();
+  engine.Update(prices, repriced);
+
+  // only products with a position have risk to republish
+  batch.clear();
+  for (ProductHandle product : repriced){
+    double unitPV01;
+    if (!engine.Find(product, unitPV01)){
+      continue;
+    }
+    UpdateKeyRates(product, unitPV01);
+    PV01<T>* stored = pv01Data.Find(product);
+    if (stored == nullptr){
+      continue;
     }
+    // stamped with the last price of this product in the batch, not the last of the batch
+    int64_t timestamp = engine.GetTimestamp(product);
+    UpdateSectors(product, unitPV01 - stored->GetPV01(), stored->GetQuantity(), timestamp);
+    *stored = PV01<T>(product, unitPV01, stored->GetQuantity(), timestamp);
+    batch.push_back(*stored);
   }
-  // note: for PV01 object of a sector, we store the total PV01 value instead of a single unit
-  PV01<BucketedSector<T>> pv01(sector, pv01Val, quantity);
-  return pv01;
+
+  // notify listeners
+  PublishBatch();
+  PublishSectors();
+}
+
+template<typename T>
+void RiskService<T>::PublishBatch()
+{
+  if (batch.size() == 1){
+    for(auto& listener : listeners)
+      listener->ProcessAdd(batch.front());
+  }
+  else if (!batch.empty()){
+    for(auto& listener : listeners)
+      listener->ProcessAddBatch(span<PV01<T>>(batch));
+  }
+}
+
+template<typename T>
+PV01<T> RiskService<T>::UpdatePV01(const Position<T> &position)
+{
+  ProductHandle product = position.GetProductHandle();
+  long quantity = position.GetAggregatePosition();
+
+  // the unit PV01 of a product is looked up once, later positions reuse the stored value
+  PV01<T>* stored = pv01Data.Find(product);
+  if (stored != nullptr){
+    // the position carries the product's new aggregate, the sectors move by the difference
+    UpdateSectors(product, stored->GetPV01(), quantity - stored->GetQuantity(), position.GetTimestamp());
+    stored->SetQuantity(quantity);
+    return PV01<T>(product, stored->GetPV01(), quantity, position.GetTimestamp());
+  }
+  // note: this gives the PV01 value for a single unit, live if the product has been priced
+  double pv01Val;
+  if (!engine.Find(product, pv01Val)){
+    pv01Val = QueryPV01(position.GetProduct().GetProductId());
+  }
+  UpdateKeyRates(product, pv01Val);
+  UpdateSectors(product, pv01Val, quantity, position.GetTimestamp());
+  return pv01Data.Put(product, PV01<T>(product, pv01Val, quantity, position.GetTimestamp()));
+}
+
+template<typename T>
+void RiskService<T>::UpdateKeyRates(ProductHandle product, double unitPV01)
+{
+  ProductKeyRates* entry = productKeyRates.Find(product);
+  if (entry == nullptr){
+    // where the product sits on the curve is fixed, only its PV01 moves
+    entry = &productKeyRates.Put(product, ProductKeyRates());
+    const T& bond = ProductRegistry<T>::Instance().Get(product);
+    BondTerms terms = GetBondTerms(static_cast<double>(bond.GetCoupon()), bond.GetMaturityDate(), engine.GetSettlement());
+    GetPillarWeight(terms.GetYears(), entry->pillar, entry->weight);
+  }
+  entry->unit[entry->pillar] = unitPV01*(1.0 - entry->weight);
+  entry->unit[entry->pillar + 1] = unitPV01*entry->weight;
+}
+
+template<typename T>
+void RiskService<T>::UpdateSectors(ProductHandle product, double unitPV01, long change, int64_t timestamp)
+{
+  if (change == 0){
+    return;
+  }
+  // compensated sums, so the totals do not drift from a rescan over millions of trades
+  double term = unitPV01*change;
+  const ProductKeyRates& keyRates = productKeyRates.Get(product);
+  double lower = term*(1.0 - keyRates.weight), upper = term*keyRates.weight;
+  CompensatedAdd(portfolioKeyRates[keyRates.pillar], portfolioCompensation[keyRates.pillar], lower);
+  CompensatedAdd(portfolioKeyRates[keyRates.pillar + 1], portfolioCompensation[keyRates.pillar + 1], upper);
+
+  const vector<ProductHandle>* sectors = productSectors.Find(product);
+  if (sectors == nullptr){
+    return;
+  }
+  for (ProductHandle handle : *sectors){
+    SectorRisk& entry = sectorRisk.Get(handle);
+    CompensatedAdd(entry.pv01, entry.compensation, term);
+    CompensatedAdd(entry.keyRates[keyRates.pillar], entry.keyRateCompensation[keyRates.pillar], lower);
+    CompensatedAdd(entry.keyRates[keyRates.pillar + 1], entry.keyRateCompensation[keyRates.pillar + 1], upper);
+    entry.quantity += change;
+    entry.timestamp = timestamp;
+    if (!entry.changed){
+      entry.changed = true;
+      changedSectors.push_back(handle);
+    }
+  }
+}
+
+template<typename T>
+void RiskService<T>::PublishSectors()
+{
+  for (ProductHandle handle : changedSectors){
+    SectorRisk& entry = sectorRisk.Get(handle);
+    entry.changed = false;
+    entry.risk = PV01<BucketedSector<T>>(handle, entry.pv01 + entry.compensation, entry.quantity, entry.timestamp);
+    for (auto& listener : sectorListeners)
+      listener->ProcessAdd(entry.risk);
+  }
+  changedSectors.clear();
+}
+
+template<typename T>
+ProductHandle RiskService<T>::AddSector(const BucketedSector<T> &sector)
+{
+  lock_guard<mutex> guard(lock);
+  ProductHandle handle = ProductRegistry<BucketedSector<T>>::Instance().Intern(sector);
+  if (sectorRisk.Find(handle) != nullptr){
+    return handle;
+  }
+
+  // start from the positions already held
+  SectorRisk& entry = sectorRisk[handle];
+  entry.sector = sector;
+  for (auto& product : sector.GetProducts()){
+    ProductHandle productHandle = ProductRegistry<T>::Instance().Intern(product);
+    productSectors[productHandle].push_back(handle);
+    const PV01<T>* stored = pv01Data.Find(productHandle);
+    if (stored != nullptr){
+      entry.pv01 += stored->GetPV01()*stored->GetQuantity();
+      entry.quantity += stored->GetQuantity();
+      const KeyRateVector& unit = productKeyRates.Get(productHandle).unit;
+      for (int i = 0; i < KEY_RATE_COUNT; i++){
+        entry.keyRates[i] += unit[i]*stored->GetQuantity();
+      }
+    }
+  }
+  entry.risk = PV01<BucketedSector<T>>(handle, entry.pv01, entry.quantity);
+  return handle;
+}
+
+template<typename T>
+void RiskService<T>::AddSectorListener(ServiceListener<PV01<BucketedSector<T>>> *listener)
+{
+  sectorListeners.push_back(listener);
+}
+
+template<typename T>
+PV01<BucketedSector<T>> RiskService<T>::GetBucketedRisk(const BucketedSector<T> &sector) const
+{
+  ProductHandle handle;
+  if (!ProductRegistry<BucketedSector<T>>::Instance().Find(sector.GetName(), handle)){
+    throw std::invalid_argument("Unknown sector: " + sector.GetName());
+  }
+  return GetBucketedRisk(handle);
+}
+
+template<typename T>
+PV01<BucketedSector<T>> RiskService<T>::GetBucketedRisk(ProductHandle sector) const
+{
+  lock_guard<mutex> guard(lock);
+  const SectorRisk* entry = sectorRisk.Find(sector);
+  if (entry == nullptr){
+    throw std::invalid_argument("Unknown sector handle: " + to_string(sector));
+  }
+  return entry->risk;
+}
+
+template<typename T>
+KeyRateVector RiskService<T>::GetKeyRates(ProductHandle product) const
+{
+  lock_guard<mutex> guard(lock);
+  const ProductKeyRates* entry = productKeyRates.Find(product);
+  if (entry == nullptr){
+    throw std::invalid_argument("Product has no risk: " + to_string(product));
+  }
+  return entry->unit;
+}
+
+template<typename T>
+KeyRateVector RiskService<T>::GetBucketedKeyRates(ProductHandle sector) const
+{
+  lock_guard<mutex> guard(lock);
+  const SectorRisk* entry = sectorRisk.Find(sector);
+  if (entry == nullptr){
+    throw std::invalid_argument("Unknown sector handle: " + to_string(sector));
+  }
+  KeyRateVector keyRates;
+  for (int i = 0; i < KEY_RATE_COUNT; i++){
+    keyRates[i] = entry->keyRates[i] + entry->keyRateCompensation[i];
+  }
+  return keyRates;
+}
+
+template<typename T>
+KeyRateVector RiskService<T>::GetPortfolioKeyRates() const
+{
+  lock_guard<mutex> guard(lock);
+  KeyRateVector keyRates;
+  for (int i = 0; i < KEY_RATE_COUNT; i++){
+    keyRates[i] = portfolioKeyRates[i] + portfolioCompensation[i];
+  }
+  return keyRates;
 }
 
 
@@ -305,6 +676,9 @@ public:
   // Listener callback to process an update event to the Service
   void ProcessUpdate(Position<T> &data);
 
+  // Listener callback to process a batch of add events to the Service
+  void ProcessAddBatch(span<Position<T>> batch) override;
+
 };
 
 template<typename T>
@@ -323,6 +697,12 @@ void RiskServiceListener<T>::ProcessAdd(Position<T> &data)
   riskservice->AddPosition(data);
 }
 
+template<typename T>
+void RiskServiceListener<T>::ProcessAddBatch(span<Position<T>> batch)
+{
+  riskservice->AddPositionBatch(batch);
+}
+
 template<typename T>
 void RiskServiceListener<T>::ProcessRemove(Position<T> &data)
 {
@@ -333,6 +713,61 @@ void RiskServiceListener<T>::ProcessUpdate(Position<T> &data)
 {
 }
 
+/**
+* Risk Price Listener subscribing prices from Pricing Service to Risk Service, to keep the unit PV01 live.
+* Type T is the product type.
+*/
+template<typename T>
+class RiskPriceListener : public ServiceListener<Price<T>>
+{
+private:
+  RiskService<T>* riskservice;
+
+public:
+  // ctor and dtor
+  RiskPriceListener(RiskService<T>* _riskservice);
+  ~RiskPriceListener()=default;
+
+  // Listener callback to process an add event to the Service
+  void ProcessAdd(Price<T> &data);
+
+  // Listener callback to process a remove event to the Service
+  void ProcessRemove(Price<T> &data);
+
+  // Listener callback to process an update event to the Service
+  void ProcessUpdate(Price<T> &data);
 
+  // Listener callback to process a batch of add events to the Service
+  void ProcessAddBatch(span<Price<T>> batch) override;
+
+};
+
+template<typename T>
+RiskPriceListener<T>::RiskPriceListener(RiskService<T>* _riskservice)
+{
+  riskservice = _riskservice;
+}
+
+template<typename T>
+void RiskPriceListener<T>::ProcessAdd(Price<T> &data)
+{
+  riskservice->AddPrices(span<Price<T>>(&data, 1));
+}
+
+template<typename T>
+void RiskPriceListener<T>::ProcessAddBatch(span<Price<T>> batch)
+{
+  riskservice->AddPrices(batch);
+}
+
+template<typename T>
+void RiskPriceListener<T>::ProcessRemove(Price<T> &data)
+{
+}
+
+template<typename T>
+void RiskPriceListener<T>::ProcessUpdate(Price<T> &data)
+{
+}
 
 #endif
@@ -0,0 +1,690 @@
+// scenarioriskservice.hpp
+//
+// Purpose: 1. Defines the curve scenarios and the data type and Service for scenario risk of the position book.
+// 2. A grid of parallel, twist and key rate shocks is evaluated over a snapshot of the positions,
+//    split into blocks of bonds and scenarios run in parallel on a pool of workers.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef SCENARIO_RISK_SERVICE_HPP
+#define SCENARIO_RISK_SERVICE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <span>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include "soa.hpp"
+#include "positionservice.hpp"
+#include "pricingservice.hpp"
+#include "pv01engine.hpp"
+#include "bondanalytics.hpp"
+#include "strandexecutor.hpp"
+
+using namespace std;
+
+/**
+ * Shock of the yield curve: a yield change at every key rate pillar, linear between pillars
+ * and flat beyond the first and the last (see GetPillarWeight).
+ */
+struct CurveScenario
+{
+	string name;
+	KeyRateVector shifts = {}; // yield change at each pillar, in decimal
+
+	// Get the yield change of a bond maturing between a pillar and the next one
+	double GetShift(int pillar, double weight) const { return shifts[pillar] * (1.0 - weight) + shifts[pillar + 1] * weight; }
+};
+
+// Get a scenario name such as parallel+25bp
+string ScenarioName(const string& prefix, double basisPoints)
+{
+	ostringstream name;
+	name << prefix << showpos << basisPoints << "bp";
+	return name.str();
+}
+
+// Get a parallel shift of the whole curve by a number of basis points
+CurveScenario ParallelScenario(double basisPoints)
+{
+	CurveScenario scenario;
+	scenario.name = ScenarioName("parallel", basisPoints);
+	scenario.shifts.fill(basisPoints * 1e-4);
+	return scenario;
+}
+
+// Get a twist of the curve around a pivot maturity, the 30 year moving by a number of basis points
+// more than the 2 year (a steepener if positive, a flattener if negative)
+CurveScenario TwistScenario(double basisPoints, double pivot = 10.0)
+{
+	CurveScenario scenario;
+	scenario.name = ScenarioName("twist", basisPoints);
+	double span = KEY_RATE_PILLARS[KEY_RATE_COUNT - 1] - KEY_RATE_PILLARS[0];
+	for (int i = 0; i < KEY_RATE_COUNT; i++)
+	{
+		scenario.shifts[i] = basisPoints * 1e-4 * (KEY_RATE_PILLARS[i] - pivot) / span;
+	}
+	return scenario;
+}
+
+// Get a shift of one key rate pillar by a number of basis points, fading linearly to the neighbouring pillars
+CurveScenario KeyRateScenario(int pillar, double basisPoints)
+{
+	if (pillar < 0 || pillar >= KEY_RATE_COUNT)
+	{
+		throw std::invalid_argument("Unknown key rate pillar: " + to_string(pillar));
+	}
+	CurveScenario scenario;
+	scenario.name = ScenarioName("keyrate" + to_string(static_cast<int>(KEY_RATE_PILLARS[pillar])) + "Y", basisPoints);
+	scenario.shifts[pillar] = basisPoints * 1e-4;
+	return scenario;
+}
+
+// Get the standard stress grid: parallel shifts from -300bp to +300bp in 25bp steps,
+// twists of 25, 50 and 100bp both ways and every key rate pillar 25bp both ways
+vector<CurveScenario> StandardScenarios()
+{
+	vector<CurveScenario> scenarios;
+	for (int basisPoints = -300; basisPoints <= 300; basisPoints += 25)
+	{
+		scenarios.push_back(ParallelScenario(basisPoints));
+	}
+	for (double basisPoints : { -100.0, -50.0, -25.0, 25.0, 50.0, 100.0 })
+	{
+		scenarios.push_back(TwistScenario(basisPoints));
+	}
+	for (int pillar = 0; pillar < KEY_RATE_COUNT; pillar++)
+	{
+		scenarios.push_back(KeyRateScenario(pillar, -25.0));
+		scenarios.push_back(KeyRateScenario(pillar, 25.0));
+	}
+	return scenarios;
+}
+
+/**
+ * Profit and loss of the position book under a curve scenario.
+ * Also holds the product losing the most under the scenario.
+ * Type T is the product type.
+ */
+template<typename T>
+class ScenarioRisk
+{
+
+public:
+	// ctor
+	ScenarioRisk() = default;
+	ScenarioRisk(const string& _scenario, double _pnl, ProductHandle _worstProduct, double _worstPnL, size_t _positions, int64_t _timestamp = 0);
+
+	// Get the name of the scenario
+	const string& GetScenario() const;
+
+	// Get the profit and loss of the book under the scenario
+	double GetPnL() const;
+
+	// Get the product losing the most under the scenario (throws if the book is flat)
+	const T& GetWorstProduct() const;
+
+	// Get the registry handle of the product losing the most, EMPTY_PRODUCT if the book is flat
+	ProductHandle GetWorstProductHandle() const;
+
+	// Get the profit and loss of the product losing the most
+	double GetWorstPnL() const;
+
+	// Get the number of positions evaluated
+	size_t GetPositionCount() const;
+
+	// Get the event time of the latest position evaluated, 0 if unknown
+	int64_t GetTimestamp() const;
+
+	// object printer
+	template<typename S>
+	friend ostream& operator<<(ostream& output, const ScenarioRisk<S>& risk);
+
+private:
+	string scenario;
+	double pnl = 0.0;
+	ProductHandle worstProduct = EMPTY_PRODUCT;
+	double worstPnL = 0.0;
+	size_t positions = 0;
+	int64_t timestamp = 0;
+
+};
+
+template<typename T>
+ScenarioRisk<T>::ScenarioRisk(const string& _scenario, double _pnl, ProductHandle _worstProduct, double _worstPnL, size_t _positions, int64_t _timestamp) :
+	scenario(_scenario), pnl(_pnl), worstProduct(_worstProduct), worstPnL(_worstPnL), positions(_positions), timestamp(_timestamp)
+{
+}
+
+template<typename T>
+const string& ScenarioRisk<T>::GetScenario() const
+{
+	return scenario;
+}
+
+template<typename T>
+double ScenarioRisk<T>::GetPnL() const
+{
+	return pnl;
+}
+
+template<typename T>
+const T& ScenarioRisk<T>::GetWorstProduct() const
+{
+	return ProductRegistry<T>::Instance().Get(worstProduct);
+}
+
+template<typename T>
+ProductHandle ScenarioRisk<T>::GetWorstProductHandle() const
+{
+	return worstProduct;
+}
+
+template<typename T>
+double ScenarioRisk<T>::GetWorstPnL() const
+{
+	return worstPnL;
+}
+
+template<typename T>
+size_t ScenarioRisk<T>::GetPositionCount() const
+{
+	return positions;
+}
+
+template<typename T>
+int64_t ScenarioRisk<T>::GetTimestamp() const
+{
+	return timestamp;
+}
+
+template<typename T>
+ostream& operator<<(ostream& output, const ScenarioRisk<T>& risk)
+{
+	output << risk.scenario << "," << risk.pnl << ",";
+	if (risk.worstProduct != EMPTY_PRODUCT)
+	{
+		output << risk.GetWorstProduct().GetProductId();
+	}
+	output << "," << risk.worstPnL << "," << risk.positions;
+	return output;
+}
+
+// pre declaration of the listeners feeding the scenario risk service
+template<typename T>
+class ScenarioPositionListener;
+template<typename T>
+class ScenarioPriceListener;
+
+/**
+ * Scenario Risk Service evaluating a grid of curve scenarios over the whole position book on demand.
+ * Positions arrive through GetScenarioPositionListener(); each product is valued at the yield solved from
+ * its last price if linked to the pricing service through GetScenarioPriceListener(), and at par otherwise.
+ * Evaluate() snapshots the book under the lock and reduces every bond once to its cash flow terms,
+ * then values each bond under each scenario with the closed-form price of bondanalytics.hpp. The work is
+ * split into blocks of bonds by blocks of scenarios, run on a pool of workers and summed per scenario,
+ * so positions and prices keep flowing while a grid is evaluated.
+ * The profit and loss of a scenario is the cash value of each position's price change, with quantities as
+ * face amounts (see PRICE_FACE) as in the PnL service, so the two report in the same currency amounts.
+ * One ScenarioRisk per scenario is published to the listeners as a batch.
+ * Keyed on scenario name.
+ * Type T is the product type.
+ */
+template<typename T>
+class ScenarioRiskService : public Service<string, ScenarioRisk<T>>
+{
+
+public:
+	// ctor, workers 0 takes one per core
+	ScenarioRiskService(size_t _workers = 0);
+
+	// Get the result of the last evaluation of a scenario
+	ScenarioRisk<T>& GetData(string key) override;
+
+	// The callback that a Connector should invoke for any new or updated data
+	void OnMessage(ScenarioRisk<T>& data) override;
+
+	// Add a listener to the Service for callbacks on add, remove, and update events
+	// for data to the Service.
+	void AddListener(ServiceListener<ScenarioRisk<T>>* listener) override;
+
+	// Get all listeners on the Service.
+	const vector<ServiceListener<ScenarioRisk<T>>*>& GetListeners() const override;
+
+	// Get the listener taking positions from the position service
+	ScenarioPositionListener<T>* GetScenarioPositionListener();
+
+	// Get the listener taking prices from the pricing service to value the bonds at their live yields
+	ScenarioPriceListener<T>* GetScenarioPriceListener();
+
+	// Set the scenarios evaluated from now on (the standard grid until set)
+	void SetScenarios(const vector<CurveScenario>& _scenarios);
+
+	// Get the scenarios evaluated
+	const vector<CurveScenario>& GetScenarios() const;
+
+	// Add a position to the book
+	void AddPosition(const Position<T>& position);
+
+	// Add a batch of positions to the book
+	void AddPositionBatch(span<Position<T>> positions);
+
+	// Update the yields of the products of a batch of prices
+	void AddPrices(span<Price<T>> prices);
+
+	// Evaluate every scenario over the current book and publish the results to the listeners
+	// the results stay valid until the next evaluation
+	const vector<ScenarioRisk<T>>& Evaluate();
+
+private:
+	// Bonds valued by a task
+	static constexpr size_t BOND_BLOCK = 1024;
+
+	// Scenarios valued by a task
+	static constexpr size_t SCENARIO_BLOCK = 8;
+
+	// Compute the cash flow terms of a product on its first position
+	void AddProduct(ProductHandle product);
+
+	// Value a block of bonds under a block of scenarios, into the partial sums of the bond block
+	void EvaluateBlock(size_t bondBlock, size_t firstScenario, size_t lastScenario);
+
+	vector<ServiceListener<ScenarioRisk<T>>*> listeners;
+	unique_ptr<ScenarioPositionListener<T>> positionListener;
+	unique_ptr<ScenarioPriceListener<T>> priceListener;
+	vector<CurveScenario> scenarios;
+	mutex lock; // guards the book and the yields, positions and prices may arrive on different threads
+
+	// the book, per product handle
+	vector<long> quantities; // aggregate position
+	vector<int64_t> timestamps; // event time of the last position
+	vector<BondTerms> terms;
+	vector<bool> known; // terms computed
+	PV01Engine<T> engine; // live yields from the prices
+	vector<ProductHandle> repriced; // products whose yield the last prices moved
+
+	// snapshot of the book being evaluated, one entry per bond held
+	mutex evaluateLock; // one evaluation at a time
+	vector<ProductHandle> heldProducts;
+	vector<double> heldCoupon, heldPeriods, heldFraction, heldYield, heldQuantity, heldWeight, heldBase;
+	vector<int> heldPillar;
+	int frequency;
+
+	// partial sums of every bond block per scenario
+	vector<double> partialPnL, partialWorstPnL;
+	vector<size_t> partialWorst;
+
+	vector<ScenarioRisk<T>> results; // of the last evaluation
+	map<string, size_t> resultIndex; // position of a scenario in the results
+	size_t workers;
+	unique_ptr<StrandExecutor> executor; // started by the first evaluation
+
+};
+
+template<typename T>
+ScenarioRiskService<T>::ScenarioRiskService(size_t _workers) :
+	positionListener(new ScenarioPositionListener<T>(this)), priceListener(new ScenarioPriceListener<T>(this)),
+	scenarios(StandardScenarios()), frequency(PV01Engine<T>::FREQUENCY),
+	workers(_workers > 0 ? _workers : max<size_t>(1, thread::hardware_concurrency()))
+{
+}
+
+template<typename T>
+ScenarioRisk<T>& ScenarioRiskService<T>::GetData(string key)
+{
+	lock_guard<mutex> guard(evaluateLock);
+	auto it = resultIndex.find(key);
+	if (it == resultIndex.end())
+	{
+		throw std::runtime_error("Key not found");
+	}
+	return results[it->second];
+}
+
+/**
+ * OnMessage() used to be called by connector to subscribe data
+ * no need to implement here.
+ */
+template<typename T>
+void ScenarioRiskService<T>::OnMessage(ScenarioRisk<T>& data)
+{
+}
+
+template<typename T>
+void ScenarioRiskService<T>::AddListener(ServiceListener<ScenarioRisk<T>>* listener)
+{
+	listeners.push_back(listener);
+}
+
+template<typename T>
+const vector<ServiceListener<ScenarioRisk<T>>*>& ScenarioRiskService<T>::GetListeners() const
+{
+	return listeners;
+}
+
+template<typename T>
+ScenarioPositionListener<T>* ScenarioRiskService<T>::GetScenarioPositionListener()
+{
+	return positionListener.get();
+}
+
+template<typename T>
+ScenarioPriceListener<T>* ScenarioRiskService<T>::GetScenarioPriceListener()
+{
+	return priceListener.get();
+}
+
+template<typename T>
+void ScenarioRiskService<T>::SetScenarios(const vector<CurveScenario>& _scenarios)
+{
+	lock_guard<mutex> guard(evaluateLock);
+	scenarios = _scenarios;
+}
+
+template<typename T>
+const vector<CurveScenario>& ScenarioRiskService<T>::GetScenarios() const
+{
+	return scenarios;
+}
+
+template<typename T>
+void ScenarioRiskService<T>::AddPosition(const Position<T>& position)
+{
+	lock_guard<mutex> guard(lock);
+	ProductHandle product = position.GetProductHandle();
+	AddProduct(product);
+	quantities[product] = position.GetAggregatePosition();
+	timestamps[product] = position.GetTimestamp();
+}
+
+template<typename T>
+void ScenarioRiskService<T>::AddPositionBatch(span<Position<T>> positions)
+{
+	lock_guard<mutex> guard(lock);
+	for (auto& position : positions)
+	{
+		ProductHandle product = position.GetProductHandle();
+		AddProduct(product);
+		quantities[product] = position.GetAggregatePosition();
+		timestamps[product] = position.GetTimestamp();
+	}
+}
+
+template<typename T>
+void ScenarioRiskService<T>::AddPrices(span<Price<T>> prices)
+{
+	lock_guard<mutex> guard(lock);
+	repriced.clear();
+	engine.Update(prices, repriced);
+}
+
+template<typename T>
+void ScenarioRiskService<T>::AddProduct(ProductHandle product)
+{
+	if (product < known.size() && known[product])
+	{
+		return;
+	}
+	if (product >= known.size())
+	{
+		size_t size = product + 1;
+		quantities.resize(size, 0);
+		timestamps.resize(size, 0);
+		terms.resize(size);
+		known.resize(size, false);
+	}
+	known[product] = true;
+	const T& bond = ProductRegistry<T>::Instance().Get(product);
+	terms[product] = GetBondTerms(static_cast<double>(bond.GetCoupon()), bond.GetMaturityDate(), engine.GetSettlement(), frequency);
+}
+
+template<typename T>
+const vector<ScenarioRisk<T>>& ScenarioRiskService<T>::Evaluate()
+{
+	lock_guard<mutex> evaluateGuard(evaluateLock);
+
+	// snapshot the bonds held at their live yields or at par, with their base prices and where they sit on the curve,
+	// so that the valuation reads nothing the positions may move
+	int64_t timestamp = 0;
+	heldProducts.clear();
+	heldCoupon.clear();
+	heldPeriods.clear();
+	heldFraction.clear();
+	heldYield.clear();
+	heldQuantity.clear();
+	heldPillar.clear();
+	heldWeight.clear();
+	heldBase.clear();
+	{
+		lock_guard<mutex> guard(lock);
+		for (ProductHandle product = 0; product < quantities.size(); product++)
+		{
+			if (quantities[product] == 0 || terms[product].periods == 0)
+			{
+				continue;
+			}
+			const BondTerms& bond = terms[product];
+			double pv01, yield = bond.coupon * frequency / 100.0;
+			if (engine.Find(product, pv01))
+			{
+				yield = engine.GetYield(product);
+			}
+			int pillar;
+			double weight;
+			GetPillarWeight(bond.GetYears(), pillar, weight);
+			heldProducts.push_back(product);
+			heldCoupon.push_back(bond.coupon);
+			heldPeriods.push_back(bond.periods);
+			heldFraction.push_back(bond.fraction);
+			heldYield.push_back(yield);
+			heldQuantity.push_back(static_cast<double>(quantities[product]) / PRICE_FACE);
+			heldPillar.push_back(pillar);
+			heldWeight.push_back(weight);
+			heldBase.push_back(BondPrice(bond, yield));
+			timestamp = max(timestamp, timestamps[product]);
+		}
+	}
+
+	// value every block of bonds under every block of scenarios in parallel
+	size_t n = heldProducts.size();
+	size_t m = scenarios.size();
+	if (!executor)
+	{
+		executor.reset(new StrandExecutor(workers));
+	}
+	size_t bondBlocks = (n + BOND_BLOCK - 1) / BOND_BLOCK;
+	partialPnL.assign(bondBlocks * m, 0.0);
+	partialWorstPnL.assign(bondBlocks * m, 0.0);
+	partialWorst.assign(bondBlocks * m, 0);
+	size_t task = 0;
+	for (size_t block = 0; block < bondBlocks; block++)
+	{
+		for (size_t first = 0; first < m; first += SCENARIO_BLOCK)
+		{
+			size_t last = min(m, first + SCENARIO_BLOCK);
+			executor->Post(task++, [this, block, first, last]() { EvaluateBlock(block, first, last); });
+		}
+	}
+	executor->Drain();
+
+	// sum the blocks of each scenario
+	results.clear();
+	resultIndex.clear();
+	for (size_t j = 0; j < m; j++)
+	{
+		double pnl = 0.0, worstPnL = 0.0;
+		ProductHandle worst = EMPTY_PRODUCT;
+		for (size_t block = 0; block < bondBlocks; block++)
+		{
+			size_t index = block * m + j;
+			pnl += partialPnL[index];
+			if (worst == EMPTY_PRODUCT || partialWorstPnL[index] < worstPnL)
+			{
+				worst = heldProducts[partialWorst[index]];
+				worstPnL = partialWorstPnL[index];
+			}
+		}
+		resultIndex[scenarios[j].name] = results.size();
+		results.push_back(ScenarioRisk<T>(scenarios[j].name, pnl, worst, worstPnL, n, timestamp));
+	}
+
+	// notify listeners
+	if (!results.empty())
+	{
+		for (auto& listener : listeners)
+		{
+			listener->ProcessAddBatch(span<ScenarioRisk<T>>(results));
+		}
+	}
+	return results;
+}
+
+template<typename T>
+void ScenarioRiskService<T>::EvaluateBlock(size_t bondBlock, size_t firstScenario, size_t lastScenario)
+{
+	size_t begin = bondBlock * BOND_BLOCK;
+	size_t end = min(heldProducts.size(), begin + BOND_BLOCK);
+	size_t m = scenarios.size();
+	for (size_t j = firstScenario; j < lastScenario; j++)
+	{
+		const CurveScenario& scenario = scenarios[j];
+		double pnl = 0.0, worstPnL = 0.0;
+		size_t worst = begin;
+		for (size_t i = begin; i < end; i++)
+		{
+			double r = (heldYield[i] + scenario.GetShift(heldPillar[i], heldWeight[i])) / frequency;
+			double price, first, second;
+			BondMoments(heldCoupon[i], heldPeriods[i], heldFraction[i], r, price, first, second);
+			double change = heldQuantity[i] * (price - heldBase[i]);
+			pnl += change;
+			if (i == begin || change < worstPnL)
+			{
+				worst = i;
+				worstPnL = change;
+			}
+		}
+		size_t index = bondBlock * m + j;
+		partialPnL[index] = pnl;
+		partialWorst[index] = worst;
+		partialWorstPnL[index] = worstPnL;
+	}
+}
+
+/**
+ * Scenario Position Listener subscribing positions from Position Service to Scenario Risk Service.
+ * Type T is the product type.
+ */
+template<typename T>
+class ScenarioPositionListener final : public ServiceListener<Position<T>>
+{
+private:
+	ScenarioRiskService<T>* service;
+
+public:
+	// ctor
+	ScenarioPositionListener(ScenarioRiskService<T>* _service);
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(Position<T>& data) override;
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(Position<T>& data) override;
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(Position<T>& data) override;
+
+	// Listener callback to process a batch of add events to the Service
+	void ProcessAddBatch(span<Position<T>> batch) override;
+
+};
+
+template<typename T>
+ScenarioPositionListener<T>::ScenarioPositionListener(ScenarioRiskService<T>* _service) : service(_service)
+{
+}
+
+template<typename T>
+void ScenarioPositionListener<T>::ProcessAdd(Position<T>& data)
+{
+	service->AddPosition(data);
+}
+
+template<typename T>
+void ScenarioPositionListener<T>::ProcessRemove(Position<T>& data)
+{
+}
+
+template<typename T>
+void ScenarioPositionListener<T>::ProcessUpdate(Position<T>& data)
+{
+}
+
+template<typename T>
+void ScenarioPositionListener<T>::ProcessAddBatch(span<Position<T>> batch)
+{
+	service->AddPositionBatch(batch);
+}
+
+/**
+ * Scenario Price Listener subscribing prices from Pricing Service to Scenario Risk Service, to value the bonds at live yields.
+ * Type T is the product type.
+ */
+template<typename T>
+class ScenarioPriceListener final : public ServiceListener<Price<T>>
+{
+private:
+	ScenarioRiskService<T>* service;
+
+public:
+	// ctor
+	ScenarioPriceListener(ScenarioRiskService<T>* _service);
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(Price<T>& data) override;
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(Price<T>& data) override;
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(Price<T>& data) override;
+
+	// Listener callback to process a batch of add events to the Service
+	void ProcessAddBatch(span<Price<T>> batch) override;
+
+};
+
+template<typename T>
+ScenarioPriceListener<T>::ScenarioPriceListener(ScenarioRiskService<T>* _service) : service(_service)
+{
+}
+
+template<typename T>
+void ScenarioPriceListener<T>::ProcessAdd(Price<T>& data)
+{
+	service->AddPrices(span<Price<T>>(&data, 1));
+}
+
+template<typename T>
+void ScenarioPriceListener<T>::ProcessRemove(Price<T>& data)
+{
+}
+
+template<typename T>
+void ScenarioPriceListener<T>::ProcessUpdate(Price<T>& data)
+{
+}
+
+template<typename T>
+void ScenarioPriceListener<T>::ProcessAddBatch(span<Price<T>> batch)
+{
+	service->AddPrices(batch);
+}
+
+#endif
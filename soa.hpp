@@ -1,6 +1,8 @@
 // soa.hpp
 //
 // Purpose: 1. Definition of our Service Oriented Architecture (SOA) Service base class
+// 2. Listeners and services can also take batches of data, one virtual call per batch
+// 3. Optional latency instrumentation, compiled in only when SOA_INSTRUMENT is defined
 // 
 // @author Breman Thuraisingham
 // @coauthor Yuanting Li
@@ -10,6 +12,13 @@
 #define SOA_HPP
 
 #include <vector>
+#include <span>
+#include <cstddef>
+#include <string>
+
+#ifdef SOA_INSTRUMENT
+#include "latency.hpp"
+#endif
 
 using namespace std;
 
@@ -32,8 +41,32 @@ public:
 	// Listener callback to process an update event to the Service
 	virtual void ProcessUpdate(V& data) = 0;
 
+	// Listener callback to process a batch of add events to the Service
+	// by default one ProcessAdd() per item, batch-aware listeners override it
+	virtual void ProcessAddBatch(span<V> batch);
+
 };
 
+template<typename V>
+void ServiceListener<V>::ProcessAddBatch(span<V> batch)
+{
+#ifdef SOA_INSTRUMENT
+	// each item goes on with its own ingress stamp
+	long long ingress = eventIngress;
+	for (auto& data : batch)
+	{
+		eventIngress = IngressOf(data);
+		ProcessAdd(data);
+	}
+	eventIngress = ingress;
+#else
+	for (auto& data : batch)
+	{
+		ProcessAdd(data);
+	}
+#endif
+}
+
 /**
  * Definition of a generic base class Service.
  * Uses key generic type K and value generic type V.
@@ -57,8 +90,159 @@ public:
 	// Get all listeners on the Service.
 	virtual const vector< ServiceListener<V>* >& GetListeners() const = 0;
 
+	// The callback that a Connector should invoke for a batch of new or updated data
+	// by default one OnMessage() per item, batch-aware services override it
+	virtual void OnMessageBatch(span<V> batch);
+
+};
+
+template<typename K, typename V>
+void Service<K, V>::OnMessageBatch(span<V> batch)
+{
+	for (auto& data : batch)
+	{
+		OnMessage(data);
+	}
+}
+
+#ifdef SOA_INSTRUMENT
+
+#define SOA_CONCAT_IMPL(a, b) a##b
+#define SOA_CONCAT(a, b) SOA_CONCAT_IMPL(a, b)
+
+// Stamp the event an inbound connector has just read with the current time
+#define SOA_STAMP_INGRESS() (eventIngress = LatencyClock())
+
+// Stamp an event an inbound connector has just read into a batch, one stamp per event in a parallel vector
+#define SOA_STAMP_BATCH_EVENT(stamps) (stamps.push_back(LatencyClock()))
+
+// Hand the stamps of a batch to the listeners until the end of the enclosing scope (see ScopedIngressBatch)
+#define SOA_INGRESS_BATCH(batch, stamps) ScopedIngressBatch SOA_CONCAT(soaBatch, __LINE__)(batch, stamps)
+
+// Record the time spent in the rest of the enclosing scope into a named histogram
+// the name is looked up once per call site (per template instantiation)
+#define SOA_TIME_SCOPE(name) \
+	static LatencyHistogram& SOA_CONCAT(soaHistogram, __LINE__) = LatencyRegistry::Instance().Get(name); \
+	ScopedLatency SOA_CONCAT(soaScope, __LINE__)(SOA_CONCAT(soaHistogram, __LINE__))
+
+// Record the time since the current event was stamped into a named histogram
+#define SOA_RECORD_SINCE_INGRESS(name) \
+	do { \
+		static LatencyHistogram& soaHistogram = LatencyRegistry::Instance().Get(name); \
+		if (eventIngress != 0) soaHistogram.Record(LatencyClock() - eventIngress); \
+	} while (0)
+
+// Start and stop writing every histogram to a file at a fixed interval
+#define SOA_START_LATENCY_DUMP(path, intervalMillis) LatencyRegistry::Instance().StartDump(path, intervalMillis)
+#define SOA_STOP_LATENCY_DUMP() LatencyRegistry::Instance().StopDump()
+
+/**
+ * Listener decorator recording the latency of one listener edge.
+ * "<edge>.arrival" is the time from the connector stamping the event to the listener being called,
+ * "<edge>.process" is the time spent inside the listener, including any synchronous downstream services.
+ * A batch callback records one arrival per event and one process sample for the whole batch.
+ * Type V is the data type of the edge.
+ */
+template<typename V>
+class TimedListener : public ServiceListener<V>
+{
+
+public:
+	// ctor
+	TimedListener(ServiceListener<V>* _target, const string& edge);
+
+	// Listener callback to process an add event to the Service
+	void ProcessAdd(V& data) override;
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(V& data) override;
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(V& data) override;
+
+	// Listener callback to process a batch of add events to the Service
+	void ProcessAddBatch(span<V> batch) override;
+
+private:
+	// Record the arrival of an event and start timing the listener
+	ScopedLatency Arrive(const V& data);
+
+	ServiceListener<V>* target;
+	LatencyHistogram& arrival;
+	LatencyHistogram& process;
+
 };
 
+template<typename V>
+TimedListener<V>::TimedListener(ServiceListener<V>* _target, const string& edge) :
+	target(_target), arrival(LatencyRegistry::Instance().Get(edge + ".arrival")), process(LatencyRegistry::Instance().Get(edge + ".process"))
+{
+}
+
+template<typename V>
+void TimedListener<V>::ProcessAdd(V& data)
+{
+	ScopedLatency timer = Arrive(data);
+	target->ProcessAdd(data);
+}
+
+template<typename V>
+void TimedListener<V>::ProcessRemove(V& data)
+{
+	ScopedLatency timer = Arrive(data);
+	target->ProcessRemove(data);
+}
+
+template<typename V>
+void TimedListener<V>::ProcessUpdate(V& data)
+{
+	ScopedLatency timer = Arrive(data);
+	target->ProcessUpdate(data);
+}
+
+template<typename V>
+void TimedListener<V>::ProcessAddBatch(span<V> batch)
+{
+	long long now = LatencyClock();
+	for (auto& data : batch)
+	{
+		long long ingress = IngressOf(data);
+		if (ingress != 0)
+		{
+			arrival.Record(now - ingress);
+		}
+	}
+	ScopedLatency timer(process);
+	target->ProcessAddBatch(batch);
+}
+
+template<typename V>
+ScopedLatency TimedListener<V>::Arrive(const V& data)
+{
+	long long ingress = IngressOf(data);
+	if (ingress != 0)
+	{
+		arrival.Record(LatencyClock() - ingress);
+	}
+	return ScopedLatency(process);
+}
+
+#else
+
+// instrumentation compiled out: the hooks expand to nothing
+#define SOA_STAMP_INGRESS() ((void)0)
+#define SOA_STAMP_BATCH_EVENT(stamps) ((void)0)
+#define SOA_INGRESS_BATCH(batch, stamps) ((void)0)
+#define SOA_TIME_SCOPE(name) ((void)0)
+#define SOA_RECORD_SINCE_INGRESS(name) ((void)0)
+#define SOA_START_LATENCY_DUMP(path, intervalMillis) ((void)0)
+#define SOA_STOP_LATENCY_DUMP() ((void)0)
+
+#endif
+
+// Number of records an inbound connector collects before sending them to its service as one batch
+const size_t CONNECTOR_BATCH_SIZE = 1024;
+
 /**
  * Definition of a Connector class.
  * This will invoke the Service.OnMessage() method for subscriber Connectors
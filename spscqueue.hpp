@@ -0,0 +1,123 @@
+// spscqueue.hpp
+//
+// Purpose: 1. Defines a bounded lock-free single-producer/single-consumer ring buffer.
+// 2. Used to hand data from one service thread to the next without locks.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+
+using namespace std;
+
+// Size of a cache line, producer and consumer indices live on separate lines
+const size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Bounded ring buffer for exactly one producer thread and one consumer thread.
+ * The capacity is rounded up to a power of two. Each side keeps a cached copy of the
+ * other side's index so that the shared index is only re-read when the queue looks full or empty.
+ * Type V is the element type.
+ */
+template<typename V>
+class SPSCQueue
+{
+
+public:
+	// ctor
+	SPSCQueue(size_t _capacity);
+
+	// Push an element, returns false if the queue is full (producer thread only)
+	bool TryPush(const V& value);
+
+	// Pop an element, returns false if the queue is empty (consumer thread only)
+	bool TryPop(V& value);
+
+	// Check whether the queue is empty (exact only on the consumer thread)
+	bool IsEmpty() const;
+
+	// Get the capacity of the queue
+	size_t GetCapacity() const;
+
+private:
+	vector<V> slots;
+	size_t mask;
+
+	alignas(CACHE_LINE_SIZE) atomic<size_t> head; // next slot to pop, written by the consumer
+	size_t cachedTail; // consumer's copy of tail
+
+	alignas(CACHE_LINE_SIZE) atomic<size_t> tail; // next slot to push, written by the producer
+	size_t cachedHead; // producer's copy of head
+
+};
+
+template<typename V>
+SPSCQueue<V>::SPSCQueue(size_t _capacity) : head(0), cachedTail(0), tail(0), cachedHead(0)
+{
+	if (_capacity == 0)
+	{
+		throw std::invalid_argument("Queue capacity must be positive");
+	}
+	size_t capacity = 1;
+	while (capacity < _capacity)
+	{
+		capacity <<= 1;
+	}
+	slots.resize(capacity);
+	mask = capacity - 1;
+}
+
+template<typename V>
+bool SPSCQueue<V>::TryPush(const V& value)
+{
+	size_t t = tail.load(memory_order_relaxed);
+	if (t - cachedHead == slots.size())
+	{
+		cachedHead = head.load(memory_order_acquire);
+		if (t - cachedHead == slots.size())
+		{
+			return false;
+		}
+	}
+	slots[t & mask] = value;
+	tail.store(t + 1, memory_order_release);
+	return true;
+}
+
+template<typename V>
+bool SPSCQueue<V>::TryPop(V& value)
+{
+	size_t h = head.load(memory_order_relaxed);
+	if (h == cachedTail)
+	{
+		cachedTail = tail.load(memory_order_acquire);
+		if (h == cachedTail)
+		{
+			return false;
+		}
+	}
+	value = move(slots[h & mask]);
+	head.store(h + 1, memory_order_release);
+	return true;
+}
+
+template<typename V>
+bool SPSCQueue<V>::IsEmpty() const
+{
+	return head.load(memory_order_acquire) == tail.load(memory_order_acquire);
+}
+
+template<typename V>
+size_t SPSCQueue<V>::GetCapacity() const
+{
+	return slots.size();
+}
+
+#endif
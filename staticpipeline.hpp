@@ -0,0 +1,110 @@
+// staticpipeline.hpp
+//
+// Purpose: 1. Defines a pipeline of services composed at compile time.
+// 2. The hops between the stages are direct non-virtual calls the compiler can inline,
+//    in place of one virtual listener call per hop.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef STATIC_PIPELINE_HPP
+#define STATIC_PIPELINE_HPP
+
+#include <tuple>
+#include <span>
+#include "soa.hpp"
+
+using namespace std;
+
+/**
+ * Listener running a fixed chain of services on the data of an upstream service.
+ * Each stage is a service with non-virtual Apply(in) returning its output by reference and
+ * ApplyBatch(span<in>) returning its outputs as a span; the output of a stage is the input of the next.
+ * Register the pipeline on the upstream service in place of the dynamic listeners between its stages:
+ * the upstream service makes one virtual call per event (or batch), the rest of the chain is inlined.
+ * Listeners added to a stage with AddListener() are still notified by that stage as before.
+ * Type V is the data type of the upstream service, Stages are the service types in flow order.
+ */
+template<typename V, typename... Stages>
+class StaticPipeline : public ServiceListener<V>
+{
+
+public:
+	// ctor
+	StaticPipeline(Stages&... _stages);
+
+	// Listener callback to process an add event to the Service, runs the data through every stage
+	void ProcessAdd(V& data) override;
+
+	// Listener callback to process a remove event to the Service
+	void ProcessRemove(V& data) override;
+
+	// Listener callback to process an update event to the Service
+	void ProcessUpdate(V& data) override;
+
+	// Listener callback to process a batch of add events to the Service, runs the batch through every stage
+	void ProcessAddBatch(span<V> batch) override;
+
+private:
+	// Run data through a stage and the stages after it
+	template<typename D, typename Stage, typename... Rest>
+	static void Run(D& data, Stage& stage, Rest&... rest);
+
+	// Run a batch through a stage and the stages after it
+	template<typename D, typename Stage, typename... Rest>
+	static void RunBatch(span<D> batch, Stage& stage, Rest&... rest);
+
+	tuple<Stages&...> stages;
+
+};
+
+template<typename V, typename... Stages>
+StaticPipeline<V, Stages...>::StaticPipeline(Stages&... _stages) : stages(_stages...)
+{
+}
+
+template<typename V, typename... Stages>
+void StaticPipeline<V, Stages...>::ProcessAdd(V& data)
+{
+	apply([&data](Stages&... stage) { Run(data, stage...); }, stages);
+}
+
+template<typename V, typename... Stages>
+void StaticPipeline<V, Stages...>::ProcessRemove(V& data)
+{
+}
+
+template<typename V, typename... Stages>
+void StaticPipeline<V, Stages...>::ProcessUpdate(V& data)
+{
+}
+
+template<typename V, typename... Stages>
+void StaticPipeline<V, Stages...>::ProcessAddBatch(span<V> batch)
+{
+	apply([&batch](Stages&... stage) { RunBatch(batch, stage...); }, stages);
+}
+
+template<typename V, typename... Stages>
+template<typename D, typename Stage, typename... Rest>
+void StaticPipeline<V, Stages...>::Run(D& data, Stage& stage, Rest&... rest)
+{
+	auto& output = stage.Apply(data);
+	if constexpr (sizeof...(Rest) > 0)
+	{
+		Run(output, rest...);
+	}
+}
+
+template<typename V, typename... Stages>
+template<typename D, typename Stage, typename... Rest>
+void StaticPipeline<V, Stages...>::RunBatch(span<D> batch, Stage& stage, Rest&... rest)
+{
+	auto output = stage.ApplyBatch(batch);
+	if constexpr (sizeof...(Rest) > 0)
+	{
+		RunBatch(output, rest...);
+	}
+}
+
+#endif
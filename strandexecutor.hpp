@@ -0,0 +1,276 @@
+// strandexecutor.hpp
+//
+// Purpose: 1. Defines a work-stealing executor of strands: tasks posted under the same key run one at a time in post order.
+// 2. Used to shard the service graph by product, so products are processed in parallel while
+//    the events of each product keep their order.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef STRAND_EXECUTOR_HPP
+#define STRAND_EXECUTOR_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * Executor running tasks on a pool of worker threads, serialised per key.
+ * Keys are mapped onto a fixed number of strands; a strand with pending tasks is queued on its
+ * home worker, and only one worker runs a strand at a time, so tasks of one key never overlap
+ * and run in the order they were posted. Idle workers steal ready strands from the back of the
+ * other workers' queues, which spreads hot keys over the pool while cold keys stay at home.
+ */
+class StrandExecutor
+{
+
+public:
+	// ctor, keys beyond the number of strands share strands (which only costs parallelism)
+	StrandExecutor(size_t _workers, size_t strands = 4096);
+
+	// dtor, runs the remaining tasks and joins the workers
+	~StrandExecutor();
+
+	// Post a task under a key, callable from any thread
+	void Post(size_t key, function<void()> task);
+
+	// Check whether the calling thread is running the strand of a key
+	// a task may then run the next step of the same key inline instead of posting it
+	bool IsRunning(size_t key) const;
+
+	// Block until every task posted so far has run
+	void Drain();
+
+	// Get the number of worker threads
+	size_t GetWorkerCount() const;
+
+private:
+	// tasks of the keys mapped to one strand
+	struct Strand
+	{
+		mutex lock;
+		vector<function<void()>> tasks; // pending tasks, taken by the worker running the strand
+		bool scheduled = false; // queued on a worker or being run
+		size_t home = 0; // worker the strand is queued on when it becomes ready
+	};
+
+	// run queue of one worker
+	struct Worker
+	{
+		mutex lock;
+		deque<Strand*> ready;
+	};
+
+	// Queue a ready strand on a worker and wake a sleeping worker
+	void Schedule(Strand* strand, size_t worker);
+
+	// Take a ready strand, from the own queue first, then from the other workers
+	Strand* Take(size_t worker);
+
+	// Worker thread body
+	void Run(size_t worker);
+
+	vector<unique_ptr<Strand>> strands;
+	vector<unique_ptr<Worker>> workers;
+	vector<thread> threads;
+	size_t mask;
+
+	atomic<size_t> pending; // tasks posted and not yet run
+	atomic<size_t> readyStrands; // strands waiting in run queues
+	atomic<size_t> sleepers; // workers waiting for work
+	atomic<bool> running;
+	mutex sleepLock;
+	condition_variable wake;
+
+	static thread_local const Strand* current; // strand run by this thread
+
+};
+
+thread_local const StrandExecutor::Strand* StrandExecutor::current = nullptr;
+
+StrandExecutor::StrandExecutor(size_t _workers, size_t _strands) :
+	pending(0), readyStrands(0), sleepers(0), running(true)
+{
+	if (_workers == 0 || _strands == 0)
+	{
+		throw std::invalid_argument("Executor needs at least one worker and one strand");
+	}
+	size_t count = 1;
+	while (count < _strands)
+	{
+		count <<= 1;
+	}
+	mask = count - 1;
+
+	for (size_t i = 0; i < _workers; i++)
+	{
+		workers.push_back(make_unique<Worker>());
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		strands.push_back(make_unique<Strand>());
+		strands.back()->home = i % _workers;
+	}
+	for (size_t i = 0; i < _workers; i++)
+	{
+		threads.emplace_back(&StrandExecutor::Run, this, i);
+	}
+}
+
+StrandExecutor::~StrandExecutor()
+{
+	Drain();
+	running.store(false);
+	{
+		lock_guard<mutex> guard(sleepLock);
+	}
+	wake.notify_all();
+	for (auto& worker : threads)
+	{
+		worker.join();
+	}
+}
+
+void StrandExecutor::Post(size_t key, function<void()> task)
+{
+	Strand* strand = strands[key & mask].get();
+	pending.fetch_add(1);
+
+	bool schedule;
+	{
+		lock_guard<mutex> guard(strand->lock);
+		strand->tasks.push_back(move(task));
+		schedule = !strand->scheduled;
+		strand->scheduled = true;
+	}
+	if (schedule)
+	{
+		Schedule(strand, strand->home);
+	}
+}
+
+bool StrandExecutor::IsRunning(size_t key) const
+{
+	return current == strands[key & mask].get();
+}
+
+void StrandExecutor::Drain()
+{
+	while (pending.load() != 0)
+	{
+		this_thread::yield();
+	}
+}
+
+size_t StrandExecutor::GetWorkerCount() const
+{
+	return workers.size();
+}
+
+void StrandExecutor::Schedule(Strand* strand, size_t worker)
+{
+	{
+		lock_guard<mutex> guard(workers[worker]->lock);
+		workers[worker]->ready.push_back(strand);
+	}
+	readyStrands.fetch_add(1);
+
+	// a worker about to sleep either sees the new strand or is woken here
+	if (sleepers.load() > 0)
+	{
+		{
+			lock_guard<mutex> guard(sleepLock);
+		}
+		wake.notify_one();
+	}
+}
+
+StrandExecutor::Strand* StrandExecutor::Take(size_t worker)
+{
+	size_t count = workers.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		// own queue from the front, the others from the back
+		Worker& victim = *workers[(worker + i) % count];
+		lock_guard<mutex> guard(victim.lock);
+		if (!victim.ready.empty())
+		{
+			Strand* strand;
+			if (i == 0)
+			{
+				strand = victim.ready.front();
+				victim.ready.pop_front();
+			}
+			else
+			{
+				strand = victim.ready.back();
+				victim.ready.pop_back();
+			}
+			readyStrands.fetch_sub(1);
+			return strand;
+		}
+	}
+	return nullptr;
+}
+
+void StrandExecutor::Run(size_t worker)
+{
+	vector<function<void()>> batch;
+	while (true)
+	{
+		Strand* strand = Take(worker);
+		if (strand == nullptr)
+		{
+			unique_lock<mutex> guard(sleepLock);
+			sleepers.fetch_add(1);
+			if (readyStrands.load() == 0 && running.load())
+			{
+				wake.wait_for(guard, chrono::milliseconds(10));
+			}
+			sleepers.fetch_sub(1);
+			if (!running.load() && readyStrands.load() == 0)
+			{
+				return;
+			}
+			continue;
+		}
+
+		// take everything pending on the strand and run it outside the lock
+		{
+			lock_guard<mutex> guard(strand->lock);
+			batch.swap(strand->tasks);
+		}
+		current = strand;
+		for (auto& task : batch)
+		{
+			task();
+		}
+		current = nullptr;
+		size_t done = batch.size();
+		batch.clear();
+
+		// tasks posted meanwhile put the strand back at the end of this worker's queue
+		bool again;
+		{
+			lock_guard<mutex> guard(strand->lock);
+			again = !strand->tasks.empty();
+			strand->scheduled = again;
+		}
+		if (again)
+		{
+			Schedule(strand, worker);
+		}
+		pending.fetch_sub(done);
+	}
+}
+
+#endif
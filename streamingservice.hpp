@@ -43,6 +43,9 @@ public:
     // Get data on our service given a key
     PriceStream<T>& GetData(string key) override;
 
+    // Get data on our service given a product handle
+    PriceStream<T>& GetData(ProductHandle handle);
+
     // The callback that a Connector should invoke for any new or updated data
     void OnMessage(PriceStream<T>& data) override;
 
@@ -63,31 +66,40 @@ public:
 
     // called by streaming service listener to subscribe data from algo streaming service
     void AddPriceStream(const AlgoStream<T>& algoStream);
+
+    // called by streaming service listener to subscribe a batch of data from algo streaming service
+    void AddPriceStreamBatch(span<AlgoStream<T>> algoStreams);
+
+    // Static pipeline stage (see staticpipeline.hpp): add and publish the price stream of an algo stream and return it
+    PriceStream<T>& Apply(const AlgoStream<T>& algoStream);
+
+    // Static pipeline stage: add and publish the price streams of a batch of algo streams and return them
+    span<PriceStream<T>> ApplyBatch(span<AlgoStream<T>> algoStreams);
 private:
-    map<string, PriceStream<T>> priceStreamData; // store price stream data keyed by product identifier
+    ProductStore<PriceStream<T>> priceStreamData; // store price stream data keyed by product handle
     vector<ServiceListener<PriceStream<T>>*> listeners; // list of listeners to this service
     StreamingServiceConnector<T>* connector; // connector related to this server
     StreamingServiceListener<T>* streamingservicelistener; // listener related to this server
+    vector<PriceStream<T>> batch; // price streams of the batch being added
 
 };
 
 template<typename T>
-StreamingService<T>::StreamingService() : streamingservicelistener(new StreamingServiceListener<T>(this))
+StreamingService<T>::StreamingService() : connector(new StreamingServiceConnector<T>(this)), streamingservicelistener(new StreamingServiceListener<T>(this))
 {
+  priceStreamData.Reserve(ProductRegistry<T>::Instance().GetSize());
 }
 
 template<typename T>
 PriceStream<T>& StreamingService<T>::GetData(string key)
 {
-    auto it = priceStreamData.find(key);
-    if (it != priceStreamData.end())
-    {
-        return it->second;
-    }
-    else
-    {
-        throw std::runtime_error("Key not found");
-    }
+    return GetData(ProductRegistry<T>::Instance().GetHandle(key));
+}
+
+template<typename T>
+PriceStream<T>& StreamingService<T>::GetData(ProductHandle handle)
+{
+    return priceStreamData.Get(handle);
 }
 
 /**
@@ -134,14 +146,9 @@ void StreamingService<T>::PublishPrice(const PriceStream<T>& priceStream)
 template<typename T>
 void StreamingService<T>::AddPriceStream(const AlgoStream<T>& algoStream)
 {
-  PriceStream<T> priceStream = algoStream.GetPriceStream();
-  string key = priceStream.GetProduct().GetProductId();
-  // update the price stream map
-  if (priceStreamData.find(key) != priceStreamData.end()) 
-  {
-      priceStreamData.erase(key);
-  }
-  priceStreamData.insert(pair<string, PriceStream<T> > (key, priceStream));
+  const PriceStream<T>& stream = algoStream.GetPriceStream();
+  // update the price stream store in place
+  PriceStream<T>& priceStream = priceStreamData.Put(stream.GetProductHandle(), stream);
 
   // flow the data to listeners
   for (auto& l : listeners) {
@@ -149,6 +156,41 @@ void StreamingService<T>::AddPriceStream(const AlgoStream<T>& algoStream)
   }
 }
 
+// called by streaming service listener to subscribe a batch of data from algo streaming service
+template<typename T>
+void StreamingService<T>::AddPriceStreamBatch(span<AlgoStream<T>> algoStreams)
+{
+  batch.clear();
+  for (auto& algoStream : algoStreams) {
+      const PriceStream<T>& stream = algoStream.GetPriceStream();
+      batch.push_back(priceStreamData.Put(stream.GetProductHandle(), stream));
+  }
+
+  // flow the whole batch to listeners
+  for (auto& l : listeners) {
+      l -> ProcessAddBatch(span<PriceStream<T>>(batch));
+  }
+}
+
+// save the price stream of an algo stream, then call the connector to publish it
+template<typename T>
+PriceStream<T>& StreamingService<T>::Apply(const AlgoStream<T>& algoStream)
+{
+  AddPriceStream(algoStream);
+  PublishPrice(algoStream.GetPriceStream());
+  return priceStreamData.Get(algoStream.GetPriceStream().GetProductHandle());
+}
+
+template<typename T>
+span<PriceStream<T>> StreamingService<T>::ApplyBatch(span<AlgoStream<T>> algoStreams)
+{
+  AddPriceStreamBatch(algoStreams);
+  for (auto& algoStream : algoStreams) {
+      PublishPrice(algoStream.GetPriceStream());
+  }
+  return span<PriceStream<T>>(batch);
+}
+
 /**
  * StreamingServiceConnector: publish data to streaming service.
  * Type T is the product type.
@@ -158,6 +200,7 @@ class StreamingServiceConnector : public Connector<PriceStream<T>>
 {
 private:
   StreamingService<T>* service;
+  SampledSink console; // sampled console output of the streams
 
 public:
   // ctor
@@ -166,33 +209,43 @@ public:
   ~StreamingServiceConnector()=default;
 
   // Publish data to the Connector
+  void Publish(PriceStream<T>& data) override;
+
+  // Publish a price stream
   void Publish(const PriceStream<T>& data);
 
 };
 
 template<typename T>
-StreamingServiceConnector<T>::StreamingServiceConnector(StreamingService<T>* _service)
+StreamingServiceConnector<T>::StreamingServiceConnector(StreamingService<T>* _service) :
+  console("Price Stream (Product {}): \n"
+    "\tBid\tPrice: {}\tVisibleQuantity: {}\tHiddenQuantity: {}\n"
+    "\tAsk\tPrice: {}\tVisibleQuantity: {}\tHiddenQuantity: {}\n")
 {
   service = _service;
 }
 
+template<typename T>
+void StreamingServiceConnector<T>::Publish(PriceStream<T>& data)
+{
+  Publish(static_cast<const PriceStream<T>&>(data));
+}
+
 /**
  * Publish() method is used by the publish-only connector to publish streams.
  */
 template<typename T>
 void StreamingServiceConnector<T>::Publish(const PriceStream<T>& data)
 {
+  if (!console.Sample()) return;
+
   // print the price stream data
-  T product = data.GetProduct();
-  string productId = product.GetProductId();
-  PriceStreamOrder bid = data.GetBidOrder();
-  PriceStreamOrder offer = data.GetOfferOrder();
+  const string& productId = data.GetProduct().GetProductId();
+  const PriceStreamOrder& bid = data.GetBidOrder();
+  const PriceStreamOrder& offer = data.GetOfferOrder();
 
-  cout << "Price Stream " << "(Product " << productId << "): \n"
-      <<"\tBid\t"<<"Price: "<<bid.GetPrice()<<"\tVisibleQuantity: "<<bid.GetVisibleQuantity()
-      <<"\tHiddenQuantity: "<<bid.GetHiddenQuantity()<<"\n"
-      <<"\tAsk\t"<<"Price: "<<offer.GetPrice()<<"\tVisibleQuantity: "<<offer.GetVisibleQuantity()
-      <<"\tHiddenQuantity: "<<offer.GetHiddenQuantity()<<"\n";
+  console.Print(productId, bid.GetPrice(), bid.GetVisibleQuantity(), bid.GetHiddenQuantity(),
+      offer.GetPrice(), offer.GetVisibleQuantity(), offer.GetHiddenQuantity());
 }
 
 /**
@@ -218,6 +271,9 @@ public:
   // Listener callback to process an update event to the Service
   void ProcessUpdate(AlgoStream<T>& data) override;
 
+  // Listener callback to process a batch of add events to the Service
+  void ProcessAddBatch(span<AlgoStream<T>> batch) override;
+
 };
 
 template<typename T>
@@ -233,13 +289,15 @@ StreamingServiceListener<T>::StreamingServiceListener(StreamingService<T>* _stre
 template<typename T>
 void StreamingServiceListener<T>::ProcessAdd(AlgoStream<T>& data)
 {
-  // save algo stream info into streaming service
+  // save algo stream info into streaming service and call the connector to publish price streams
   // directly pass in AlgoStream<T> type and transit to PriceStream<T> type inside the function
-  streamingService->AddPriceStream(data);
+  streamingService->Apply(data);
+}
 
-  // call the connector to publish price streams
-  PriceStream<T> priceStream = data.GetPriceStream();
-  streamingService->PublishPrice(priceStream);
+template<typename T>
+void StreamingServiceListener<T>::ProcessAddBatch(span<AlgoStream<T>> batch)
+{
+  streamingService->ApplyBatch(batch);
 }
 
 template<typename T>
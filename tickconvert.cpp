@@ -0,0 +1,42 @@
+// tickconvert.cpp
+//
+// Purpose: 1. Converts price and order book CSV files into binary tick files (see tickfile.hpp).
+// 2. Usage: tickconvert prices|marketdata <input csv> <output tick file>
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <filesystem>
+
+#include "utilities.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+int main(int argc, char* argv[])
+{
+	string kind = argc > 1 ? argv[1] : "";
+	if (argc != 4 || (kind != "prices" && kind != "marketdata"))
+	{
+		cout << "Usage: tickconvert prices|marketdata <input csv> <output tick file>" << endl;
+		return 1;
+	}
+
+	try
+	{
+		auto start = steady_clock::now();
+		convertTicks(argv[2], argv[3], kind == "prices" ? PRICE_TICKS : BOOK_TICKS);
+		double elapsed = duration<double>(steady_clock::now() - start).count();
+		log(LogLevel::INFO, "Converted " + string(argv[2]) + " (" + to_string(filesystem::file_size(argv[2])) + " bytes) into "
+			+ string(argv[3]) + " (" + to_string(filesystem::file_size(argv[3])) + " bytes) in " + to_string(elapsed) + " s.");
+	}
+	catch (const exception& e)
+	{
+		log(LogLevel::ERROR, e.what());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,455 @@
+// tickfile.hpp
+//
+// Purpose: 1. Defines a binary columnar file format for price and order book ticks.
+// 2. A file is a header, a product table and blocks of up to TICK_BLOCK_ROWS ticks of one product,
+//    each block storing its fields column by column: int64 ns timestamps, fixed-point prices in
+//    ticks of 1/256, int64 sizes and a fixed number of book levels.
+// 3. Defines the builder that encodes ticks into blocks, and the reader that iterates the blocks of a
+//    memory-mapped file in place, without parsing or copying.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef TICK_FILE_HPP
+#define TICK_FILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include "csvreader.hpp"
+
+using namespace std;
+
+// First bytes of every tick file
+const char TICK_FILE_MAGIC[8] = { 'T', 'S', 'T', 'I', 'C', 'K', 'S', '1' };
+
+// Version of the layout below
+const uint32_t TICK_FILE_VERSION = 1;
+
+// Bytes per product identifier in the product table, zero padded
+const size_t TICK_PRODUCT_ID_SIZE = 16;
+
+// Largest number of ticks in one block
+const uint32_t TICK_BLOCK_ROWS = 4096;
+
+// Kind of ticks in a file
+enum TickKind : uint32_t { PRICE_TICKS = 0, BOOK_TICKS = 1 };
+
+// Output format of the market data generator
+enum TickFormat { CSV_TICKS, BINARY_TICKS };
+
+/**
+ * File header, followed by productCount product identifiers of TICK_PRODUCT_ID_SIZE bytes.
+ * All integers are little endian.
+ */
+struct TickFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t kind; // a TickKind
+	uint32_t depth; // book levels per side, 0 for prices
+	uint32_t productCount;
+	uint64_t reserved[5];
+};
+
+/**
+ * Block header, followed by the columns of the block, each padded to a multiple of 8 bytes:
+ * prices: timestamp[rows] int64, bid[rows] int32, ask[rows] int32
+ * books: timestamp[rows] int64, then per level bid[rows] int32, bidSize[rows] int64, ask[rows] int32, askSize[rows] int64
+ */
+struct TickBlockHeader
+{
+	uint32_t rows;
+	uint32_t product; // index into the product table
+};
+
+static_assert(sizeof(TickFileHeader) == 64, "tick file header must be 64 bytes");
+static_assert(sizeof(TickBlockHeader) == 8, "tick block header must be 8 bytes");
+
+// Get the size in bytes of a column of rows values of a type, padded to 8 bytes
+template<typename V>
+size_t TickColumnSize(uint32_t rows)
+{
+	return (rows * sizeof(V) + 7) / 8 * 8;
+}
+
+// Append the header and the product table of a tick file
+void EncodeTickFileHeader(string& out, TickKind kind, uint32_t depth, const vector<string>& products)
+{
+	TickFileHeader header = {};
+	memcpy(header.magic, TICK_FILE_MAGIC, sizeof(header.magic));
+	header.version = TICK_FILE_VERSION;
+	header.kind = kind;
+	header.depth = depth;
+	header.productCount = static_cast<uint32_t>(products.size());
+	out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const auto& product : products)
+	{
+		if (product.size() > TICK_PRODUCT_ID_SIZE)
+		{
+			throw std::invalid_argument("Product identifier too long for a tick file: " + product);
+		}
+		char id[TICK_PRODUCT_ID_SIZE] = {};
+		memcpy(id, product.data(), product.size());
+		out.append(id, TICK_PRODUCT_ID_SIZE);
+	}
+}
+
+/**
+ * Collects the ticks of one product column by column and encodes them as blocks.
+ */
+class TickBlockBuilder
+{
+
+public:
+	// ctor
+	TickBlockBuilder(TickKind _kind, uint32_t _depth, uint32_t _product);
+
+	// Add a price tick
+	void AddPrice(int64_t timestamp, int32_t bid, int32_t ask);
+
+	// Add an order book tick with depth levels per side
+	void AddBook(int64_t timestamp, const int32_t* bids, const int64_t* bidSizes, const int32_t* asks, const int64_t* askSizes);
+
+	// Get the number of ticks collected since the last block
+	uint32_t GetRows() const;
+
+	// Start collecting the ticks of another product, dropping the ticks not encoded yet
+	void Reset(uint32_t _product);
+
+	// Append a block with the collected ticks and start the next one (nothing if there are none)
+	void Encode(string& out);
+
+private:
+	// Append a column, padded to 8 bytes
+	template<typename V>
+	static void AppendColumn(string& out, const V* values, uint32_t rows);
+
+	TickKind kind;
+	uint32_t depth;
+	uint32_t product;
+	vector<int64_t> timestamps;
+	vector<int32_t> bids; // level-major for books: bids[level * TICK_BLOCK_ROWS + row]
+	vector<int32_t> asks;
+	vector<int64_t> bidSizes;
+	vector<int64_t> askSizes;
+
+};
+
+TickBlockBuilder::TickBlockBuilder(TickKind _kind, uint32_t _depth, uint32_t _product) :
+	kind(_kind), depth(_kind == PRICE_TICKS ? 1 : _depth), product(_product)
+{
+	timestamps.reserve(TICK_BLOCK_ROWS);
+	bids.resize(depth * TICK_BLOCK_ROWS);
+	asks.resize(depth * TICK_BLOCK_ROWS);
+	if (kind == BOOK_TICKS)
+	{
+		bidSizes.resize(depth * TICK_BLOCK_ROWS);
+		askSizes.resize(depth * TICK_BLOCK_ROWS);
+	}
+}
+
+void TickBlockBuilder::AddPrice(int64_t timestamp, int32_t bid, int32_t ask)
+{
+	uint32_t row = GetRows();
+	timestamps.push_back(timestamp);
+	bids[row] = bid;
+	asks[row] = ask;
+}
+
+void TickBlockBuilder::AddBook(int64_t timestamp, const int32_t* levelBids, const int64_t* levelBidSizes, const int32_t* levelAsks, const int64_t* levelAskSizes)
+{
+	uint32_t row = GetRows();
+	timestamps.push_back(timestamp);
+	for (uint32_t level = 0; level < depth; level++)
+	{
+		bids[level * TICK_BLOCK_ROWS + row] = levelBids[level];
+		bidSizes[level * TICK_BLOCK_ROWS + row] = levelBidSizes[level];
+		asks[level * TICK_BLOCK_ROWS + row] = levelAsks[level];
+		askSizes[level * TICK_BLOCK_ROWS + row] = levelAskSizes[level];
+	}
+}
+
+uint32_t TickBlockBuilder::GetRows() const
+{
+	return static_cast<uint32_t>(timestamps.size());
+}
+
+void TickBlockBuilder::Reset(uint32_t _product)
+{
+	product = _product;
+	timestamps.clear();
+}
+
+void TickBlockBuilder::Encode(string& out)
+{
+	uint32_t rows = GetRows();
+	if (rows == 0)
+	{
+		return;
+	}
+
+	TickBlockHeader header = { rows, product };
+	out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+	AppendColumn(out, timestamps.data(), rows);
+	if (kind == PRICE_TICKS)
+	{
+		AppendColumn(out, bids.data(), rows);
+		AppendColumn(out, asks.data(), rows);
+	}
+	else
+	{
+		for (uint32_t level = 0; level < depth; level++)
+		{
+			AppendColumn(out, bids.data() + level * TICK_BLOCK_ROWS, rows);
+			AppendColumn(out, bidSizes.data() + level * TICK_BLOCK_ROWS, rows);
+			AppendColumn(out, asks.data() + level * TICK_BLOCK_ROWS, rows);
+			AppendColumn(out, askSizes.data() + level * TICK_BLOCK_ROWS, rows);
+		}
+	}
+	timestamps.clear();
+}
+
+template<typename V>
+void TickBlockBuilder::AppendColumn(string& out, const V* values, uint32_t rows)
+{
+	size_t size = rows * sizeof(V);
+	out.append(reinterpret_cast<const char*>(values), size);
+	out.append(TickColumnSize<V>(rows) - size, '\0');
+}
+
+/**
+ * View of one block of a mapped tick file, valid as long as its reader.
+ * Columns are read in place; level 0 of a price block holds its bid and ask.
+ */
+class TickBlock
+{
+
+public:
+	// ctor, an empty block
+	TickBlock();
+
+	// ctor, the block whose columns start at columns
+	TickBlock(const TickBlockHeader& header, const char* _columns, TickKind _kind);
+
+	// Get the number of ticks in the block
+	uint32_t GetRows() const;
+
+	// Get the index of the product of the block in the product table
+	uint32_t GetProduct() const;
+
+	// Get the timestamps of the ticks, in nanoseconds since the epoch
+	const int64_t* GetTimestamps() const;
+
+	// Get the bid prices of a level, in ticks of 1/256
+	const int32_t* GetBids(uint32_t level) const;
+
+	// Get the ask prices of a level, in ticks of 1/256
+	const int32_t* GetAsks(uint32_t level) const;
+
+	// Get the bid sizes of a level (books only)
+	const int64_t* GetBidSizes(uint32_t level) const;
+
+	// Get the ask sizes of a level (books only)
+	const int64_t* GetAskSizes(uint32_t level) const;
+
+	// Get the size in bytes of the columns of a block
+	static size_t ColumnsSize(TickKind kind, uint32_t depth, uint32_t rows);
+
+private:
+	// Get a column of the block at a byte offset from its first column
+	template<typename V>
+	const V* Column(size_t offset) const;
+
+	// Get the byte offset of the first column of a level
+	size_t LevelOffset(uint32_t level) const;
+
+	uint32_t rows;
+	uint32_t product;
+	TickKind kind;
+	const char* columns;
+
+};
+
+TickBlock::TickBlock() : rows(0), product(0), kind(PRICE_TICKS), columns(nullptr)
+{
+}
+
+TickBlock::TickBlock(const TickBlockHeader& header, const char* _columns, TickKind _kind) :
+	rows(header.rows), product(header.product), kind(_kind), columns(_columns)
+{
+}
+
+uint32_t TickBlock::GetRows() const
+{
+	return rows;
+}
+
+uint32_t TickBlock::GetProduct() const
+{
+	return product;
+}
+
+const int64_t* TickBlock::GetTimestamps() const
+{
+	return Column<int64_t>(0);
+}
+
+const int32_t* TickBlock::GetBids(uint32_t level) const
+{
+	return Column<int32_t>(LevelOffset(level));
+}
+
+const int32_t* TickBlock::GetAsks(uint32_t level) const
+{
+	size_t offset = LevelOffset(level) + TickColumnSize<int32_t>(rows);
+	if (kind == BOOK_TICKS)
+	{
+		offset += TickColumnSize<int64_t>(rows);
+	}
+	return Column<int32_t>(offset);
+}
+
+const int64_t* TickBlock::GetBidSizes(uint32_t level) const
+{
+	return Column<int64_t>(LevelOffset(level) + TickColumnSize<int32_t>(rows));
+}
+
+const int64_t* TickBlock::GetAskSizes(uint32_t level) const
+{
+	return Column<int64_t>(LevelOffset(level) + 2 * TickColumnSize<int32_t>(rows) + TickColumnSize<int64_t>(rows));
+}
+
+size_t TickBlock::ColumnsSize(TickKind kind, uint32_t depth, uint32_t rows)
+{
+	if (kind == PRICE_TICKS)
+	{
+		return TickColumnSize<int64_t>(rows) + 2 * TickColumnSize<int32_t>(rows);
+	}
+	return TickColumnSize<int64_t>(rows) + depth * (2 * TickColumnSize<int32_t>(rows) + 2 * TickColumnSize<int64_t>(rows));
+}
+
+template<typename V>
+const V* TickBlock::Column(size_t offset) const
+{
+	// the mapping is page aligned and every column is padded to 8 bytes, so columns are aligned in place
+	return reinterpret_cast<const V*>(columns + offset);
+}
+
+size_t TickBlock::LevelOffset(uint32_t level) const
+{
+	return TickColumnSize<int64_t>(rows) + level * (2 * TickColumnSize<int32_t>(rows) + 2 * TickColumnSize<int64_t>(rows));
+}
+
+/**
+ * Reader of a tick file mapped into memory.
+ * The header and the product table are checked once; NextBlock() then walks the blocks in file order,
+ * checking only that each fits in the file and names a product of the table.
+ */
+class TickFileReader
+{
+
+public:
+	// ctor, maps the file and checks its header (throws if the file cannot be mapped or is not a tick file)
+	TickFileReader(const string& _path);
+
+	// Get the kind of ticks in the file
+	TickKind GetKind() const;
+
+	// Get the number of book levels per side, 0 for prices
+	uint32_t GetDepth() const;
+
+	// Get the product identifiers of the product table, in index order
+	const vector<string>& GetProducts() const;
+
+	// Advance to the next block, returns false at the end of the file (throws if the block is invalid or truncated)
+	bool NextBlock(TickBlock& block);
+
+private:
+	string path;
+	MappedFile file;
+	TickKind kind;
+	uint32_t depth;
+	vector<string> products;
+	size_t offset; // of the next block
+
+};
+
+TickFileReader::TickFileReader(const string& _path) : path(_path), file(_path), offset(0)
+{
+	TickFileHeader header;
+	if (file.GetSize() < sizeof(header))
+	{
+		throw std::runtime_error("Invalid tick file: " + path);
+	}
+	memcpy(&header, file.GetData(), sizeof(header));
+	if (memcmp(header.magic, TICK_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != TICK_FILE_VERSION
+		|| header.kind > BOOK_TICKS || (header.kind == BOOK_TICKS && header.depth == 0))
+	{
+		throw std::runtime_error("Invalid tick file: " + path);
+	}
+	kind = static_cast<TickKind>(header.kind);
+	depth = header.depth;
+
+	offset = sizeof(header);
+	if ((file.GetSize() - offset) / TICK_PRODUCT_ID_SIZE < header.productCount)
+	{
+		throw std::runtime_error("Invalid tick file: " + path);
+	}
+	products.reserve(header.productCount);
+	for (uint32_t i = 0; i < header.productCount; i++)
+	{
+		const char* id = file.GetData() + offset;
+		products.emplace_back(id, strnlen(id, TICK_PRODUCT_ID_SIZE));
+		offset += TICK_PRODUCT_ID_SIZE;
+	}
+}
+
+TickKind TickFileReader::GetKind() const
+{
+	return kind;
+}
+
+uint32_t TickFileReader::GetDepth() const
+{
+	return depth;
+}
+
+const vector<string>& TickFileReader::GetProducts() const
+{
+	return products;
+}
+
+bool TickFileReader::NextBlock(TickBlock& block)
+{
+	size_t size = file.GetSize();
+	if (offset == size)
+	{
+		return false;
+	}
+
+	TickBlockHeader header;
+	if (size - offset < sizeof(header))
+	{
+		throw std::runtime_error("Truncated tick file: " + path);
+	}
+	memcpy(&header, file.GetData() + offset, sizeof(header));
+	size_t columnsSize = TickBlock::ColumnsSize(kind, depth, header.rows);
+	if (header.rows == 0 || header.rows > TICK_BLOCK_ROWS || header.product >= products.size())
+	{
+		throw std::runtime_error("Invalid tick block in file: " + path);
+	}
+	if (size - offset - sizeof(header) < columnsSize)
+	{
+		throw std::runtime_error("Truncated tick file: " + path);
+	}
+
+	block = TickBlock(header, file.GetData() + offset + sizeof(header), kind);
+	offset += sizeof(header) + columnsSize;
+	return true;
+}
+
+#endif
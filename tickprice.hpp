@@ -0,0 +1,84 @@
+// tickprice.hpp
+//
+// Purpose: 1. Defines an integer fixed-point price counted in ticks of 1/256 of a point.
+// 2. Treasury prices are quoted to 1/256, so tick prices compare and aggregate exactly.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef TICK_PRICE_HPP
+#define TICK_PRICE_HPP
+
+#include <cmath>
+#include <compare>
+
+using namespace std;
+
+// Number of ticks in one point of price
+const long TICKS_PER_POINT = 256;
+
+/**
+ * A price as an integer number of 1/256 ticks.
+ * Conversion to and from double is only meant for the edges of the system.
+ */
+class TickPrice
+{
+
+public:
+	// default ctor, a zero price
+	TickPrice() = default;
+
+	// ctor from a number of ticks
+	explicit TickPrice(long _ticks);
+
+	// Get the nearest tick price to a decimal price
+	static TickPrice FromDouble(double price);
+
+	// Get the number of ticks
+	long GetTicks() const;
+
+	// Get the decimal price
+	double ToDouble() const;
+
+	// Exact integer comparisons
+	auto operator<=>(const TickPrice& other) const = default;
+
+	// Tick arithmetic
+	TickPrice operator+(const TickPrice& other) const;
+	TickPrice operator-(const TickPrice& other) const;
+
+private:
+	long ticks = 0;
+
+};
+
+TickPrice::TickPrice(long _ticks) : ticks(_ticks)
+{
+}
+
+TickPrice TickPrice::FromDouble(double price)
+{
+	return TickPrice(lround(price * TICKS_PER_POINT));
+}
+
+long TickPrice::GetTicks() const
+{
+	return ticks;
+}
+
+double TickPrice::ToDouble() const
+{
+	return static_cast<double>(ticks) / TICKS_PER_POINT;
+}
+
+TickPrice TickPrice::operator+(const TickPrice& other) const
+{
+	return TickPrice(ticks + other.ticks);
+}
+
+TickPrice TickPrice::operator-(const TickPrice& other) const
+{
+	return TickPrice(ticks - other.ticks);
+}
+
+#endif
@@ -0,0 +1,478 @@
+// timerwheel.hpp
+//
+// Purpose: 1. Defines a clock read from memory, refreshed by a background thread every millisecond.
+// 2. Defines a hierarchical timer wheel and the timer service that runs its callbacks,
+//    so services can throttle, conflate and act on time without reading the clock per event.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <vector>
+#include <array>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+// Identifier of a scheduled timer, 0 is never a valid timer
+typedef uint64_t TimerId;
+
+/**
+ * Coarse clock of the process.
+ * A background thread stores the monotonic and the wall clock time every millisecond, so a read is
+ * one atomic load instead of a clock call. Readings are at most about a millisecond old.
+ */
+class CachedClock
+{
+
+public:
+	// Get the clock of the process, starting its thread on first use
+	static CachedClock& Instance();
+
+	// dtor, stops the clock thread
+	~CachedClock();
+
+	// Get the monotonic time in milliseconds
+	int64_t GetMillis() const;
+
+	// Get the wall clock time
+	chrono::system_clock::time_point GetWallTime() const;
+
+private:
+	// ctor
+	CachedClock();
+
+	// Read the clocks into the cache
+	void Update();
+
+	// Clock thread body
+	void Run();
+
+	atomic<int64_t> millis; // steady clock, milliseconds
+	atomic<int64_t> wallNanos; // system clock, nanoseconds since the epoch
+	atomic<bool> running;
+	mutex lock;
+	condition_variable wake;
+	thread ticker;
+
+};
+
+CachedClock& CachedClock::Instance()
+{
+	static CachedClock clock;
+	return clock;
+}
+
+CachedClock::CachedClock() : millis(0), wallNanos(0), running(true)
+{
+	Update();
+	ticker = thread(&CachedClock::Run, this);
+}
+
+CachedClock::~CachedClock()
+{
+	{
+		lock_guard<mutex> guard(lock);
+		running.store(false);
+	}
+	wake.notify_one();
+	ticker.join();
+}
+
+int64_t CachedClock::GetMillis() const
+{
+	return millis.load(memory_order_relaxed);
+}
+
+chrono::system_clock::time_point CachedClock::GetWallTime() const
+{
+	return chrono::system_clock::time_point(chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(wallNanos.load(memory_order_relaxed))));
+}
+
+void CachedClock::Update()
+{
+	millis.store(chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count(), memory_order_relaxed);
+	wallNanos.store(chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count(), memory_order_relaxed);
+}
+
+void CachedClock::Run()
+{
+	unique_lock<mutex> guard(lock);
+	while (!wake.wait_for(guard, chrono::milliseconds(1), [this]() { return !running.load(); }))
+	{
+		Update();
+	}
+}
+
+/**
+ * Hierarchical timer wheel with a resolution of one tick.
+ * Four levels of 64 slots cover 64, 4096, 262144 and 16777216 ticks; a timer goes into the
+ * coarsest level it fits and moves down a level each time the finer wheel wraps around, until it
+ * fires from the finest level. Adding and removing a timer is constant time, and advancing costs one
+ * slot per tick plus the timers that fire or move. Timers further out than the wheel covers wait in the
+ * last level and are placed again when it comes round. Not thread safe, see TimerService.
+ */
+class TimerWheel
+{
+
+public:
+	static const int LEVELS = 4;
+	static const int SLOT_BITS = 6;
+	static const int SLOTS = 1 << SLOT_BITS;
+
+	// ctor, the wheel starts at a tick
+	TimerWheel(int64_t _now = 0);
+
+	// Add a timer firing at a tick, a tick already passed fires on the next advance
+	TimerId Add(int64_t expiry, function<void()> callback);
+
+	// Remove a timer, returns false if it already fired or was removed
+	bool Remove(TimerId id);
+
+	// Advance the wheel to a tick, moving the callbacks of the timers due by then into expired
+	void Advance(int64_t now, vector<function<void()>>& expired);
+
+	// Get the tick the wheel is at
+	int64_t GetNow() const;
+
+	// Get the number of pending timers
+	size_t GetSize() const;
+
+private:
+	static constexpr uint32_t NIL = UINT32_MAX;
+
+	// a pending timer, linked into the list of its slot
+	struct Node
+	{
+		int64_t expiry = 0;
+		function<void()> callback;
+		uint32_t prev = NIL;
+		uint32_t next = NIL;
+		uint32_t generation = 1; // bumped when the node is freed, so stale ids do not match
+		int slot = -1; // -1 when free
+	};
+
+	// Link a node into the slot of its expiry, not before tick earliest
+	void Link(uint32_t index, int64_t earliest);
+
+	// Unlink a node from its slot
+	void Unlink(uint32_t index);
+
+	// Move the timers of a slot to the finer levels
+	void Cascade(int level, int slot);
+
+	vector<Node> nodes;
+	vector<uint32_t> freeNodes;
+	array<uint32_t, LEVELS * SLOTS> heads;
+	array<size_t, LEVELS> levelSizes; // timers per level, lets Advance skip empty stretches
+	int64_t now;
+	size_t size;
+
+};
+
+TimerWheel::TimerWheel(int64_t _now) : now(_now), size(0)
+{
+	heads.fill(NIL);
+	levelSizes.fill(0);
+}
+
+TimerId TimerWheel::Add(int64_t expiry, function<void()> callback)
+{
+	uint32_t index;
+	if (freeNodes.empty())
+	{
+		index = static_cast<uint32_t>(nodes.size());
+		nodes.emplace_back();
+	}
+	else
+	{
+		index = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	Node& node = nodes[index];
+	node.expiry = expiry;
+	node.callback = move(callback);
+	Link(index, now + 1);
+	size++;
+	return (static_cast<TimerId>(node.generation) << 32) | index;
+}
+
+bool TimerWheel::Remove(TimerId id)
+{
+	uint32_t index = static_cast<uint32_t>(id);
+	if (index >= nodes.size() || nodes[index].generation != static_cast<uint32_t>(id >> 32) || nodes[index].slot < 0)
+	{
+		return false;
+	}
+	Unlink(index);
+	nodes[index].callback = nullptr;
+	nodes[index].generation++;
+	freeNodes.push_back(index);
+	size--;
+	return true;
+}
+
+void TimerWheel::Advance(int64_t _now, vector<function<void()>>& expired)
+{
+	if (size == 0)
+	{
+		now = _now > now ? _now : now;
+		return;
+	}
+	while (now < _now)
+	{
+		// nothing fires or moves before the next wrap of the finest level holding timers, skip to it
+		int lowest = 0;
+		while (levelSizes[lowest] == 0)
+		{
+			lowest++;
+		}
+		int64_t wrap = int64_t(1) << (SLOT_BITS * lowest);
+		int64_t skip = ((now + wrap) & ~(wrap - 1)) - 1;
+		if (lowest > 0 && skip > now)
+		{
+			now = skip < _now ? skip : _now;
+			continue;
+		}
+		now++;
+
+		// when a level wraps around, the next slot of the level above comes due
+		for (int level = 1; level < LEVELS; level++)
+		{
+			if ((now & ((int64_t(1) << (SLOT_BITS * level)) - 1)) != 0)
+			{
+				break;
+			}
+			Cascade(level, static_cast<int>((now >> (SLOT_BITS * level)) & (SLOTS - 1)));
+		}
+
+		int slot = static_cast<int>(now & (SLOTS - 1));
+		uint32_t index = heads[slot];
+		heads[slot] = NIL;
+		while (index != NIL)
+		{
+			Node& node = nodes[index];
+			uint32_t next = node.next;
+			levelSizes[0]--;
+			if (node.expiry > now)
+			{
+				// only a timer beyond the reach of the wheel can come back early
+				Link(index, now);
+			}
+			else
+			{
+				node.slot = -1;
+				expired.push_back(move(node.callback));
+				node.callback = nullptr;
+				node.generation++;
+				freeNodes.push_back(index);
+				size--;
+			}
+			index = next;
+		}
+		if (size == 0)
+		{
+			now = _now;
+		}
+	}
+}
+
+int64_t TimerWheel::GetNow() const
+{
+	return now;
+}
+
+size_t TimerWheel::GetSize() const
+{
+	return size;
+}
+
+void TimerWheel::Link(uint32_t index, int64_t earliest)
+{
+	Node& node = nodes[index];
+	int64_t expiry = node.expiry < earliest ? earliest : node.expiry;
+	int64_t delta = expiry - now;
+
+	int level = 0;
+	while (level < LEVELS - 1 && delta >= (int64_t(1) << (SLOT_BITS * (level + 1))))
+	{
+		level++;
+	}
+	int64_t span = int64_t(1) << (SLOT_BITS * LEVELS);
+	if (delta >= span)
+	{
+		expiry = now + span - 1;
+	}
+
+	int slot = level * SLOTS + static_cast<int>((expiry >> (SLOT_BITS * level)) & (SLOTS - 1));
+	node.slot = slot;
+	levelSizes[level]++;
+	node.prev = NIL;
+	node.next = heads[slot];
+	if (node.next != NIL)
+	{
+		nodes[node.next].prev = index;
+	}
+	heads[slot] = index;
+}
+
+void TimerWheel::Unlink(uint32_t index)
+{
+	Node& node = nodes[index];
+	if (node.prev != NIL)
+	{
+		nodes[node.prev].next = node.next;
+	}
+	else
+	{
+		heads[node.slot] = node.next;
+	}
+	if (node.next != NIL)
+	{
+		nodes[node.next].prev = node.prev;
+	}
+	levelSizes[node.slot / SLOTS]--;
+	node.slot = -1;
+}
+
+void TimerWheel::Cascade(int level, int slot)
+{
+	uint32_t index = heads[level * SLOTS + slot];
+	heads[level * SLOTS + slot] = NIL;
+	while (index != NIL)
+	{
+		uint32_t next = nodes[index].next;
+		levelSizes[level]--;
+		Link(index, now);
+		index = next;
+	}
+}
+
+/**
+ * Timer service of the process: a timer wheel ticking every millisecond on its own thread.
+ * Any service can schedule a callback after a delay and cancel it; scheduling reads the cached clock,
+ * never the system clock. Callbacks run on the timer thread one after another, so they should be
+ * short and must lock what they share with the event threads.
+ */
+class TimerService
+{
+
+public:
+	// Get the timer service of the process, starting its thread on first use
+	static TimerService& Instance();
+
+	// dtor, stops the timer thread, pending timers never fire
+	~TimerService();
+
+	// Schedule a callback to run after a delay in milliseconds
+	TimerId Schedule(int64_t delayMillis, function<void()> callback);
+
+	// Cancel a timer; once this returns its callback is not running and will not run,
+	// unless called from the callback itself. Returns false if the timer had already fired.
+	bool Cancel(TimerId id);
+
+	// Get the number of pending timers
+	size_t GetPending();
+
+private:
+	// ctor
+	TimerService();
+
+	// Timer thread body
+	void Run();
+
+	CachedClock& clock;
+	TimerWheel wheel;
+	mutex lock; // guards the wheel
+	mutex runLock; // held by the timer thread while it collects and runs callbacks
+	condition_variable wake;
+	atomic<bool> running;
+	thread::id timerThread;
+	thread ticker;
+
+};
+
+TimerService& TimerService::Instance()
+{
+	static TimerService service;
+	return service;
+}
+
+TimerService::TimerService() : clock(CachedClock::Instance()), wheel(clock.GetMillis()), running(true)
+{
+	ticker = thread(&TimerService::Run, this);
+	timerThread = ticker.get_id();
+}
+
+TimerService::~TimerService()
+{
+	{
+		lock_guard<mutex> guard(lock);
+		running.store(false);
+	}
+	wake.notify_one();
+	ticker.join();
+}
+
+TimerId TimerService::Schedule(int64_t delayMillis, function<void()> callback)
+{
+	lock_guard<mutex> guard(lock);
+	return wheel.Add(clock.GetMillis() + delayMillis, move(callback));
+}
+
+bool TimerService::Cancel(TimerId id)
+{
+	bool removed;
+	{
+		lock_guard<mutex> guard(lock);
+		removed = wheel.Remove(id);
+	}
+	if (!removed && this_thread::get_id() != timerThread)
+	{
+		// the timer may have been collected and be running, wait for the batch to finish
+		lock_guard<mutex> guard(runLock);
+	}
+	return removed;
+}
+
+size_t TimerService::GetPending()
+{
+	lock_guard<mutex> guard(lock);
+	return wheel.GetSize();
+}
+
+void TimerService::Run()
+{
+	vector<function<void()>> expired;
+	while (true)
+	{
+		{
+			unique_lock<mutex> guard(lock);
+			if (wake.wait_for(guard, chrono::milliseconds(1), [this]() { return !running.load(); }))
+			{
+				return;
+			}
+		}
+		lock_guard<mutex> runGuard(runLock);
+		{
+			lock_guard<mutex> guard(lock);
+			wheel.Advance(clock.GetMillis(), expired);
+		}
+		// run outside the wheel lock, so callbacks can schedule and cancel timers
+		for (auto& callback : expired)
+		{
+			callback();
+		}
+		expired.clear();
+	}
+}
+
+#endif
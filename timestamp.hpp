@@ -0,0 +1,173 @@
+// timestamp.hpp
+//
+// Purpose: 1. Defines the formatter and the parser of "YYYY-MM-DD-HH:MM:SS.mmm" local timestamps,
+//    the format of the timestamps in the data and result files.
+// 2. Both cache their calls into the C library, so they cost a few integer operations per timestamp.
+//
+// @author Yuanting Li
+// @version 1.0 2026/10/16
+
+#ifndef TIMESTAMP_HPP
+#define TIMESTAMP_HPP
+
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * Timestamp formatter in the getTime() format (e.g. 2023-12-23-22:42:44.260) that caches the
+ * formatted second, so localtime and strftime only run once per second.
+ * Not thread safe, each thread should own its formatter.
+ */
+class TimestampFormatter
+{
+
+public:
+    // Length of a formatted timestamp
+    static const size_t LENGTH = 23;
+
+    // ctor
+    TimestampFormatter();
+
+    // Write the timestamp of a time point into out, which must hold LENGTH characters
+    void Format(std::chrono::system_clock::time_point now, char* out);
+
+    // Append the timestamp of a time point to a string
+    void Append(std::chrono::system_clock::time_point now, string& out);
+
+private:
+    long long cachedSecond; // epoch second of the cached prefix
+    char prefix[20]; // "YYYY-MM-DD-HH:MM:SS" of the cached second
+
+};
+
+TimestampFormatter::TimestampFormatter() : cachedSecond(-1)
+{
+}
+
+void TimestampFormatter::Format(std::chrono::system_clock::time_point now, char* out)
+{
+    using namespace std::chrono;
+
+    long long ms = duration_cast<milliseconds>(now.time_since_epoch()).count();
+    long long second = ms / 1000;
+    if (second != cachedSecond)
+    {
+        time_t now_c = static_cast<time_t>(second);
+        tm now_tm;
+        localtime_r(&now_c, &now_tm);
+        strftime(prefix, sizeof(prefix), "%Y-%m-%d-%H:%M:%S", &now_tm);
+        cachedSecond = second;
+    }
+
+    int milli = static_cast<int>(ms % 1000);
+    memcpy(out, prefix, 19);
+    out[19] = '.';
+    out[20] = static_cast<char>('0' + milli / 100);
+    out[21] = static_cast<char>('0' + milli / 10 % 10);
+    out[22] = static_cast<char>('0' + milli % 10);
+}
+
+void TimestampFormatter::Append(std::chrono::system_clock::time_point now, string& out)
+{
+    size_t size = out.size();
+    out.resize(size + LENGTH);
+    Format(now, &out[size]);
+}
+
+/**
+ * Parser of "YYYY-MM-DD-HH:MM:SS.mmm" local timestamps, the inverse of TimestampFormatter.
+ * The fields are read at their fixed offsets without strptime; the offset of local time from the
+ * epoch is looked up with mktime once per local hour and cached, so ticks within the same hour
+ * cost a few integer operations.
+ */
+class TimestampParser
+{
+
+public:
+    // ctor
+    TimestampParser();
+
+    // Parse a timestamp into nanoseconds since the epoch, returns false if the text is not in the format
+    bool Parse(string_view text, int64_t& nanos);
+
+    // Parse a timestamp into nanoseconds since the epoch (throws if the text is not in the format)
+    int64_t Parse(string_view text);
+
+private:
+    long long cachedHour; // local hours since 1970-01-01 of the cached offset
+    long long cachedOffset; // seconds from local time to epoch time in that hour
+
+};
+
+TimestampParser::TimestampParser() : cachedHour(LLONG_MIN), cachedOffset(0)
+{
+}
+
+bool TimestampParser::Parse(string_view text, int64_t& nanos)
+{
+    if (text.size() != TimestampFormatter::LENGTH || text[4] != '-' || text[7] != '-' || text[10] != '-'
+        || text[13] != ':' || text[16] != ':' || text[19] != '.') {
+        return false;
+    }
+    int digits[17];
+    static const int positions[17] = { 0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18, 20, 21, 22 };
+    for (int i = 0; i < 17; i++) {
+        digits[i] = text[positions[i]] - '0';
+        if (digits[i] < 0 || digits[i] > 9) {
+            return false;
+        }
+    }
+    int year = digits[0] * 1000 + digits[1] * 100 + digits[2] * 10 + digits[3];
+    int month = digits[4] * 10 + digits[5];
+    int day = digits[6] * 10 + digits[7];
+    int hour = digits[8] * 10 + digits[9];
+    int minute = digits[10] * 10 + digits[11];
+    int second = digits[12] * 10 + digits[13];
+    int milli = digits[14] * 100 + digits[15] * 10 + digits[16];
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+
+    // days since 1970-01-01 of the civil date, counted in eras of 400 years starting in March
+    int y = year - (month <= 2 ? 1 : 0);
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yearOfEra = y - era * 400;
+    long long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    long long days = era * 146097 + dayOfEra - 719468;
+
+    long long localHour = days * 24 + hour;
+    if (localHour != cachedHour) {
+        tm local = {};
+        local.tm_year = year - 1900;
+        local.tm_mon = month - 1;
+        local.tm_mday = day;
+        local.tm_hour = hour;
+        local.tm_isdst = -1;
+        cachedOffset = static_cast<long long>(mktime(&local)) - localHour * 3600;
+        cachedHour = localHour;
+    }
+
+    long long epochSecond = localHour * 3600 + minute * 60 + second + cachedOffset;
+    nanos = epochSecond * 1000000000LL + milli * 1000000LL;
+    return true;
+}
+
+int64_t TimestampParser::Parse(string_view text)
+{
+    int64_t nanos;
+    if (!Parse(text, nanos)) {
+        throw std::invalid_argument("Invalid timestamp: " + string(text));
+    }
+    return nanos;
+}
+
+#endif
@@ -13,10 +13,15 @@
 #include <vector>
 #include "soa.hpp"
 #include "executionservice.hpp"
+#include "csvreader.hpp"
 
 // Trade sides
 enum Side { BUY, SELL };
 
+// Face amount prices are quoted for. Trade and position quantities are face amounts, so the cash value of a
+// quantity at a price is quantity x price / PRICE_FACE; services valuing positions use this one convention.
+const double PRICE_FACE = 100.0;
+
 /**
  * Trade object with a price, side, and quantity on a particular book.
  * Type T is the product type.
@@ -32,6 +37,8 @@ public:
 
     // ctor for a trade
     Trade(const T& _product, string _tradeId, double _price, string _book, long _quantity, Side _side);
+    Trade(const T& _product, string _tradeId, TickPrice _price, string _book, long _quantity, Side _side);
+    Trade(ProductHandle _product, string _tradeId, TickPrice _price, string _book, long _quantity, Side _side, int64_t _timestamp = 0);
 
     // dtor
     ~Trade() = default;
@@ -39,12 +46,18 @@ public:
     // Get the product
     const T& GetProduct() const;
 
+    // Get the registry handle of the product
+    ProductHandle GetProductHandle() const;
+
     // Get the trade ID
     const string& GetTradeId() const;
 
     // Get the mid price
     double GetPrice() const;
 
+    // Get the tick price
+    TickPrice GetTickPrice() const;
+
     // Get the book
     const string& GetBook() const;
 
@@ -54,20 +67,36 @@ public:
     // Get the side
     Side GetSide() const;
 
+    // Get the event time of the execution the trade was booked from, 0 if unknown
+    int64_t GetTimestamp() const;
+
 private:
-    T product;
+    ProductHandle product = EMPTY_PRODUCT;
     string tradeId;
-    double price;
+    TickPrice price;
     string book;
     long quantity;
     Side side;
+    int64_t timestamp = 0;
 
 };
 
 
 template<typename T>
 Trade<T>::Trade(const T &_product, string _tradeId, double _price, string _book, long _quantity, Side _side) :
-  product(_product)
+  Trade(_product, move(_tradeId), TickPrice::FromDouble(_price), move(_book), _quantity, _side)
+{
+}
+
+template<typename T>
+Trade<T>::Trade(const T &_product, string _tradeId, TickPrice _price, string _book, long _quantity, Side _side) :
+  Trade(ProductRegistry<T>::Instance().Intern(_product), move(_tradeId), _price, move(_book), _quantity, _side)
+{
+}
+
+template<typename T>
+Trade<T>::Trade(ProductHandle _product, string _tradeId, TickPrice _price, string _book, long _quantity, Side _side, int64_t _timestamp) :
+  product(_product), timestamp(_timestamp)
 {
     tradeId = _tradeId;
     price = _price;
@@ -78,6 +107,12 @@ Trade<T>::Trade(const T &_product, string _tradeId, double _price, string _book,
 
 template<typename T>
 const T& Trade<T>::GetProduct() const
+{
+    return ProductRegistry<T>::Instance().Get(product);
+}
+
+template<typename T>
+ProductHandle Trade<T>::GetProductHandle() const
 {
     return product;
 }
@@ -90,6 +125,12 @@ const string& Trade<T>::GetTradeId() const
 
 template<typename T>
 double Trade<T>::GetPrice() const
+{
+    return price.ToDouble();
+}
+
+template<typename T>
+TickPrice Trade<T>::GetTickPrice() const
 {
     return price;
 }
@@ -112,6 +153,12 @@ Side Trade<T>::GetSide() const
     return side;
 }
 
+template<typename T>
+int64_t Trade<T>::GetTimestamp() const
+{
+    return timestamp;
+}
+
 // fwd declaration
 template<typename T>
 class TradeBookingConnector;
@@ -143,6 +190,9 @@ public:
   // The callback that a Connector should invoke for any new or updated data
   void OnMessage(Trade<T> &data);
 
+  // The callback that a Connector should invoke for a batch of new or updated data
+  void OnMessageBatch(span<Trade<T>> batch) override;
+
   // Add a listener to the Service for callbacks on add, remove, and update events
   // for data to the Service.
   void AddListener(ServiceListener<Trade<T>> *listener);
@@ -195,6 +245,16 @@ void TradeBookingService<T>::OnMessage(Trade<T> &data)
     listener->ProcessAdd(data);
 }
 
+template<typename T>
+void TradeBookingService<T>::OnMessageBatch(span<Trade<T>> batch)
+{
+  for (auto& data : batch)
+    tradeData[data.GetTradeId()] = data;
+
+  for(auto& listener : listeners)
+    listener->ProcessAddBatch(batch);
+}
+
 template<typename T>
 void TradeBookingService<T>::AddListener(ServiceListener<Trade<T>> *listener)
 {
@@ -253,12 +313,29 @@ public:
   // Subscribe data from the Connector
   void Subscribe(ifstream& _data);
 
+  // Subscribe data from a file, fields are read straight from the mapped file
+  void Subscribe(const string& _path);
+
+private:
+  // Build a trade from the fields of one line and add it to the batch
+  template<typename Fields>
+  void SubscribeLine(const Fields& fields);
+
+  // Send the collected batch to the service
+  void FlushBatch();
+
+  vector<Trade<T>> batch; // trades collected for the next OnMessageBatch()
+#ifdef SOA_INSTRUMENT
+  vector<long long> ingressStamps; // time each trade of the batch was read
+#endif
+
 };
 
 template<typename T>
 TradeBookingConnector<T>::TradeBookingConnector(TradeBookingService<T>* _service)
 {
   service = _service;
+  batch.reserve(CONNECTOR_BATCH_SIZE);
 }
 
 template<typename T>
@@ -281,16 +358,52 @@ void TradeBookingConnector<T>::Subscribe(ifstream& _data)
             tokens.push_back(token);
         }
 
-        string productId = tokens[0];
-        T product = QueryProduct<T>(productId);
-        string tradeId = tokens[1];
-        double price = Frac2Price(tokens[2]);
-        string book = tokens[3];
-        long quantity = stol(tokens[4]);
-        Side side = (tokens[5] == "BUY") ? BUY : SELL;
+        SubscribeLine(tokens);
+    }
+    FlushBatch();
+}
 
-        Trade<T> trade(product, tradeId, price, book, quantity, side);
-        service->OnMessage(trade);
+template<typename T>
+void TradeBookingConnector<T>::Subscribe(const string& _path)
+{
+    CsvReader reader(_path);
+    while (reader.NextLine())
+    {
+        SubscribeLine(reader);
+    }
+    FlushBatch();
+}
+
+template<typename T>
+template<typename Fields>
+void TradeBookingConnector<T>::SubscribeLine(const Fields& tokens)
+{
+    string productId(tokens[0]);
+    ProductHandle product = QueryProductHandle<T>(productId);
+    string tradeId(tokens[1]);
+    TickPrice price = ParseTickPrice(tokens[2]);
+    string book(tokens[3]);
+    long quantity = ParseLong(tokens[4]);
+    Side side = (tokens[5] == "BUY") ? BUY : SELL;
+
+    // stamped once the line has parsed, so a bad line leaves no stamp without a trade
+    SOA_STAMP_BATCH_EVENT(ingressStamps);
+    batch.emplace_back(product, move(tradeId), price, move(book), quantity, side);
+    if (batch.size() == CONNECTOR_BATCH_SIZE)
+    {
+        FlushBatch();
+    }
+}
+
+template<typename T>
+void TradeBookingConnector<T>::FlushBatch()
+{
+    if (!batch.empty())
+    {
+        SOA_INGRESS_BATCH(span<Trade<T>>(batch), ingressStamps);
+        SOA_TIME_SCOPE("tradebooking.onmessage");
+        service->OnMessageBatch(span<Trade<T>>(batch));
+        batch.clear();
     }
 }
 
@@ -306,7 +419,7 @@ class TradeBookingServiceListener : public ServiceListener<ExecutionOrder<T>>
 {
 private:
   TradeBookingService<T>* service;
-  long count;
+  ProductStore<long> counts; // trades booked per product, so a sharded run cycles books as a serial one
 
 public:
   // ctor
@@ -329,7 +442,7 @@ template<typename T>
 TradeBookingServiceListener<T>::TradeBookingServiceListener(TradeBookingService<T>* _service)
 {
   service = _service;
-  count = 0;
+  counts.Reserve(ProductRegistry<T>::Instance().GetSize());
 }
 
 
@@ -340,9 +453,9 @@ TradeBookingServiceListener<T>::TradeBookingServiceListener(TradeBookingService<
 template<typename T>
 void TradeBookingServiceListener<T>::ProcessAdd(ExecutionOrder<T>& order)
 {
-    T product = order.GetProduct();
+    ProductHandle product = order.GetProductHandle();
     string orderId = order.GetOrderId();
-    double price = order.GetPrice();
+    TickPrice price = order.GetTickPrice();
     long visibleQuantity = order.GetVisibleQuantity();
     long hiddenQuantity = order.GetHiddenQuantity();
     long totalQuantity = visibleQuantity + hiddenQuantity;
@@ -350,14 +463,14 @@ void TradeBookingServiceListener<T>::ProcessAdd(ExecutionOrder<T>& order)
     Side tradeSide = (order.GetSide() == BID) ? BUY : SELL;
 
     string book;
-    switch (count++ % 3)
+    switch (counts[product]++ % 3)
     {
     case 0: book = "TRSY1"; break;
     case 1: book = "TRSY2"; break;
     case 2: book = "TRSY3"; break;
     }
 
-    Trade<T> trade(product, orderId, price, book, totalQuantity, tradeSide);
+    Trade<T> trade(product, orderId, price, book, totalQuantity, tradeSide, order.GetTimestamp());
     service->BookTrade(trade);
 }
 
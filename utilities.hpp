@@ -15,8 +15,27 @@
 #include <chrono>
 #include <fstream>
 #include <random>
+#include <ctime>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <charconv>
+#include <algorithm>
+#include <exception>
+#include <cstdio>
+#include <climits>
+#include <unordered_map>
+#include <string_view>
 
 #include "products.hpp"
+#include "fracprice.hpp"
+#include "productregistry.hpp"
+#include "tickfile.hpp"
+#include "csvreader.hpp"
+#include "timestamp.hpp"
+#include "asynclogger.hpp"
+#include "bondanalytics.hpp"
 
 using namespace std;
 
@@ -73,7 +92,6 @@ std::string getTime(std::chrono::system_clock::time_point now)
     return ss.str();
 }
 
-
 enum class LogLevel {
     INFO,
     WARNING,
@@ -81,29 +99,17 @@ enum class LogLevel {
     FINAL
 };
 
-// log messages with different levels (colors)
+// formats of the log levels (colors), by LogLevel
+const LogFormat LOG_FORMATS[] = {
+    LogFormat(GREEN "{time} [INFO] {}" RESET "\n"),
+    LogFormat(YELLOW "{time} [WARNING] {}" RESET "\n"),
+    LogFormat(RED "{time} [ERROR] {}" RESET "\n"),
+    LogFormat(BLUE "{time} [FINAL] {}" RESET "\n"),
+};
+
+// log messages with different levels (colors), formatted and written by the asynchronous logger
 void log(LogLevel level, const string& message) {
-    string levelStr;
-    string color;
-    switch (level) {
-        case LogLevel::INFO:
-            levelStr = "INFO";
-            color = GREEN;
-            break;
-        case LogLevel::WARNING:
-            levelStr = "WARNING";
-            color = YELLOW;
-            break;
-        case LogLevel::ERROR:
-            levelStr = "ERROR";
-            color = RED;
-            break;
-        case LogLevel::FINAL:
-            levelStr = "FINAL";
-            color = BLUE;
-            break;
-    }
-    cout << color << getTime() << " [" << levelStr << "] " << message << RESET << endl;
+    AsyncLogger::Instance().Log(LOG_FORMATS[static_cast<int>(level)], message);
 }
 
 // get Product object from identifier
@@ -123,17 +129,40 @@ std::map<string, ProductCtor<T>> productConstructors = {
     {"912810RZ3", []() { return Bond("912810RZ3", CUSIP, "US30Y", 0.02750, from_string("2047/12/15")); }},
 };
 
+// Build every known product once and intern it in the product registry
 template <typename T>
-T QueryProduct(const string& cusip)
+void RegisterProducts()
 {
+    for (auto& item : productConstructors<T>) {
+        ProductRegistry<T>::Instance().Intern(item.second());
+    }
+}
+
+// Get the registry handle of a product from identifier, building the product on first use
+template <typename T>
+ProductHandle QueryProductHandle(const string& cusip)
+{
+    ProductRegistry<T>& registry = ProductRegistry<T>::Instance();
+    ProductHandle handle;
+    if (registry.Find(cusip, handle)) {
+        return handle;
+    }
+
     auto it = productConstructors<T>.find(cusip);
     if (it == productConstructors<T>.end()) {
         throw std::invalid_argument("Unknown CUSIP: " + cusip);
     }
-    return it->second();
+    return registry.Intern(it->second());
 }
 
-// Function to calculate PV01
+// Get the interned Product object from identifier
+template <typename T>
+const T& QueryProduct(const string& cusip)
+{
+    return ProductRegistry<T>::Instance().Get(QueryProductHandle<T>(cusip));
+}
+
+// Function to calculate PV01, coupon by coupon (reference of BondPV01 in bondanalytics.hpp)
 double CalculatePV01(double faceValue, double couponRate, double yieldRate, int yearsToMaturity, int frequency)
 {
     double coupon = faceValue * couponRate / frequency;
@@ -163,13 +192,20 @@ double CalculatePV01(double faceValue, double couponRate, double yieldRate, int
 // Define a map from CUSIPs to PV01
 // Current yield for 2,3,5,7,10,20,30 year US treasury bonds: 0.0464, 0.0440, 0.0412, 0.043, 0.0428, 0.0461, 0.0443
 std::map<string, double> pv01 = {
-    {"9128283H1", CalculatePV01(1000, 0.01750, 0.0464, 2, 2)},
-    {"9128283L2", CalculatePV01(1000, 0.01875, 0.0440, 3, 2)},
-    {"912828M80", CalculatePV01(1000, 0.02000, 0.0412, 5, 2)},
-    {"9128283J7", CalculatePV01(1000, 0.02125, 0.0430, 7, 2)},
-    {"9128283F5", CalculatePV01(1000, 0.02250, 0.0428, 10, 2)},
-    {"912810TW8", CalculatePV01(1000, 0.02500, 0.0461, 20, 2)},
-    {"912810RZ3", CalculatePV01(1000, 0.02750, 0.0443, 30, 2)},
+    {"9128283H1", BondPV01(GetBondTerms(0.01750, 2), 0.0464, 1000)},
+    {"9128283L2", BondPV01(GetBondTerms(0.01875, 3), 0.0440, 1000)},
+    {"912828M80", BondPV01(GetBondTerms(0.02000, 5), 0.0412, 1000)},
+    {"9128283J7", BondPV01(GetBondTerms(0.02125, 7), 0.0430, 1000)},
+    {"9128283F5", BondPV01(GetBondTerms(0.02250, 10), 0.0428, 1000)},
+    {"912810TW8", BondPV01(GetBondTerms(0.02500, 20), 0.0461, 1000)},
+    {"912810RZ3", BondPV01(GetBondTerms(0.02750, 30), 0.0443, 1000)},
+};
+
+// Define the standard risk sectors of the treasury curve and their CUSIPs
+std::vector<std::pair<string, vector<string>>> sectorCusips = {
+    {"FrontEnd", {"9128283H1", "9128283L2"}},
+    {"Belly", {"912828M80", "9128283J7", "9128283F5"}},
+    {"LongEnd", {"912810TW8", "912810RZ3"}},
 };
 
 // Get unit PV01 value from CUSIP
@@ -181,6 +217,8 @@ double QueryPV01(const string& cusip) {
     return it->second;
 }
 
+// Convert prices from fractional notation to decimal notation.
+// Reference implementation, the connectors use the allocation-free ParseFracPrice in fracprice.hpp.
 double Frac2Price(const string& PriceFrac)
 {
     int posDash = PriceFrac.find('-');
@@ -222,6 +260,23 @@ string Price2Frac(double price)
     return fractionalString;
 }
 
+// Convert a tick price to fractional notation, exactly (no floating point truncation).
+string Price2Frac(TickPrice price)
+{
+    long ticks = price.GetTicks();
+    long intpart = (ticks >= 0) ? ticks / TICKS_PER_POINT : -((-ticks + TICKS_PER_POINT - 1) / TICKS_PER_POINT);
+    long frac = ticks - intpart * TICKS_PER_POINT;
+
+    long xy = frac / 8;
+    long z = frac % 8;
+
+    string fractionalString = to_string(intpart) + "-";
+    fractionalString += (xy < 10 ? "0" : "") + to_string(xy);
+    fractionalString += (z == 4 ? "+" : to_string(z));
+
+    return fractionalString;
+}
+
 // generate oscillating spread between 1/64 and 1/128
 double genRandomSpread(std::mt19937& gen) {
     std::uniform_real_distribution<double> dist(1.0/128.0, 1.0/64.0);
@@ -243,95 +298,356 @@ string GenerateRandomId(long length)
     return id;
 }
 
+// Generate random ID with numbers and letters from a given random stream
+string GenerateRandomId(long length, std::mt19937& gen)
+{
+    string id(length, '0');
+    for (long j = 0; j < length; ++j) {
+        int random = static_cast<int>(gen() % 36);
+        id[j] = random < 10 ? static_cast<char>('0' + random) : static_cast<char>('A' + random - 10);
+    }
+    return id;
+}
+
+// Random stream for the IDs generated by a service for one product, seeded by the product's index,
+// so the IDs of a product do not depend on the other products or on the thread running it
+std::mt19937 ProductIdStream(uint32_t index)
+{
+    std::seed_seq seq{ 9815u, index };
+    return std::mt19937(seq);
+}
+
 /**
- * 1. Generate prices that oscillate between 99 and 101 and write to prices.txt
- * 2. Generate order book data with fivel levels of bids and offers and write to marketdata.txt
+ * Generate the price and order book ticks of one product into its own part files.
+ * The product draws from its own random stream, seeded by the seed and the product's index,
+ * so its ticks do not depend on the other products or on the thread generating them.
+ * Rows are formatted into large buffers and written a few megabytes at a time.
  */
-void genOrderBook(const vector<string>& products, const string& priceFile, const string& orderbookFile, long long seed, const int numDataPoints) {
-    std::ofstream pFile(priceFile);
-    std::ofstream oFile(orderbookFile);
-    std::mt19937 gen(seed);
+void genProductTicks(const string& product, uint32_t index, const string& pricePart, const string& orderbookPart,
+    long long seed, int numDataPoints, TickFormat format, std::chrono::system_clock::time_point start)
+{
+    const size_t flushSize = 1 << 22;
+    const int depth = 5;
+    const size_t maxRowSize = 512;
+    if (product.size() > 64) {
+        throw std::invalid_argument("Product identifier too long: " + product);
+    }
+
+    std::seed_seq seq{ static_cast<uint32_t>(seed), static_cast<uint32_t>(static_cast<unsigned long long>(seed) >> 32), index };
+    std::mt19937 gen(seq);
     std::uniform_int_distribution<> ms_dist(1, 20); // simulate milliseconds increments
 
-    // price file format: Timestamp, CUSIP, Bid, Ask
-    pFile << "Timestamp,CUSIP,Bid,Ask" << endl;
+    std::ofstream pFile(pricePart, ios::binary);
+    std::ofstream oFile(orderbookPart, ios::binary);
+    string pBuffer, oBuffer;
+    pBuffer.reserve(flushSize + maxRowSize);
+    oBuffer.reserve(flushSize + maxRowSize);
+    TimestampFormatter timestamps;
+    TickBlockBuilder priceBlock(PRICE_TICKS, 0, index);
+    TickBlockBuilder bookBlock(BOOK_TICKS, depth, index);
+
+    double midPrice = 99.00;
+    bool priceIncreasing = true;
+    bool spreadIncreasing = true;
+    double fixSpread = 1.0/128.0;
+    auto curTime = start;
+    int32_t bids[depth], asks[depth];
+    int64_t sizes[depth];
+
+    for (int i = 0; i < numDataPoints; ++i) {
+
+        // generate price data
+        double randomSpread = genRandomSpread(gen);
+        curTime += std::chrono::milliseconds(ms_dist(gen));
+
+        double randomBid = midPrice - randomSpread / 2.0;
+        double randomAsk = midPrice + randomSpread / 2.0;
+        // prices are truncated to 1/256, as Price2Frac() does
+        int32_t bidTicks = static_cast<int32_t>(floor(randomBid * 256));
+        int32_t askTicks = static_cast<int32_t>(floor(randomAsk * 256));
+
+        // generate order book data
+        for (int level = 1; level <= depth; ++level) {
+            bids[level - 1] = static_cast<int32_t>(floor((midPrice - fixSpread * level / 2.0) * 256));
+            asks[level - 1] = static_cast<int32_t>(floor((midPrice + fixSpread * level / 2.0) * 256));
+            sizes[level - 1] = level * 1'000'000;
+        }
+
+        if (format == CSV_TICKS) {
+            // orderbook file format: Timestamp, CUSIP, then Bid, BidSize, Ask, AskSize per level
+            // rows are formatted in place at the end of the buffers, which always have room for one more row
+            size_t rowStart = oBuffer.size();
+            oBuffer.resize(rowStart + maxRowSize);
+            char* row = &oBuffer[rowStart];
+            char* p = row;
+            timestamps.Format(curTime, p);
+            p += TimestampFormatter::LENGTH;
+            *p++ = ',';
+            p = copy(product.begin(), product.end(), p);
+            size_t prefixSize = p - row; // timestamp and product, shared with the price row
+            for (int level = 0; level < depth; ++level) {
+                *p++ = ',';
+                p = FormatFracTicks(bids[level], p);
+                *p++ = ',';
+                p = to_chars(p, p + 20, sizes[level]).ptr;
+                *p++ = ',';
+                p = FormatFracTicks(asks[level], p);
+                *p++ = ',';
+                p = to_chars(p, p + 20, sizes[level]).ptr;
+            }
+            *p++ = '\n';
+            oBuffer.resize(rowStart + (p - row));
+
+            // price file format: Timestamp, CUSIP, Bid, Ask, Spread
+            size_t priceStart = pBuffer.size();
+            pBuffer.resize(priceStart + maxRowSize);
+            p = copy(oBuffer.begin() + rowStart, oBuffer.begin() + rowStart + prefixSize, &pBuffer[priceStart]);
+            *p++ = ',';
+            p = FormatFracTicks(bidTicks, p);
+            *p++ = ',';
+            p = FormatFracTicks(askTicks, p);
+            *p++ = ',';
+            p = to_chars(p, p + 32, randomSpread, chars_format::general, 6).ptr;
+            *p++ = '\n';
+            pBuffer.resize(p - pBuffer.data());
+        }
+        else {
+            int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(curTime.time_since_epoch()).count();
+            priceBlock.AddPrice(timestamp, bidTicks, askTicks);
+            bookBlock.AddBook(timestamp, bids, sizes, asks, sizes);
+            if (priceBlock.GetRows() == TICK_BLOCK_ROWS) {
+                priceBlock.Encode(pBuffer);
+                bookBlock.Encode(oBuffer);
+            }
+        }
 
-    // orderbook file format: Timestamp, CUSIP, Bid1, BidSize1, Ask1, AskSize1, Bid2, BidSize2, Ask2, AskSize2, Bid3, BidSize3, Ask3, AskSize3, Bid4, BidSize4, Ask4, AskSize4, Bid5, BidSize5, Ask5, AskSize5
-    oFile << "Timestamp,CUSIP,Bid1,BidSize1,Ask1,AskSize1,Bid2,BidSize2,Ask2,AskSize2,Bid3,BidSize3,Ask3,AskSize3,Bid4,BidSize4,Ask4,AskSize4,Bid5,BidSize5,Ask5,AskSize5" << endl;
+        if (pBuffer.size() >= flushSize) {
+            pFile.write(pBuffer.data(), pBuffer.size());
+            pBuffer.clear();
+        }
+        if (oBuffer.size() >= flushSize) {
+            oFile.write(oBuffer.data(), oBuffer.size());
+            oBuffer.clear();
+        }
 
-    for (const auto& product : products) {
-        double midPrice = 99.00;
-        bool priceIncreasing = true;
-        bool spreadIncreasing = true;
-        double fixSpread = 1.0/128.0;
-        auto curTime = std::chrono::system_clock::now();
-        string timestamp;
-
-        // number of data points
-        for (int i = 0; i < numDataPoints; ++i) {
-
-            // generate price data
-            double randomSpread = genRandomSpread(gen);
-            curTime += std::chrono::milliseconds(ms_dist(gen));
-            timestamp = getTime(curTime);
-
-            double randomBid = midPrice - randomSpread / 2.0;
-            double randomAsk = midPrice + randomSpread / 2.0;
-            pFile << timestamp << "," << product << "," << Price2Frac(randomBid) << "," << Price2Frac(randomAsk) << "," << randomSpread << endl;
-
-            // generate order book data
-            oFile << timestamp << "," << product;
-            for (int level=1; level<=5; ++level){
-                double fixBid = midPrice - fixSpread * level / 2.0;
-                double fixAsk = midPrice + fixSpread * level / 2.0;
-                int size = level * 1'000'000;
-                oFile << "," << Price2Frac(fixBid) << "," << size << "," << Price2Frac(fixAsk) << "," << size;
+        // oscillate mid price
+        if (priceIncreasing) {
+            midPrice += 1.0 / 256.0;
+            if (randomAsk >= 101.0) {
+                priceIncreasing = false;
             }
-            oFile << endl;
+        } else {
+            midPrice -= 1.0 / 256.0;
+            if (randomBid <= 99.0) {
+                priceIncreasing = true;
+            }
+        }
 
-            // oscillate mid price
-            if (priceIncreasing) {
-                midPrice += 1.0 / 256.0;
-                if (randomAsk >= 101.0) {
-                    priceIncreasing = false;
+        // oscillate spread
+        if (spreadIncreasing) {
+            fixSpread += 1.0 / 128.0;
+            if (fixSpread >= 1.0 / 32.0) {
+                spreadIncreasing = false;
+            }
+        } else {
+            fixSpread -= 1.0 / 128.0;
+            if (fixSpread <= 1.0 / 128.0) {
+                spreadIncreasing = true;
+            }
+        }
+    }
+
+    priceBlock.Encode(pBuffer);
+    bookBlock.Encode(oBuffer);
+    pFile.write(pBuffer.data(), pBuffer.size());
+    oFile.write(oBuffer.data(), oBuffer.size());
+    if (!pFile || !oFile) {
+        throw std::runtime_error("Cannot write tick data: " + pricePart);
+    }
+}
+
+/**
+ * 1. Generate prices that oscillate between 99 and 101 and write to prices.txt
+ * 2. Generate order book data with fivel levels of bids and offers and write to marketdata.txt
+ * Products are generated in parallel on up to threads threads (0 for one per core), each from its own
+ * random stream, and their part files are joined in product order: for a given seed and start time
+ * the output is byte-identical whatever the number of threads.
+ * The files are CSV, or tick files (see tickfile.hpp) in the binary format.
+ */
+void genOrderBook(const vector<string>& products, const string& priceFile, const string& orderbookFile, long long seed, const int numDataPoints,
+    int threads = 0, TickFormat format = CSV_TICKS, std::chrono::system_clock::time_point start = std::chrono::system_clock::now()) {
+    auto partName = [](const string& file, size_t index) { return file + ".part" + to_string(index); };
+
+    size_t workerCount = (threads > 0) ? threads : std::max(1u, std::thread::hardware_concurrency());
+    workerCount = std::min(workerCount, std::max<size_t>(products.size(), 1));
+    std::atomic<size_t> next(0);
+    std::exception_ptr failure;
+    std::mutex failureLock;
+    vector<std::thread> workers;
+    for (size_t t = 0; t < workerCount; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t i; (i = next++) < products.size();) {
+                try {
+                    genProductTicks(products[i], static_cast<uint32_t>(i), partName(priceFile, i), partName(orderbookFile, i),
+                        seed, numDataPoints, format, start);
                 }
-            } else {
-                midPrice -= 1.0 / 256.0;
-                if (randomBid <= 99.0) {
-                    priceIncreasing = true;
+                catch (...) {
+                    std::lock_guard<std::mutex> guard(failureLock);
+                    failure = std::current_exception();
                 }
             }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
 
-            // oscillate spread
-            if (spreadIncreasing) {
-                fixSpread += 1.0 / 128.0;
-                if (fixSpread >= 1.0 / 32.0) {
-                    spreadIncreasing = false;
-                }
-            } else {
-                fixSpread -= 1.0 / 128.0;
-                if (fixSpread <= 1.0 / 128.0) {
-                    spreadIncreasing = true;
+    std::ofstream pFile(priceFile, ios::binary);
+    std::ofstream oFile(orderbookFile, ios::binary);
+    if (format == CSV_TICKS) {
+        pFile << "Timestamp,CUSIP,Bid,Ask" << '\n';
+        oFile << "Timestamp,CUSIP,Bid1,BidSize1,Ask1,AskSize1,Bid2,BidSize2,Ask2,AskSize2,Bid3,BidSize3,Ask3,AskSize3,Bid4,BidSize4,Ask4,AskSize4,Bid5,BidSize5,Ask5,AskSize5" << '\n';
+    }
+    else {
+        string header;
+        EncodeTickFileHeader(header, PRICE_TICKS, 0, products);
+        pFile.write(header.data(), header.size());
+        header.clear();
+        EncodeTickFileHeader(header, BOOK_TICKS, 5, products);
+        oFile.write(header.data(), header.size());
+    }
+
+    // join the part files in product order
+    for (size_t i = 0; i < products.size(); ++i) {
+        for (auto file : { make_pair(&pFile, partName(priceFile, i)), make_pair(&oFile, partName(orderbookFile, i)) }) {
+            {
+                std::ifstream part(file.second, ios::binary);
+                if (part.peek() != std::ifstream::traits_type::eof()) {
+                    *file.first << part.rdbuf();
                 }
             }
+            std::remove(file.second.c_str());
         }
     }
 
-    pFile.close();
-    oFile.close();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+/**
+ * Convert a price or order book CSV file (the genOrderBook() format) into a tick file.
+ * Rows keep their order: a block ends whenever the product changes, so replaying the tick file
+ * feeds the services exactly the sequence of the CSV. Products enter the product table in order of
+ * first appearance and the book depth is taken from the CSV header. Blocks are written to a
+ * scratch file while the product table is being collected, then appended after the header.
+ */
+void convertTicks(const string& csvFile, const string& tickFile, TickKind kind) {
+    const size_t flushSize = 1 << 22;
+    CsvReader reader(csvFile);
+    if (!reader.NextLine()) {
+        throw std::invalid_argument("Empty tick data file: " + csvFile);
+    }
+    uint32_t depth = (kind == BOOK_TICKS) ? static_cast<uint32_t>((reader.GetFieldCount() - 2) / 4) : 0;
+    size_t fieldCount = (kind == BOOK_TICKS) ? 2 + 4 * depth : 4;
+    if (kind == BOOK_TICKS && depth == 0) {
+        throw std::invalid_argument("No book levels in tick data file: " + csvFile);
+    }
+
+    vector<string> products;
+    std::unordered_map<string, uint32_t> indices;
+    TimestampParser timestamps;
+    TickBlockBuilder block(kind, depth, 0);
+    vector<int32_t> bids(depth), asks(depth);
+    vector<int64_t> bidSizes(depth), askSizes(depth);
+    vector<string_view> priceTexts(2 * std::max<uint32_t>(depth, 1));
+    vector<long> ticks(priceTexts.size());
+
+    const string blockFile = tickFile + ".blocks";
+    std::ofstream blocks(blockFile, ios::binary);
+    string buffer;
+    buffer.reserve(flushSize + TickBlock::ColumnsSize(kind, depth, TICK_BLOCK_ROWS) + sizeof(TickBlockHeader));
+    uint32_t current = UINT32_MAX;
+    while (reader.NextLine()) {
+        if (reader.GetFieldCount() < fieldCount) {
+            throw std::invalid_argument("Missing fields in tick data: " + string(reader.GetLine()));
+        }
+
+        // a new product, or the block is full, ends the block
+        auto found = indices.try_emplace(string(reader[1]), static_cast<uint32_t>(products.size()));
+        if (found.second) {
+            products.push_back(found.first->first);
+        }
+        uint32_t index = found.first->second;
+        if (index != current || block.GetRows() == TICK_BLOCK_ROWS) {
+            block.Encode(buffer);
+            block.Reset(index);
+            current = index;
+            if (buffer.size() >= flushSize) {
+                blocks.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+
+        int64_t timestamp = timestamps.Parse(reader[0]);
+        size_t count = priceTexts.size();
+        for (size_t i = 0; i < count / 2; i++) {
+            priceTexts[2 * i] = (kind == BOOK_TICKS) ? reader[4 * i + 2] : reader[2];
+            priceTexts[2 * i + 1] = (kind == BOOK_TICKS) ? reader[4 * i + 4] : reader[3];
+        }
+        size_t parsed = ParseFracTicks(priceTexts.data(), ticks.data(), count);
+        if (parsed < count) {
+            throw std::invalid_argument("Invalid fractional price: " + string(priceTexts[parsed]));
+        }
+
+        if (kind == PRICE_TICKS) {
+            block.AddPrice(timestamp, static_cast<int32_t>(ticks[0]), static_cast<int32_t>(ticks[1]));
+        }
+        else {
+            for (uint32_t level = 0; level < depth; level++) {
+                bids[level] = static_cast<int32_t>(ticks[2 * level]);
+                asks[level] = static_cast<int32_t>(ticks[2 * level + 1]);
+                bidSizes[level] = ParseLong(reader[4 * level + 3]);
+                askSizes[level] = ParseLong(reader[4 * level + 5]);
+            }
+            block.AddBook(timestamp, bids.data(), bidSizes.data(), asks.data(), askSizes.data());
+        }
+    }
+    block.Encode(buffer);
+    blocks.write(buffer.data(), buffer.size());
+    blocks.close();
+    if (!blocks) {
+        std::remove(blockFile.c_str());
+        throw std::runtime_error("Cannot write tick data: " + blockFile);
+    }
+
+    std::ofstream out(tickFile, ios::binary);
+    string header;
+    EncodeTickFileHeader(header, kind, depth, products);
+    out.write(header.data(), header.size());
+    {
+        std::ifstream part(blockFile, ios::binary);
+        if (part.peek() != std::ifstream::traits_type::eof()) {
+            out << part.rdbuf();
+        }
+    }
+    std::remove(blockFile.c_str());
+    if (!out) {
+        throw std::runtime_error("Cannot write tick data: " + tickFile);
+    }
 }
 
 /**
  * Generate trades data
  */
-void genTrades(const vector<string>& products, const string& tradeFile, long long seed) {
+void genTrades(const vector<string>& products, const string& tradeFile, long long seed, int numPerProduct = 10) {
     vector<string> books = {"TRSY1", "TRSY2", "TRSY3"};
     vector<long> quantities = {1000000, 2000000, 3000000, 4000000, 5000000};
     std::ofstream tFile(tradeFile);
     std::mt19937 gen(seed);
 
     for (const auto& product : products) {
-        for (int i = 0; i < 10; ++i) {
+        for (int i = 0; i < numPerProduct; ++i) {
             string side = (i % 2 == 0) ? "BUY" : "SELL";
             // generate a 12 digit random trade id with number and letters
             string tradeId = GenerateRandomId(12);
@@ -351,13 +667,13 @@ void genTrades(const vector<string>& products, const string& tradeFile, long lon
 /**
  * Generate inquiry data
  */
-void genInquiries(const vector<string>& products, const string& inquiryFile, long long seed){
+void genInquiries(const vector<string>& products, const string& inquiryFile, long long seed, int numPerProduct = 10){
     std::ofstream iFile(inquiryFile);
     std::mt19937 gen(seed);
     vector<long> quantities = {1000000, 2000000, 3000000, 4000000, 5000000};
 
     for (const auto& product : products) {
-        for (int i = 0; i < 10; ++i) {
+        for (int i = 0; i < numPerProduct; ++i) {
             string side = (i % 2 == 0) ? "BUY" : "SELL";
             // generate a 12 digit random inquiry id with number and letters
             string inquiryId = GenerateRandomId(12);